@@ -0,0 +1,194 @@
+//
+//  attente.c
+//  cruesli
+//
+
+/*!
+    How the nodes wait for work when the master has none to give them.
+    
+    The request for work tells the master how long it may hold it, until some work comes in: the node
+    gets it within milliseconds, without asking again and again. A master that doesn't hold requests
+    answers right away; the node then backs off for a random time, up to a delay that doubles while
+    there's no work, so that idle nodes cost neither CPU time nor requests.
+*/
+
+#include <stdlib.h>
+#include <time.h>
+
+#include <pthread.h>
+
+#include "safe_malloc.h"
+#include "util.h"
+#include "attente.h"
+
+
+/*!
+    \brief Creates the wait-for-work settings, disabled.
+    
+    \return The settings, to be freed with attente_detruire().
+*/
+csc_attente* attente_creer(void){
+    csc_attente* attente = safe_malloc(sizeof(csc_attente));
+    
+    attente->active = false;
+    attente->max_ms = 0;
+    attente->longpoll_ms = ATTENTE_LONGPOLL_MS;
+    attente->base_ms = ATTENTE_BASE_MS;
+    attente->plafond_ms = ATTENTE_PLAFOND_MS;
+    
+    pthread_mutex_init(&attente->verrou, NULL);
+    pthread_cond_init(&attente->reveil, NULL);
+    attente->arret = false;
+    
+    attente->nb_longpolls = 0;
+    attente->nb_sommeils = 0;
+    
+    return attente;
+}
+
+
+/*!
+    \brief Frees the wait-for-work settings.
+    
+    \param attente The settings.
+*/
+void attente_detruire(csc_attente* attente){
+    if(!attente)
+        return;
+    
+    pthread_cond_destroy(&attente->reveil);
+    pthread_mutex_destroy(&attente->verrou);
+    free(attente);
+}
+
+
+/*!
+    \brief Tells how long the master may hold the next request for work.
+    
+    \param attente The settings.
+    \param echeance When the node gives up waiting (see temps_monotone()); 0 if it never does.
+    \param delai_total_ms The timeout of the requests; the master must answer well before it.
+    \return The time, in milliseconds; 0 if the request should not be held.
+*/
+long attente_longpoll(csc_attente* attente, double echeance, long delai_total_ms){
+    long longpoll = attente->longpoll_ms;
+    long reste;
+    
+    if(delai_total_ms > 0 && longpoll > delai_total_ms/2)
+        longpoll = delai_total_ms/2;
+    
+    if(echeance > 0.0){
+        reste = (long)((echeance - temps_monotone())*1e3);
+        if(longpoll > reste)
+            longpoll = reste;
+    }
+    
+    return longpoll > 0 ? longpoll : 0;
+}
+
+
+/*!
+    \brief Counts a request for work that the master held.
+    
+    \param attente The settings.
+*/
+void attente_noter_longpoll(csc_attente* attente){
+    pthread_mutex_lock(&attente->verrou);
+    attente->nb_longpolls += 1;
+    pthread_mutex_unlock(&attente->verrou);
+}
+
+
+/*!
+    \brief Backs off before asking the master for work again: a random time, up to a delay doubling at each attempt.
+    
+    \param attente The settings.
+    \param tentative The number of times the node already backed off since there is no work.
+    \param echeance When the node gives up waiting (see temps_monotone()); 0 if it never does.
+    \return false if the node should stop waiting: it was interrupted, or the wait is over.
+*/
+bool attente_dormir(csc_attente* attente, unsigned tentative, double echeance){
+    double duree = attente->base_ms*1e-3;
+    double plafond = attente->plafond_ms*1e-3;
+    double fin;
+    struct timespec limite;
+    bool continuer;
+    
+    while(tentative-- && duree < plafond)
+        duree *= 2;
+    if(duree > plafond)
+        duree = plafond;
+    
+    // Full jitter: the nodes that ran out of work together don't all ask again together
+    duree *= aleatoire();
+    fin = temps_monotone() + duree;
+    if(echeance > 0.0 && fin > echeance)
+        fin = echeance;
+    
+    pthread_mutex_lock(&attente->verrou);
+    
+    attente->nb_sommeils += 1;
+    
+    while(!attente->arret && (duree = fin - temps_monotone()) > 0.0){
+        // pthread_cond_timedwait needs a deadline on the realtime clock
+        clock_gettime(CLOCK_REALTIME, &limite);
+        limite.tv_sec += (time_t)duree;
+        limite.tv_nsec += (long)((duree - (time_t)duree)*1e9);
+        if(limite.tv_nsec >= 1000000000L){
+            limite.tv_sec += 1;
+            limite.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&attente->reveil, &attente->verrou, &limite);
+    }
+    
+    continuer = !attente->arret;
+    
+    pthread_mutex_unlock(&attente->verrou);
+    
+    return continuer && !(echeance > 0.0 && temps_monotone() >= echeance);
+}
+
+
+/*!
+    \brief Tells whether a node should stop waiting for work.
+    
+    \param attente The settings.
+    \param echeance When the node gives up waiting (see temps_monotone()); 0 if it never does.
+    \return true if it was interrupted, or if the wait is over.
+*/
+bool attente_finie(csc_attente* attente, double echeance){
+    bool arret;
+    
+    pthread_mutex_lock(&attente->verrou);
+    arret = attente->arret;
+    pthread_mutex_unlock(&attente->verrou);
+    
+    return arret || (echeance > 0.0 && temps_monotone() >= echeance);
+}
+
+
+/*!
+    \brief Wakes up the nodes waiting for work, and has them give up.
+    
+    \note A request the master is holding is not cut short: the node gives up once it's answered.
+    
+    \param attente The settings.
+*/
+void attente_interrompre(csc_attente* attente){
+    pthread_mutex_lock(&attente->verrou);
+    attente->arret = true;
+    pthread_cond_broadcast(&attente->reveil);
+    pthread_mutex_unlock(&attente->verrou);
+}
+
+
+/*!
+    \brief Lets the nodes wait for work again, after attente_interrompre().
+    
+    \param attente The settings.
+*/
+void attente_rearmer(csc_attente* attente){
+    pthread_mutex_lock(&attente->verrou);
+    attente->arret = false;
+    pthread_mutex_unlock(&attente->verrou);
+}
@@ -0,0 +1,45 @@
+//
+//  attente.h
+//  cruesli
+//
+
+#ifndef attente_h
+#define attente_h
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include <pthread.h>
+
+// Defaults: a long poll the master may hold for a while, and an idle backoff that still picks up
+// new work quickly when the master can't hold requests
+#define ATTENTE_LONGPOLL_MS     20000
+#define ATTENTE_BASE_MS         50
+#define ATTENTE_PLAFOND_MS      2000
+
+// How the nodes wait for work when the master has none to give them
+typedef struct csc_attente {
+    bool active;                // Whether the nodes wait at all; otherwise CSC_NO_MORE_WORK is returned right away
+    long max_ms;                // How long a node waits before giving up; 0: until interrompre_attente_travail()
+    long longpoll_ms;           // How long the master may hold a request for work; 0: no long polls
+    long base_ms;               // Idle backoff when the master doesn't hold the requests; doubled while there's no work
+    long plafond_ms;            // Cap of the backoff
+    
+    pthread_mutex_t verrou;     // Protects everything below
+    pthread_cond_t reveil;
+    bool arret;                 // The nodes should stop waiting
+    
+    size_t nb_longpolls;        // Requests the master held until it had work, or until the end of the wait
+    size_t nb_sommeils;         // Times a node backed off
+} csc_attente;
+
+csc_attente* attente_creer(void);
+void attente_detruire(csc_attente* attente);
+long attente_longpoll(csc_attente* attente, double echeance, long delai_total_ms);
+void attente_noter_longpoll(csc_attente* attente);
+bool attente_dormir(csc_attente* attente, unsigned tentative, double echeance);
+bool attente_finie(csc_attente* attente, double echeance);
+void attente_interrompre(csc_attente* attente);
+void attente_rearmer(csc_attente* attente);
+
+#endif /* attente_h */
@@ -0,0 +1,885 @@
+//
+//  cbor.c
+//  cruesli
+//
+
+/*!
+    A minimal CBOR (RFC 8949) codec, used as a binary alternative to JSON on the wire.
+    Numbers travel in the native width of the Cascada variables they come from or go to.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <cjson/cJSON.h>
+
+#include "safe_malloc.h"
+#include "varstructs.h"
+#include "tableaux.h"
+#include "cbor.h"
+
+#define CBOR_INFO_INDEFINI 31
+#define CBOR_STOP 0xff
+
+// The tags of the typed arrays (RFC 8746): 0b010fsell, f float, s signed, e little-endian, ll the width
+#define CBOR_ETIQUETTE_TABLEAUX      64
+#define CBOR_ETIQUETTE_TABLEAUX_FIN  87
+#define CBOR_TABLEAU_FLOTTANT        0x10
+#define CBOR_TABLEAU_SIGNE           0x08
+#define CBOR_TABLEAU_PETIT_BOUTISTE  0x04
+
+// Deeper documents are refused when converted to JSON
+#define CBOR_PROFONDEUR_MAX 64
+
+
+/*!
+    \brief Initializes an empty output buffer.
+    
+    \param tampon The buffer.
+*/
+void cbor_tampon_init(cbor_tampon* tampon){
+    tampon->ptr = NULL;
+    tampon->taille = 0;
+    tampon->capacite = 0;
+}
+
+
+/*!
+    \brief Frees an output buffer.
+    
+    \param tampon The buffer.
+*/
+void cbor_tampon_liberer(cbor_tampon* tampon){
+    free(tampon->ptr);
+    cbor_tampon_init(tampon);
+}
+
+
+/*!
+    \brief Makes room for bytes at the end of the buffer.
+    
+    \param tampon The buffer.
+    \param taille The number of bytes.
+    \return Where the bytes should be written; they belong to the buffer once its size is increased.
+*/
+static uint8_t* cbor_reserver(cbor_tampon* tampon, size_t taille){
+    uint8_t* nouveau = NULL;
+    size_t capacite = tampon->capacite ? tampon->capacite : 64;
+    
+    if(tampon->taille + taille > tampon->capacite){
+        while(tampon->taille + taille > capacite)
+            capacite *= 2;
+        nouveau = realloc(tampon->ptr, capacite);
+        if(!nouveau)
+            die("Erreur d'allocation\n");
+        tampon->ptr = nouveau;
+        tampon->capacite = capacite;
+    }
+    
+    return tampon->ptr + tampon->taille;
+}
+
+
+/*!
+    \brief Appends raw bytes to the buffer.
+    
+    \param tampon The buffer.
+    \param data The bytes.
+    \param taille The number of bytes.
+*/
+void cbor_ecrire_brut(cbor_tampon* tampon, const void* data, size_t taille){
+    memcpy(cbor_reserver(tampon, taille), data, taille);
+    tampon->taille += taille;
+}
+
+
+/*!
+    \brief Writes the head of a data item: its major type and its argument, in the shortest form.
+    
+    \param tampon The buffer.
+    \param majeur The major type (CBOR_...).
+    \param valeur The argument (value, length or number of elements).
+*/
+void cbor_ecrire_entete(cbor_tampon* tampon, uint8_t majeur, uint64_t valeur){
+    uint8_t octets[9];
+    size_t n = 0;
+    int i;
+    
+    if(valeur < 24){
+        octets[n++] = (uint8_t)(majeur << 5 | valeur);
+    } else if(valeur <= UINT8_MAX){
+        octets[n++] = (uint8_t)(majeur << 5 | 24);
+        octets[n++] = (uint8_t)valeur;
+    } else if(valeur <= UINT16_MAX){
+        octets[n++] = (uint8_t)(majeur << 5 | 25);
+        for(i = 1; i >= 0; i--)
+            octets[n++] = (uint8_t)(valeur >> (8*i));
+    } else if(valeur <= UINT32_MAX){
+        octets[n++] = (uint8_t)(majeur << 5 | 26);
+        for(i = 3; i >= 0; i--)
+            octets[n++] = (uint8_t)(valeur >> (8*i));
+    } else {
+        octets[n++] = (uint8_t)(majeur << 5 | 27);
+        for(i = 7; i >= 0; i--)
+            octets[n++] = (uint8_t)(valeur >> (8*i));
+    }
+    
+    cbor_ecrire_brut(tampon, octets, n);
+}
+
+
+/*!
+    \brief Writes a text string.
+    
+    \param tampon The buffer.
+    \param texte The NUL-terminated string.
+*/
+void cbor_ecrire_texte(cbor_tampon* tampon, const char* texte){
+    size_t longueur = strlen(texte);
+    
+    cbor_ecrire_entete(tampon, CBOR_TEXTE, longueur);
+    cbor_ecrire_brut(tampon, texte, longueur);
+}
+
+
+/*!
+    \brief Writes a signed integer.
+    
+    \param tampon The buffer.
+    \param valeur The integer.
+*/
+void cbor_ecrire_entier(cbor_tampon* tampon, int64_t valeur){
+    if(valeur >= 0)
+        cbor_ecrire_entete(tampon, CBOR_NATUREL, (uint64_t)valeur);
+    else
+        cbor_ecrire_entete(tampon, CBOR_NEGATIF, (uint64_t)(-1 - valeur));
+}
+
+
+/*!
+    \brief Writes a single precision float, as is.
+    
+    \param tampon The buffer.
+    \param valeur The float.
+*/
+void cbor_ecrire_float(cbor_tampon* tampon, float valeur){
+    uint8_t octets[5];
+    uint32_t bits;
+    
+    memcpy(&bits, &valeur, sizeof(bits));
+    octets[0] = CBOR_SIMPLE << 5 | 26;
+    for(int i = 0; i < 4; i++)
+        octets[1 + i] = (uint8_t)(bits >> (8*(3 - i)));
+    
+    cbor_ecrire_brut(tampon, octets, sizeof(octets));
+}
+
+
+/*!
+    \brief Writes a half precision float, as is.
+    
+    \param tampon The buffer.
+    \param demi The bits of the half float.
+*/
+void cbor_ecrire_demi(cbor_tampon* tampon, uint16_t demi){
+    uint8_t octets[3];
+    
+    octets[0] = CBOR_SIMPLE << 5 | 25;
+    octets[1] = (uint8_t)(demi >> 8);
+    octets[2] = (uint8_t)demi;
+    
+    cbor_ecrire_brut(tampon, octets, sizeof(octets));
+}
+
+
+/*!
+    \brief Writes a double precision float, as is.
+    
+    \param tampon The buffer.
+    \param valeur The double.
+*/
+void cbor_ecrire_double(cbor_tampon* tampon, double valeur){
+    uint8_t octets[9];
+    uint64_t bits;
+    
+    memcpy(&bits, &valeur, sizeof(bits));
+    octets[0] = CBOR_SIMPLE << 5 | 27;
+    for(int i = 0; i < 8; i++)
+        octets[1 + i] = (uint8_t)(bits >> (8*(7 - i)));
+    
+    cbor_ecrire_brut(tampon, octets, sizeof(octets));
+}
+
+
+/*!
+    \brief Gives the tag of the typed arrays of a type, little-endian.
+    
+    \param type The type of the elements, as they are packed (see vartype_paquet()).
+    \return The tag, or 0 if there is none for that type.
+*/
+static uint64_t cbor_etiquette_tableau(csc_var_type type){
+    switch (VARTYPE_BASE(type)) {
+        case VARTYPE_U8:     return CBOR_ETIQUETTE_TABLEAUX;
+        case VARTYPE_U16:    return CBOR_ETIQUETTE_TABLEAUX | CBOR_TABLEAU_PETIT_BOUTISTE | 1;
+        case VARTYPE_I8:     return CBOR_ETIQUETTE_TABLEAUX | CBOR_TABLEAU_SIGNE;
+        case VARTYPE_I16:    return CBOR_ETIQUETTE_TABLEAUX | CBOR_TABLEAU_SIGNE | CBOR_TABLEAU_PETIT_BOUTISTE | 1;
+        case VARTYPE_FP16:   return CBOR_ETIQUETTE_TABLEAUX | CBOR_TABLEAU_FLOTTANT | CBOR_TABLEAU_PETIT_BOUTISTE;
+        case VARTYPE_U32:    return CBOR_ETIQUETTE_TABLEAUX | CBOR_TABLEAU_PETIT_BOUTISTE | 2;
+        case VARTYPE_U64:    return CBOR_ETIQUETTE_TABLEAUX | CBOR_TABLEAU_PETIT_BOUTISTE | 3;
+        case VARTYPE_I32:    return CBOR_ETIQUETTE_TABLEAUX | CBOR_TABLEAU_SIGNE | CBOR_TABLEAU_PETIT_BOUTISTE | 2;
+        case VARTYPE_I64:    return CBOR_ETIQUETTE_TABLEAUX | CBOR_TABLEAU_SIGNE | CBOR_TABLEAU_PETIT_BOUTISTE | 3;
+        case VARTYPE_FLOAT:  return CBOR_ETIQUETTE_TABLEAUX | CBOR_TABLEAU_FLOTTANT | CBOR_TABLEAU_PETIT_BOUTISTE | 1;
+        case VARTYPE_DOUBLE: return CBOR_ETIQUETTE_TABLEAUX | CBOR_TABLEAU_FLOTTANT | CBOR_TABLEAU_PETIT_BOUTISTE | 2;
+        default:             return 0;
+    }
+}
+
+
+/*!
+    \brief Gives the type of the elements of the typed arrays of a tag.
+    
+    \param etiquette The tag.
+    \param type Where the type of the elements is written.
+    \param petit_boutiste Where is written whether the elements are little-endian.
+    \return false if the tag is not that of a typed array we can read.
+*/
+static bool cbor_type_tableau(uint64_t etiquette, csc_var_type* type, bool* petit_boutiste){
+    unsigned largeur = etiquette & 3;
+    
+    if(etiquette < CBOR_ETIQUETTE_TABLEAUX || etiquette > CBOR_ETIQUETTE_TABLEAUX_FIN)
+        return false;
+    
+    // Tag 68 is the "clamped" uint8, which reads like any uint8
+    *petit_boutiste = (etiquette & CBOR_TABLEAU_PETIT_BOUTISTE) != 0;
+    
+    if(etiquette & CBOR_TABLEAU_FLOTTANT){
+        if(largeur == 0)
+            *type = VARTYPE_FP16;
+        else if(largeur == 1)
+            *type = VARTYPE_FLOAT;
+        else if(largeur == 2)
+            *type = VARTYPE_DOUBLE;
+        else
+            return false;
+    } else if(etiquette & CBOR_TABLEAU_SIGNE){
+        if(largeur == 0)
+            *type = VARTYPE_I8;
+        else if(largeur == 1)
+            *type = VARTYPE_I16;
+        else if(largeur == 2)
+            *type = VARTYPE_I32;
+        else if(largeur == 3)
+            *type = VARTYPE_I64;
+        else
+            return false;
+    } else {
+        if(largeur == 0)
+            *type = VARTYPE_U8;
+        else if(largeur == 1)
+            *type = VARTYPE_U16;
+        else if(largeur == 2)
+            *type = VARTYPE_U32;
+        else if(largeur == 3)
+            *type = VARTYPE_U64;
+        else
+            return false;
+    }
+    
+    return true;
+}
+
+
+/*!
+    \brief Writes the value of a cascada variable, in its native width.
+    
+    \param tampon The buffer.
+    \param var The variable; an array is written as a little-endian typed array (RFC 8746).
+    \return false if the type of the variable is unknown.
+*/
+bool cbor_ecrire_var(cbor_tampon* tampon, const csc_var* var){
+    csc_var_type paquet = vartype_paquet(var->type);
+    size_t taille;
+    
+    if(VARTYPE_EST_TABLEAU(var->type)){
+        taille = var->longueur*vartype_taille(paquet);
+        if(!cbor_etiquette_tableau(paquet))
+            return false;
+        cbor_ecrire_entete(tampon, CBOR_ETIQUETTE, cbor_etiquette_tableau(paquet));
+        cbor_ecrire_entete(tampon, CBOR_OCTETS, taille);
+        tableau_petit_boutiste(cbor_reserver(tampon, taille), var->value, var->type, var->longueur);
+        tampon->taille += taille;
+        return true;
+    }
+    
+    switch (var->type) {
+        case VARTYPE_U8:
+            cbor_ecrire_entete(tampon, CBOR_NATUREL, *((uint8_t*)(var->value)));
+            break;
+        case VARTYPE_U32:
+            cbor_ecrire_entete(tampon, CBOR_NATUREL, *((uint32_t*)(var->value)));
+            break;
+        case VARTYPE_U64:
+            cbor_ecrire_entete(tampon, CBOR_NATUREL, *((uint64_t*)(var->value)));
+            break;
+        case VARTYPE_I32:
+            cbor_ecrire_entier(tampon, *((int32_t*)(var->value)));
+            break;
+        case VARTYPE_I64:
+            cbor_ecrire_entier(tampon, *((int64_t*)(var->value)));
+            break;
+        case VARTYPE_FLOAT:
+            cbor_ecrire_float(tampon, *((float*)(var->value)));
+            break;
+        case VARTYPE_DOUBLE:
+            cbor_ecrire_double(tampon, *((double*)(var->value)));
+            break;
+        case VARTYPE_I8:
+            cbor_ecrire_entier(tampon, *((int8_t*)(var->value)));
+            break;
+        case VARTYPE_U16:
+            cbor_ecrire_entete(tampon, CBOR_NATUREL, *((uint16_t*)(var->value)));
+            break;
+        case VARTYPE_I16:
+            cbor_ecrire_entier(tampon, *((int16_t*)(var->value)));
+            break;
+        case VARTYPE_FP16:
+            cbor_ecrire_demi(tampon, *((uint16_t*)(var->value)));
+            break;
+        case VARTYPE_BF16:
+            // Exact: a bfloat16 is the upper half of a float
+            cbor_ecrire_float(tampon, bf16_vers_float(*((uint16_t*)(var->value))));
+            break;
+        default:
+            return false;
+    }
+    
+    return true;
+}
+
+
+/*!
+    \brief Writes a JSON value (used for the opaque values sent by the server, such as task ids).
+    
+    \param tampon The buffer.
+    \param json The JSON value.
+    \return false if the value can't be represented.
+*/
+bool cbor_ecrire_json(cbor_tampon* tampon, const cJSON* json){
+    cJSON* element = NULL;
+    
+    if(cJSON_IsString(json)){
+        cbor_ecrire_texte(tampon, json->valuestring);
+    } else if(cJSON_IsNumber(json)){
+        // Only a number in the range of an int64_t may be cast to one
+        if(json->valuedouble >= -9223372036854775808.0 && json->valuedouble < 9223372036854775808.0
+           && json->valuedouble == (double)(int64_t)json->valuedouble)
+            cbor_ecrire_entier(tampon, (int64_t)json->valuedouble);
+        else
+            cbor_ecrire_double(tampon, json->valuedouble);
+    } else if(cJSON_IsBool(json)){
+        cbor_ecrire_entete(tampon, CBOR_SIMPLE, cJSON_IsTrue(json) ? 21 : 20);
+    } else if(cJSON_IsArray(json)){
+        cbor_ecrire_entete(tampon, CBOR_TABLEAU, cJSON_GetArraySize(json));
+        cJSON_ArrayForEach(element, json){
+            if(!cbor_ecrire_json(tampon, element))
+                return false;
+        }
+    } else if(cJSON_IsObject(json)){
+        cbor_ecrire_entete(tampon, CBOR_MAP, cJSON_GetArraySize(json));
+        cJSON_ArrayForEach(element, json){
+            cbor_ecrire_texte(tampon, element->string);
+            if(!cbor_ecrire_json(tampon, element))
+                return false;
+        }
+    } else {
+        // null
+        cbor_ecrire_entete(tampon, CBOR_SIMPLE, 22);
+    }
+    
+    return true;
+}
+
+
+/*!
+    \brief Initializes a cursor at the beginning of an input buffer.
+    
+    \param curseur The cursor.
+    \param data The buffer.
+    \param taille The size of the buffer.
+*/
+void cbor_curseur_init(cbor_curseur* curseur, const void* data, size_t taille){
+    curseur->p = data;
+    curseur->fin = curseur->p + taille;
+}
+
+
+/*!
+    \brief Reads the head of a data item.
+    
+    \param curseur The cursor, moved past the head.
+    \param majeur Where the major type is written.
+    \param info Where the additional information is written.
+    \param valeur Where the argument is written.
+    \return false if the input is truncated or malformed.
+*/
+static bool cbor_lire_entete(cbor_curseur* curseur, uint8_t* majeur, uint8_t* info, uint64_t* valeur){
+    size_t n = 0;
+    
+    if(curseur->p >= curseur->fin)
+        return false;
+    
+    *majeur = *curseur->p >> 5;
+    *info = *curseur->p & 0x1f;
+    curseur->p += 1;
+    
+    if(*info < 24 || *info == CBOR_INFO_INDEFINI){
+        *valeur = *info;
+        return true;
+    }
+    
+    switch (*info) {
+        case 24: n = 1; break;
+        case 25: n = 2; break;
+        case 26: n = 4; break;
+        case 27: n = 8; break;
+        default: return false;
+    }
+    
+    if(curseur->fin - curseur->p < (ptrdiff_t)n)
+        return false;
+    
+    *valeur = 0;
+    for(size_t i = 0; i < n; i++)
+        *valeur = *valeur << 8 | curseur->p[i];
+    curseur->p += n;
+    
+    return true;
+}
+
+
+/*!
+    \brief Gives the major type of the next data item, without reading it.
+    
+    \param curseur The cursor.
+    \return The major type (CBOR_...), or -1 at the end of the input.
+*/
+int cbor_type(const cbor_curseur* curseur){
+    if(curseur->p >= curseur->fin)
+        return -1;
+    return *curseur->p >> 5;
+}
+
+
+/*!
+    \brief Enters an array or a map.
+    
+    \param curseur The cursor, moved to the first element.
+    \param majeur CBOR_TABLEAU or CBOR_MAP.
+    \param conteneur Where the state of the container is kept.
+    \return false if the next data item is not a container of that kind.
+*/
+bool cbor_ouvrir(cbor_curseur* curseur, uint8_t majeur, cbor_conteneur* conteneur){
+    uint8_t majeur_lu, info;
+    uint64_t valeur;
+    
+    if(!cbor_lire_entete(curseur, &majeur_lu, &info, &valeur) || majeur_lu != majeur)
+        return false;
+    
+    conteneur->indefini = (info == CBOR_INFO_INDEFINI);
+    conteneur->restants = valeur;
+    
+    return true;
+}
+
+
+/*!
+    \brief Tells whether there's another element in the container (for a map, another key/value pair).
+    
+    \param curseur The cursor, which must be between two elements.
+    \param conteneur The state of the container.
+    \return true if there's another element; false if the container is over, in which case the cursor leaves it.
+*/
+bool cbor_suivant(cbor_curseur* curseur, cbor_conteneur* conteneur){
+    if(conteneur->indefini){
+        if(curseur->p < curseur->fin && *curseur->p == CBOR_STOP){
+            curseur->p += 1;
+            return false;
+        }
+        return curseur->p < curseur->fin;
+    }
+    
+    if(!conteneur->restants)
+        return false;
+    conteneur->restants -= 1;
+    
+    return true;
+}
+
+
+/*!
+    \brief Reads a (definite length) text string, without copying it.
+    
+    \param curseur The cursor.
+    \param texte Where the address of the string in the input is written; it is NOT NUL-terminated.
+    \param longueur Where the length of the string is written.
+    \return false if the next data item is not a text string.
+*/
+bool cbor_lire_texte(cbor_curseur* curseur, const char** texte, size_t* longueur){
+    uint8_t majeur, info;
+    uint64_t valeur;
+    
+    if(!cbor_lire_entete(curseur, &majeur, &info, &valeur))
+        return false;
+    if(majeur != CBOR_TEXTE || info == CBOR_INFO_INDEFINI)
+        return false;
+    if((uint64_t)(curseur->fin - curseur->p) < valeur)
+        return false;
+    
+    *texte = (const char*)curseur->p;
+    *longueur = (size_t)valeur;
+    curseur->p += valeur;
+    
+    return true;
+}
+
+
+/*!
+    \brief Reads a number, keeping the width it was sent in.
+    
+    \param curseur The cursor.
+    \param nombre Where the number is written.
+    \return false if the next data item is not a number.
+*/
+bool cbor_lire_nombre(cbor_curseur* curseur, cbor_nombre* nombre){
+    uint8_t majeur, info;
+    uint64_t valeur;
+    uint32_t bits32;
+    float f;
+    
+    if(!cbor_lire_entete(curseur, &majeur, &info, &valeur))
+        return false;
+    
+    switch (majeur) {
+        case CBOR_NATUREL:
+            nombre->genre = CBOR_NB_NATUREL;
+            nombre->naturel = valeur;
+            nombre->entier = (int64_t)valeur;
+            nombre->flottant = (double)valeur;
+            return info != CBOR_INFO_INDEFINI;
+            
+        case CBOR_NEGATIF:
+            nombre->genre = CBOR_NB_NEGATIF;
+            // -1 - valeur: below INT64_MIN, it only fits in a double, and saturates the integers
+            if(valeur <= (uint64_t)INT64_MAX){
+                nombre->entier = -1 - (int64_t)valeur;
+                nombre->naturel = (uint64_t)nombre->entier;
+                nombre->flottant = (double)nombre->entier;
+            } else {
+                nombre->flottant = -1.0 - (double)valeur;
+                flottant_vers_entiers(nombre->flottant, &nombre->entier, &nombre->naturel);
+            }
+            return info != CBOR_INFO_INDEFINI;
+            
+        case CBOR_SIMPLE:
+            nombre->genre = CBOR_NB_FLOTTANT;
+            if(info == 25){
+                nombre->flottant = demi_vers_float((uint16_t)valeur);
+            } else if(info == 26){
+                bits32 = (uint32_t)valeur;
+                memcpy(&f, &bits32, sizeof(f));
+                nombre->flottant = f;
+            } else if(info == 27){
+                memcpy(&nombre->flottant, &valeur, sizeof(double));
+            } else {
+                return false;
+            }
+            flottant_vers_entiers(nombre->flottant, &nombre->entier, &nombre->naturel);
+            return true;
+            
+        default:
+            return false;
+    }
+}
+
+
+/*!
+    \brief Reads a typed array (RFC 8746) into an array variable, converting its elements to the type of the variable.
+    
+    \param curseur The cursor, on the tag.
+    \param var The variable.
+    \return false if the next data item is not a typed array we can read, of the length of the variable.
+*/
+static bool cbor_lire_tableau_type(cbor_curseur* curseur, csc_var* var){
+    uint8_t majeur, info;
+    uint64_t valeur;
+    csc_var_type type;
+    bool petit_boutiste;
+    
+    if(!cbor_lire_entete(curseur, &majeur, &info, &valeur) || !cbor_type_tableau(valeur, &type, &petit_boutiste))
+        return false;
+    
+    if(!cbor_lire_entete(curseur, &majeur, &info, &valeur) || majeur != CBOR_OCTETS || info == CBOR_INFO_INDEFINI)
+        return false;
+    if(valeur != var->longueur*vartype_taille(type) || (uint64_t)(curseur->fin - curseur->p) < valeur)
+        return false;
+    
+    if(!tableau_convertir(var->value, var->type, curseur->p, type, petit_boutiste, var->longueur))
+        return false;
+    curseur->p += valeur;
+    
+    return true;
+}
+
+
+/*!
+    \brief Reads a number straight into a cascada variable, converting it to the type of the variable.
+    
+    \param curseur The cursor.
+    \param var The variable; an array is read from a typed array (RFC 8746), or from an array of numbers,
+               of exactly its length.
+    \return false if the next data item is not a number (an array of the right length) or if the type of the variable is unknown.
+*/
+bool cbor_lire_var(cbor_curseur* curseur, csc_var* var){
+    cbor_nombre nombre;
+    cbor_conteneur tableau;
+    size_t taille = vartype_taille(var->type);
+    size_t i = 0;
+    
+    if(!VARTYPE_EST_TABLEAU(var->type)){
+        if(!cbor_lire_nombre(curseur, &nombre))
+            return false;
+        return vartype_affecter(var->value, var->type, nombre.entier, nombre.naturel, nombre.flottant);
+    }
+    
+    if(!taille)
+        return false;
+    if(cbor_type(curseur) == CBOR_ETIQUETTE)
+        return cbor_lire_tableau_type(curseur, var);
+    if(!cbor_ouvrir(curseur, CBOR_TABLEAU, &tableau))
+        return false;
+    
+    while(cbor_suivant(curseur, &tableau)){
+        if(i >= var->longueur || !cbor_lire_nombre(curseur, &nombre))
+            return false;
+        vartype_affecter((char*)var->value + i*taille, var->type, nombre.entier, nombre.naturel, nombre.flottant);
+        i++;
+    }
+    
+    return i == var->longueur;
+}
+
+
+/*!
+    \brief Skips a whole data item.
+    
+    \param curseur The cursor.
+    \param profondeur The current nesting depth.
+    \return false if the input is truncated or malformed.
+*/
+static bool cbor_sauter_rec(cbor_curseur* curseur, int profondeur){
+    uint8_t majeur, info;
+    uint64_t valeur;
+    cbor_conteneur conteneur;
+    
+    if(profondeur > CBOR_PROFONDEUR_MAX || !cbor_lire_entete(curseur, &majeur, &info, &valeur))
+        return false;
+    
+    switch (majeur) {
+        case CBOR_NATUREL:
+        case CBOR_NEGATIF:
+            return info != CBOR_INFO_INDEFINI;
+            
+        case CBOR_OCTETS:
+        case CBOR_TEXTE:
+            if(info == CBOR_INFO_INDEFINI){
+                // Chunks, up to the stop code
+                while(curseur->p < curseur->fin && *curseur->p != CBOR_STOP){
+                    if(!cbor_sauter_rec(curseur, profondeur + 1))
+                        return false;
+                }
+                if(curseur->p >= curseur->fin)
+                    return false;
+                curseur->p += 1;
+                return true;
+            }
+            if((uint64_t)(curseur->fin - curseur->p) < valeur)
+                return false;
+            curseur->p += valeur;
+            return true;
+            
+        case CBOR_TABLEAU:
+        case CBOR_MAP:
+            conteneur.indefini = (info == CBOR_INFO_INDEFINI);
+            conteneur.restants = valeur;
+            while(cbor_suivant(curseur, &conteneur)){
+                if(!cbor_sauter_rec(curseur, profondeur + 1))
+                    return false;
+                if(majeur == CBOR_MAP && !cbor_sauter_rec(curseur, profondeur + 1))
+                    return false;
+            }
+            return true;
+            
+        case CBOR_ETIQUETTE:
+            return cbor_sauter_rec(curseur, profondeur + 1);
+            
+        default:
+            // Simple values and floats: the head is all there is
+            return info != CBOR_INFO_INDEFINI;
+    }
+}
+
+
+/*!
+    \brief Skips a whole data item.
+    
+    \param curseur The cursor.
+    \return false if the input is truncated, malformed or nested too deeply.
+*/
+bool cbor_sauter(cbor_curseur* curseur){
+    return cbor_sauter_rec(curseur, 0);
+}
+
+
+/*!
+    \brief Searches a key in a map.
+    
+    \param map A cursor on the map (it is not moved).
+    \param cle The key.
+    \param valeur Where a cursor on the associated value is written.
+    \return true if the key was found.
+*/
+bool cbor_trouver(cbor_curseur map, const char* cle, cbor_curseur* valeur){
+    cbor_conteneur conteneur;
+    const char* texte;
+    size_t longueur;
+    size_t longueur_cle = strlen(cle);
+    
+    if(!cbor_ouvrir(&map, CBOR_MAP, &conteneur))
+        return false;
+    
+    while(cbor_suivant(&map, &conteneur)){
+        if(!cbor_lire_texte(&map, &texte, &longueur))
+            return false;
+        if(longueur == longueur_cle && !memcmp(texte, cle, longueur)){
+            *valeur = map;
+            return true;
+        }
+        if(!cbor_sauter(&map))
+            return false;
+    }
+    
+    return false;
+}
+
+
+/*!
+    \brief Converts a data item to JSON, for the messages which content is not on the hot path.
+    
+    \param curseur The cursor.
+    \param profondeur The current nesting depth.
+    \return The JSON value, or NULL if the input is malformed or can't be converted.
+*/
+static cJSON* cbor_vers_json_rec(cbor_curseur* curseur, int profondeur){
+    cbor_conteneur conteneur;
+    cbor_nombre nombre;
+    uint8_t majeur, info;
+    uint64_t valeur;
+    const char* texte;
+    size_t longueur;
+    char* copie = NULL;
+    cJSON* json = NULL;
+    cJSON* element = NULL;
+    
+    if(profondeur > CBOR_PROFONDEUR_MAX || curseur->p >= curseur->fin)
+        return NULL;
+    
+    majeur = *curseur->p >> 5;
+    info = *curseur->p & 0x1f;
+    
+    switch (majeur) {
+        case CBOR_NATUREL:
+        case CBOR_NEGATIF:
+            if(!cbor_lire_nombre(curseur, &nombre))
+                return NULL;
+            return cJSON_CreateNumber(nombre.genre == CBOR_NB_NATUREL ? (double)nombre.naturel : (double)nombre.entier);
+            
+        case CBOR_TEXTE:
+            if(!cbor_lire_texte(curseur, &texte, &longueur))
+                return NULL;
+            copie = safe_malloc(longueur + 1);
+            memcpy(copie, texte, longueur);
+            copie[longueur] = '\0';
+            json = cJSON_CreateString(copie);
+            free(copie);
+            return json;
+            
+        case CBOR_TABLEAU:
+        case CBOR_MAP:
+            if(!cbor_ouvrir(curseur, majeur, &conteneur))
+                return NULL;
+            json = (majeur == CBOR_MAP) ? cJSON_CreateObject() : cJSON_CreateArray();
+            if(!json)
+                return NULL;
+            while(cbor_suivant(curseur, &conteneur)){
+                copie = NULL;
+                if(majeur == CBOR_MAP){
+                    if(!cbor_lire_texte(curseur, &texte, &longueur))
+                        goto erreur;
+                    copie = safe_malloc(longueur + 1);
+                    memcpy(copie, texte, longueur);
+                    copie[longueur] = '\0';
+                }
+                element = cbor_vers_json_rec(curseur, profondeur + 1);
+                if(!element){
+                    free(copie);
+                    goto erreur;
+                }
+                if(copie)
+                    cJSON_AddItemToObject(json, copie, element);
+                else
+                    cJSON_AddItemToArray(json, element);
+                free(copie);
+            }
+            return json;
+            
+        case CBOR_ETIQUETTE:
+            // Tags are ignored: only the tagged value matters here
+            if(!cbor_lire_entete(curseur, &majeur, &info, &valeur))
+                return NULL;
+            return cbor_vers_json_rec(curseur, profondeur + 1);
+            
+        case CBOR_SIMPLE:
+            if(info >= 25 && info <= 27){
+                if(!cbor_lire_nombre(curseur, &nombre))
+                    return NULL;
+                return cJSON_CreateNumber(nombre.flottant);
+            }
+            if(!cbor_lire_entete(curseur, &majeur, &info, &valeur))
+                return NULL;
+            if(valeur == 20 || valeur == 21)
+                return cJSON_CreateBool(valeur == 21);
+            if(valeur == 22 || valeur == 23)
+                return cJSON_CreateNull();
+            return NULL;
+            
+        default:
+            return NULL;
+    }
+    
+erreur:
+    cJSON_Delete(json);
+    return NULL;
+}
+
+
+/*!
+    \brief Converts a data item to JSON, for the messages which content is not on the hot path.
+    
+    \param curseur The cursor.
+    \return The JSON value (to be cJSON_Delete'd), or NULL if the input is malformed or can't be converted.
+*/
+cJSON* cbor_vers_json(cbor_curseur* curseur){
+    return cbor_vers_json_rec(curseur, 0);
+}
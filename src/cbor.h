@@ -0,0 +1,76 @@
+//
+//  cbor.h
+//  cruesli
+//
+
+#ifndef cbor_h
+#define cbor_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <cjson/cJSON.h>
+
+#include "varstructs.h"
+
+#define CBOR_NATUREL   0    /* unsigned integer */
+#define CBOR_NEGATIF   1    /* negative integer */
+#define CBOR_OCTETS    2    /* byte string */
+#define CBOR_TEXTE     3    /* text string */
+#define CBOR_TABLEAU   4    /* array */
+#define CBOR_MAP       5    /* map */
+#define CBOR_ETIQUETTE 6    /* tag */
+#define CBOR_SIMPLE    7    /* floats and simple values */
+
+// A growable output buffer
+typedef struct cbor_tampon {
+    uint8_t* ptr;
+    size_t taille;
+    size_t capacite;
+} cbor_tampon;
+
+// A position in an input buffer
+typedef struct cbor_curseur {
+    const uint8_t* p;
+    const uint8_t* fin;
+} cbor_curseur;
+
+// The elements left in an array or a map being read
+typedef struct cbor_conteneur {
+    uint64_t restants;
+    bool indefini;
+} cbor_conteneur;
+
+// A number read from the input, in the width it was sent
+typedef struct cbor_nombre {
+    enum { CBOR_NB_NATUREL, CBOR_NB_NEGATIF, CBOR_NB_FLOTTANT } genre;
+    uint64_t naturel;
+    int64_t entier;
+    double flottant;
+} cbor_nombre;
+
+void cbor_tampon_init(cbor_tampon* tampon);
+void cbor_tampon_liberer(cbor_tampon* tampon);
+void cbor_ecrire_brut(cbor_tampon* tampon, const void* data, size_t taille);
+void cbor_ecrire_entete(cbor_tampon* tampon, uint8_t majeur, uint64_t valeur);
+void cbor_ecrire_texte(cbor_tampon* tampon, const char* texte);
+void cbor_ecrire_entier(cbor_tampon* tampon, int64_t valeur);
+void cbor_ecrire_float(cbor_tampon* tampon, float valeur);
+void cbor_ecrire_demi(cbor_tampon* tampon, uint16_t demi);
+void cbor_ecrire_double(cbor_tampon* tampon, double valeur);
+bool cbor_ecrire_var(cbor_tampon* tampon, const csc_var* var);
+bool cbor_ecrire_json(cbor_tampon* tampon, const cJSON* json);
+
+void cbor_curseur_init(cbor_curseur* curseur, const void* data, size_t taille);
+int cbor_type(const cbor_curseur* curseur);
+bool cbor_ouvrir(cbor_curseur* curseur, uint8_t majeur, cbor_conteneur* conteneur);
+bool cbor_suivant(cbor_curseur* curseur, cbor_conteneur* conteneur);
+bool cbor_lire_texte(cbor_curseur* curseur, const char** texte, size_t* longueur);
+bool cbor_lire_nombre(cbor_curseur* curseur, cbor_nombre* nombre);
+bool cbor_lire_var(cbor_curseur* curseur, csc_var* var);
+bool cbor_sauter(cbor_curseur* curseur);
+bool cbor_trouver(cbor_curseur map, const char* cle, cbor_curseur* valeur);
+cJSON* cbor_vers_json(cbor_curseur* curseur);
+
+#endif /* cbor_h */
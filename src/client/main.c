@@ -13,23 +13,26 @@
 #include <time.h>
 #include <limits.h>
 
-#include <pthread.h>
-
 #include <cruesli/cruesli.h>
 
-#include "safe_malloc.h"
-
 
-#define NB_TH 8
+// The variables of a task: each node works on its own instance
+typedef struct point {
+    float X;
+    float Y;
+    float Z;
+    float mE;
+} point;
 
+static const csc_champ champs_point[] = {
+    CSC_CHAMP(point, X, VARTYPE_FLOAT),
+    CSC_CHAMP(point, Y, VARTYPE_FLOAT),
+    CSC_CHAMP(point, Z, VARTYPE_FLOAT),
+    CSC_CHAMP(point, mE, VARTYPE_FLOAT),
+};
 
-typedef struct csc_th_spawn_info {
-    csc_node_info* nodeinfo;
-    csc_master_info* masterinfo;
-    pthread_t threadid;
-} csc_th_spawn_info;
+int calcul(csc_node_info* noeud, point* p, void* contexte);
 
-void th_calcul(csc_th_spawn_info* inf);
 
 int main(int argc, const char * argv[]) {
     
@@ -56,18 +59,28 @@ int main(int argc, const char * argv[]) {
     printf("Connecting to the cascada master server at %s...\n", master_server_address);
 
     info = init_cruesli(master_server_address, master_server_pwd);
+    // CBOR if the server speaks it, JSON otherwise
+    configurer_format(&info, CSC_FORMAT_CBOR);
     int res = connecter_cascada(&info, hostname);
     if(res != CSC_NO_ERROR){
         fprintf(stderr, "An error happenned during connection\n");
         exit(2);
     }
 
-    res = allouer_noeuds(&info, NB_TH);
+    // As many nodes as we have CPUs to keep busy
+    res = allouer_noeuds(&info, cpus_disponibles());
     if(res != CSC_NO_ERROR){
         fprintf(stderr, "An error happenned during node allocation\n");
         exit(2);
     }
 
+    // All the nodes' requests will be driven by a single network thread
+    demarrer_moteur_reseau(&info);
+    // The tasks are very short: we fetch them by batches of up to 64
+    configurer_lots(&info, 1, 64, 8);
+    // ...and send their results together, at least every 20ms
+    configurer_soumission_groupee(&info, 256, 64*1024, 20);
+
 
 
     printf("My name is %s (code %s)\n", info.nom, info.authcode);
@@ -77,71 +90,40 @@ int main(int argc, const char * argv[]) {
     //printf("Output scheme:\n");
     //afficher_liste(info.sch_out);
     
-    /*** SPAWN ***/
-    printf("I will now spawn the %d threads...\n", NB_TH);
+    /*** RUN ***/
+    csc_execution execution = init_execution((csc_calcul)calcul, NULL);
+    execution.champs = champs_point;
+    execution.nb_champs = sizeof(champs_point)/sizeof(champs_point[0]);
+    execution.taille_instance = sizeof(point);
     
-    csc_th_spawn_info** th_info_list = safe_malloc(sizeof(csc_th_spawn_info*)*NB_TH);
-    csc_node_info* spawner = info.nodes;
+    csc_bilan bilan;
     
-    int i = 0;
-    while(spawner){
-        th_info_list[i] = safe_malloc(sizeof(csc_th_spawn_info));
-        th_info_list[i]->masterinfo = &info;
-        th_info_list[i]->nodeinfo   = spawner;
-        
-        pthread_create(&(th_info_list[i]->threadid), NULL, (void*)th_calcul, th_info_list[i]);
-        spawner = spawner->next;
-        i += 1;
-    }
+    // Each node gets a core of its own, on one NUMA node after the other
+    placer_noeuds(&info, CSC_PLACEMENT_COMPACT, false);
+    afficher_placement(&info);
     
-    for(int i = 0; i < NB_TH; i++)
-        pthread_join(th_info_list[i]->threadid, NULL);
+    printf("I will now run the nodes...\n");
+    res = executer_cascada(&info, &execution, &bilan);
+    
+    if(bilan.interrompu)
+        printf("Interrupted, stopping\n");
+    else if(res == CSC_NO_ERROR)
+        printf("No more work \\°_°\\ \n");
+    else
+        fprintf(stderr, "The run stopped on error %d\n", res);
+    printf("%zu nodes computed %zu tasks (%zu results lost)\n", bilan.noeuds, bilan.taches, bilan.perdues);
     
     
     deconnecter_cascada(&info);
     
     cleanup_cruesli(&info);
     
-    return 0;
+    return res == CSC_NO_ERROR ? 0 : 3;
 }
 
 
-void th_calcul(csc_th_spawn_info* inf){
-    
-    
-    csc_master_info* masterinfo = inf->masterinfo;
-    csc_node_info*   monnoeud   = inf->nodeinfo;
-    
-    float X = 0;
-    float Y = 0;
-    float Z = 0;
-    float d = 0;
-    
-    int code = 0;
-    
-    printf("Thread succesfully spawned !\n");
-    
-    ajouter_variable(VARTYPE_FLOAT, "X", &X, monnoeud->localvars);
-    ajouter_variable(VARTYPE_FLOAT, "Y", &Y, monnoeud->localvars);
-    ajouter_variable(VARTYPE_FLOAT, "Z", &Z, monnoeud->localvars);
-    ajouter_variable(VARTYPE_FLOAT, "mE", &d, monnoeud->localvars);
-
-    while(!code){
-        code = allouer_travail(masterinfo, monnoeud);
-        if(!code){
-            d = (-1)*(sqrtf(X*X + Y*Y + Z*Z)+1);
-            code = soumettre_travail(masterinfo, monnoeud);
-            if(code)
-                printf("Submission failed !\n");
-        } else {
-            if(code == 7)
-                printf("No more work \\°_°\\ \n");
-            else
-                printf("Couldn't allocate work ! (nothing to do with malloc...)\n");
-        }
-        
-    }
-
-    return;
+int calcul(csc_node_info* noeud, point* p, void* contexte){
+    p->mE = (-1)*(sqrtf(p->X*p->X + p->Y*p->Y + p->Z*p->Z)+1);
     
+    return 0;
 }
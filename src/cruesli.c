@@ -10,6 +10,7 @@
 #include <stdlib.h>
 
 #include <pthread.h>
+#include <signal.h>
 
 #include <curl/curl.h>
 #include <cjson/cJSON.h>
@@ -17,20 +18,319 @@
 #include "safe_malloc.h"
 #include "util.h"
 #include "www.h"
+#include "cbor.h"
+#include "reprise.h"
+#include "serveurs.h"
+#include "attente.h"
+#include "jsonflux.h"
+#include "moteur.h"
+#include "taches.h"
+#include "soumission.h"
 #include "vartable.h"
+#include "plan.h"
 #include "varstructs.h"
 #include "entities.h"
 #include "cscerrs.h"
 #include "cruesli.h"
 
 // Global NETwork LOCK for curl
+// Only guards the master handler (control plane); each node owns its handler.
 static pthread_mutex_t g_net_lock = PTHREAD_MUTEX_INITIALIZER;
 
+// Guards the lists of the nodes: nodes may be added and removed while the others work
+static pthread_rwlock_t g_noeuds_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+static int recuperer_recharge(csc_master_info* info, csc_node_info* mon_noeud);
+static void arreter_soumission_groupee(csc_master_info* info);
+struct csc_flux_soumission;
+static void reprendre_soumission(struct csc_flux_soumission* flux);
+
+
+/*!
+    \brief Creates a curl handle suitable for being used from any thread.
+    
+    \return A new CURL handle.
+*/
+static CURL* nouveau_handler(void){
+    CURL* handler = curl_easy_init();
+    
+    if(!handler){
+        die("Netcode initialization error");
+    }
+    
+    // Signals can't be used for timeouts in a multithreaded program
+    curl_easy_setopt(handler, CURLOPT_NOSIGNAL, 1L);
+    
+    return handler;
+}
+
+
+/*!
+    \brief Gets an attempt at the request configured on handler ready: asks the circuit breaker, and points the
+           handler to the master server that should answer first.
+    
+    \param info The master info.
+    \param handler The handler doing the request.
+    \param api The endpoint called (API_...).
+    \param evite The master server the previous attempt failed on, or NULL.
+    \return The master server the attempt goes to, or NULL if the circuit breaker shed it. Its outcome must
+            be given to conclure_requete().
+*/
+static csc_serveur* engager_requete(csc_master_info* info, CURL* handler, int api, const csc_serveur* evite){
+    csc_serveur* serveur = NULL;
+    
+    if(!reprise_autoriser((csc_reprise*)info->reprise))
+        return NULL;
+    
+    serveur = serveurs_choisir((csc_serveurs*)info->serveurs, evite);
+    serveur_viser(serveur, handler, api);
+    reprise_appliquer_delais((csc_reprise*)info->reprise, handler);
+    
+    return serveur;
+}
+
+
+/*!
+    \brief Makes one attempt at the request configured on handler, through the network engine if it is running.
+    
+    \param info The master info.
+    \param handler The handler doing the request, after engager_requete().
+    \return The curl result of the transfer.
+*/
+static CURLcode tenter_requete(csc_master_info* info, CURL* handler){
+    if(info->moteur)
+        return moteur_executer((csc_moteur*)info->moteur, handler);
+    return curl_easy_perform(handler);
+}
+
+
+/*!
+    \brief Posts the request configured on handler to the network engine.
+    
+    \note The attempt must have been got ready by engager_requete(), and its result must be given to
+           conclure_requete().
+    
+    \param info The master info; the network engine must be running.
+    \param handler The handler doing the request.
+    \return The request in flight.
+*/
+static csc_requete* poster_requete(csc_master_info* info, CURL* handler){
+    return moteur_poster((csc_moteur*)info->moteur, handler);
+}
+
+
+/*!
+    \brief Tells how an attempt ended, once it won't be retried.
+    
+    \param res The curl result of the attempt.
+    \param code_http The HTTP status of the answer; 0 if there was none.
+    \return 0 if the request went through, or an error code defined in cruesli.h.
+*/
+static int statut_requete(CURLcode res, long code_http){
+    // The body of a server error is an error page, not the master's answer
+    if(res == CURLE_OK && code_http >= 500)
+        return CSC_ERR_NONFATAL_HTTP;
+    return reprise_statut(res);
+}
+
+
+/*!
+    \brief Sees a request through once its first attempt is over: it's retried as long as the policy allows it,
+           on another master server if one is available.
+    
+    \param info The master info.
+    \param handler The handler doing the request.
+    \param ecriture Where the answer is received; emptied before each retry.
+    \param idempotent Whether the request can be handled twice by the server without harm.
+    \param api The endpoint called (API_...).
+    \param serveur The master server of the first attempt; NULL if the circuit breaker shed it.
+    \param res The curl result of the first attempt.
+    \param flux The body of the request when it is streamed, produced again before each retry; NULL otherwise.
+    \param retenue Whether the master may hold the request (a long poll): how long it took says nothing of its latency.
+    \return 0 if the request went through, or an error code defined in cruesli.h.
+*/
+static int conclure_requete(csc_master_info* info, CURL* handler, www_writestruct* ecriture, bool idempotent, int api, csc_serveur* serveur, CURLcode res, struct csc_flux_soumission* flux, bool retenue){
+    csc_reprise* reprise = (csc_reprise*)info->reprise;
+    csc_serveurs* serveurs = (csc_serveurs*)info->serveurs;
+    long code_http = 0;
+    unsigned tentative = 0;
+    bool succes = false;
+    
+    while(1){
+        if(serveur){
+            code_http = 0;
+            if(res == CURLE_OK)
+                curl_easy_getinfo(handler, CURLINFO_RESPONSE_CODE, &code_http);
+            succes = res == CURLE_OK && code_http < 500;
+            reprise_noter(reprise, succes);
+            serveurs_rendre(serveurs, serveur, handler, succes, !retenue);
+            if(!reprise_possible(handler, res, idempotent))
+                return statut_requete(res, code_http);
+        }
+        
+        // An attempt that was shed is always worth another go, once the breaker lets it through;
+        // one that failed is sent to another server right away, if there is one
+        if(!reprise_attendre(reprise, tentative++, serveur && serveurs_relais(serveurs, serveur)))
+            return serveur ? statut_requete(res, code_http) : CSC_ERR_NONFATAL_CIRCUIT_OPEN;
+        
+        serveur = engager_requete(info, handler, api, serveur);
+        if(serveur){
+            ecriture_vider(ecriture);
+            if(flux)
+                reprendre_soumission(flux);
+            res = tenter_requete(info, handler);
+        }
+    }
+}
+
+
+/*!
+    \brief Performs the request configured on handler, with the timeouts, retries and circuit breaker of the policy.
+    
+    \param info The master info.
+    \param handler The handler doing the request.
+    \param ecriture Where the answer is received.
+    \param idempotent Whether the request can be handled twice by the server without harm.
+    \param api The endpoint called (API_...).
+    \param retenue Whether the master may hold the request (a long poll).
+    \return 0 if the request went through, or an error code defined in cruesli.h.
+*/
+static int executer_requete(csc_master_info* info, CURL* handler, www_writestruct* ecriture, bool idempotent, int api, bool retenue){
+    csc_serveur* serveur = engager_requete(info, handler, api, NULL);
+    
+    return conclure_requete(info, handler, ecriture, idempotent, api, serveur, serveur ? tenter_requete(info, handler) : CURLE_OK, NULL, retenue);
+}
+
+
+/*!
+    \brief Advertises the encodings the answers can be compressed with.
+    
+    \param info The master info.
+    \param handler The handler of the request.
+*/
+static void annoncer_encodages(csc_master_info* info, CURL* handler){
+    if(info->compression == CSC_COMPRESSION_AUCUNE){
+        curl_easy_setopt(handler, CURLOPT_ACCEPT_ENCODING, NULL);
+        return;
+    }
+    
+    // Empty string: every encoding supported by curl is advertised
+    curl_easy_setopt(handler, CURLOPT_ACCEPT_ENCODING, "");
+}
+
+
+/*!
+    \brief Sets up a transfer for POSTing a document in the negotiated format, compressed if it's worth it.
+    
+    \param info The master info.
+    \param transfert The transfer.
+    \param url The complete URL, among the ones computed by init_cruesli().
+    \param corps The body of the request: either the send buffer of the transfer, or a buffer it takes ownership of.
+    \param taille The size of the body, in bytes.
+*/
+static void preparer_transfert(csc_master_info* info, www_transfert* transfert, char* corps, size_t taille){
+    transfert_preparer(transfert, (www_entetes*)info->entetes, corps, taille, info->format);
+    annoncer_encodages(info, transfert->handler);
+    
+    // Small bodies are not worth the CPU time
+    if(info->compression != CSC_COMPRESSION_AUCUNE && transfert->taille_corps >= info->seuil_compression)
+        transfert_compresser(transfert, info->compression);
+}
+
+
+/*!
+    \brief Lends the memory of a send buffer to a CBOR writer.
+    
+    \param sortie The send buffer.
+    \param tampon The CBOR buffer, which appends to what sortie holds.
+*/
+static void emprunter_tampon(www_writestruct* sortie, cbor_tampon* tampon){
+    tampon->ptr = (uint8_t*)sortie->ptr;
+    tampon->taille = sortie->size;
+    tampon->capacite = sortie->capacite;
+}
+
+
+/*!
+    \brief Gives the memory lent by emprunter_tampon() back to the send buffer.
+    
+    \param sortie The send buffer.
+    \param tampon The CBOR buffer.
+*/
+static void rendre_tampon(www_writestruct* sortie, cbor_tampon* tampon){
+    if(tampon->capacite != sortie->capacite)
+        sortie->agrandissements += 1;
+    sortie->ptr = (char*)tampon->ptr;
+    sortie->size = tampon->taille;
+    sortie->capacite = tampon->capacite;
+}
+
+
+/*!
+    \brief Computes the beginning shared by all the requests of a node: the master token and the node's id.
+    
+    \note Must be called once the format is negotiated and the node has its id.
+    
+    \param info The master info.
+    \param mon_noeud The node.
+*/
+static void preparer_noeud(csc_master_info* info, csc_node_info* mon_noeud){
+    www_writestruct prefixe = { .ptr = NULL, .size = 0, .capacite = 0 };
+    
+    if(info->format == CSC_FORMAT_CBOR){
+        cbor_tampon tampon;
+        emprunter_tampon(&prefixe, &tampon);
+        cbor_ecrire_texte(&tampon, "mastertoken");
+        cbor_ecrire_texte(&tampon, info->authcode);
+        mon_noeud->debut_nodeid = tampon.taille;
+        cbor_ecrire_texte(&tampon, "nodeid");
+        cbor_ecrire_texte(&tampon, mon_noeud->id);
+        rendre_tampon(&prefixe, &tampon);
+    } else {
+        // The opening brace is not part of it, so that the token can be left out
+        JSON_ECRIRE_LITTERAL(&prefixe, "\"mastertoken\":");
+        json_ecrire_texte(&prefixe, info->authcode);
+        JSON_ECRIRE_LITTERAL(&prefixe, ",");
+        mon_noeud->debut_nodeid = prefixe.size;
+        JSON_ECRIRE_LITTERAL(&prefixe, "\"nodeid\":");
+        json_ecrire_texte(&prefixe, mon_noeud->id);
+    }
+    
+    free(mon_noeud->prefixe);
+    mon_noeud->prefixe = prefixe.ptr;
+    mon_noeud->taille_prefixe = prefixe.size;
+}
+
+
+/*!
+    \brief Decodes an answer of the server into a JSON tree, whatever format it was sent in.
+    
+    \note Only for the answers which are not on the hot path: the others are decoded in place.
+    
+    \param handler The curl handle, after the request is done.
+    \param ecriture The body of the answer.
+    \return The JSON tree (to be cJSON_Delete'd), or NULL if the answer can't be decoded.
+*/
+static cJSON* analyser_reponse(CURL* handler, www_writestruct* ecriture){
+    cbor_curseur curseur;
+    
+    if(!ecriture->size)
+        return NULL;
+    
+    if(reponse_en_cbor(handler)){
+        cbor_curseur_init(&curseur, ecriture->ptr, ecriture->size);
+        return cbor_vers_json(&curseur);
+    }
+    
+    return cJSON_Parse(ecriture->ptr);
+}
+
 
 /*!
     \brief Initializes cruesli's data structures.
     
-    \param url_serveur The URL of the Cascada server.
+    \param url_serveur The URL of the Cascada server, or "unix:" followed by the path of the unix socket it listens on.
+                        Several master servers sharing the work can be given, separated by commas.
     \param mdp The password used to connect to the server.
     \return A csc_master_info struct containing the relevant data.
 */
@@ -47,18 +347,39 @@ csc_master_info init_cruesli(const char* url_serveur, const char* mdp){
     mdp_cpy = safe_malloc((strlen(mdp)+1)*sizeof(char));
     strcpy(mdp_cpy, mdp);
     
-    handler = curl_easy_init();
-    
-    if(!handler){
+    if(curl_global_init(CURL_GLOBAL_DEFAULT) != CURLE_OK){
         die("Netcode initialization error");
     }
     
     csc_master_info info;
+    
+    handler = nouveau_handler();
+    
     info.handler = handler;
+    info.moteur = NULL;
+    info.soumission = NULL;
+    
+    info.compression = CSC_COMPRESSION_AUCUNE;
+    info.seuil_compression = 0;
+    info.seuil_flux = 0;
+    
+    info.format_souhaite = CSC_FORMAT_JSON;
+    info.format = CSC_FORMAT_JSON;
+    
+    info.lot_min = 1;
+    info.lot_max = 1;
+    info.seuil_bas = 0;
+    info.vol_taches = false;
+    info.retrait_noeuds = false;
     info.server_base_url = url_cpy;
+    info.serveurs = serveurs_creer(url_cpy);
+    info.entetes = entetes_creer();
+    info.reprise = reprise_creer();
+    info.attente = attente_creer();
     info.mdp = mdp_cpy;
     info.authcode = NULL;
     info.nodes = NULL;
+    info.retires = NULL;
     info.nom = NULL;
     
     info.algo = NULL;
@@ -93,6 +414,25 @@ csc_node_info* trouver_noeud_par_id(const csc_master_info* info, const char* nod
     return NULL;
 }
 
+/*!
+    \brief Frees what a node uses to work; its id and the beginning of its requests are kept.
+    
+    \param noeud The node.
+*/
+static void liberer_noeud(csc_node_info* noeud){
+    detruire_liste(noeud->localvars);
+    plan_detruire((csc_plan*)noeud->plan);
+    detruire_file(noeud->taches);
+    detruire_tache(noeud->tache_courante);
+    curl_easy_cleanup((CURL*)noeud->handler);
+    
+    noeud->localvars = NULL;
+    noeud->plan = NULL;
+    noeud->taches = NULL;
+    noeud->tache_courante = NULL;
+    noeud->handler = NULL;
+}
+
 /*!
     \brief Cleans up the cruesli data structures (mosty a bunch of frees).
     \note Should be used AFTER disconnecting from the server.
@@ -100,124 +440,486 @@ csc_node_info* trouver_noeud_par_id(const csc_master_info* info, const char* nod
     \param info The master info.
 */
 void cleanup_cruesli(csc_master_info* info){
+    arreter_soumission_groupee(info);
+    arreter_moteur_reseau(info);
+    
     free(info->server_base_url);
+    serveurs_detruire((csc_serveurs*)info->serveurs);
+    entetes_detruire((www_entetes*)info->entetes);
+    reprise_detruire((csc_reprise*)info->reprise);
+    attente_detruire((csc_attente*)info->attente);
     free(info->mdp);
     free(info->nom);
     free(info->authcode);
     
     csc_node_info* noeud_courant = info->nodes;
     csc_node_info* suivant;
-    while(noeud_courant){
+    
+    // The tasks still queued may have been lent by any node: they are all freed before the nodes
+    for(noeud_courant = info->nodes; noeud_courant; noeud_courant = noeud_courant->next)
+        liberer_noeud(noeud_courant);
+    
+    for(noeud_courant = info->nodes; noeud_courant; noeud_courant = suivant){
+        suivant = noeud_courant->next;
+        free(noeud_courant->id);
+        free(noeud_courant->prefixe);
+        free(noeud_courant);
+    }
+    
+    // What's left of the nodes removed during the run
+    for(noeud_courant = info->retires; noeud_courant; noeud_courant = suivant){
         suivant = noeud_courant->next;
         free(noeud_courant->id);
-        detruire_liste(noeud_courant->localvars);
+        free(noeud_courant->prefixe);
         free(noeud_courant);
-        noeud_courant = suivant;
     }
     
     curl_easy_cleanup((CURL*)info->handler);
     
     detruire_liste(info->sch_in);
     detruire_liste(info->sch_out);
+    
+    curl_global_cleanup();
 }
 
 /*!
-    \brief Connects to the cascada server.
+    \brief Adds the counters of a receive buffer to the statistics.
+*/
+static void cumuler_reception(const www_writestruct* ecriture, size_t* pic, size_t* agrandissements){
+    if(ecriture->pic > *pic)
+        *pic = ecriture->pic;
+    *agrandissements += ecriture->agrandissements;
+}
+
+/*!
+    \brief Gives statistics about the buffers the answers of the server are received in.
+    
+    \note Each node keeps its receive buffers from one answer to the next: once they are large enough,
+           receiving an answer doesn't allocate anything. The figures are only accurate when the nodes are idle.
     
     \param info The master info.
-    \param nom_suggere The suggested name for our slave server, that the master server may or may not follow.
-    \return 0 if everything went well or an error code defined in cruesli.h.
-                    
+    \param pic Where the size of the largest answer received so far is written.
+    \param agrandissements Where the number of times a receive buffer had to grow is written.
 */
-int connecter_cascada(csc_master_info* info, char* nom_suggere){
-    // Authentificating on the cascada network
-    
-    int retcode = CSC_NO_ERROR;
-    char url[] = "/api/v1/register-master";
-    char* str = NULL;
-    struct curl_slist *headers = NULL;
-    www_writestruct writestruct = { .ptr = NULL, .size = 0};
-    char* url_complete = strconc(info->server_base_url, url);
+void statistiques_reception(const csc_master_info* info, size_t* pic, size_t* agrandissements){
+    csc_node_info* noeud = NULL;
+    csc_file_taches* file = NULL;
     
+    *pic = 0;
+    *agrandissements = 0;
     
-    curl_easy_setopt((CURL*)info->handler, CURLOPT_URL, url_complete);
+    pthread_rwlock_rdlock(&g_noeuds_lock);
+    noeud = info->nodes;
+    while(noeud){
+        file = noeud->taches;
+        cumuler_reception(&file->recharge.ecriture, pic, agrandissements);
+        cumuler_reception(&file->envoi.ecriture, pic, agrandissements);
+        for(size_t i = 0; i < file->nb_reserve; i++)
+            cumuler_reception(&file->reserve[i].ecriture, pic, agrandissements);
+        noeud = noeud->next;
+    }
+    pthread_rwlock_unlock(&g_noeuds_lock);
     
-    /* Building the request */
-    cJSON* base = cJSON_CreateObject();
-    cJSON* json_mdp             = NULL;
-    cJSON* json_nom             = NULL;
+    if(info->soumission)
+        cumuler_reception(&((csc_groupe_soumission*)info->soumission)->envoi.ecriture, pic, agrandissements);
+}
+
+/*!
+    \brief Starts the network engine: from now on, the requests of all the nodes are driven by a single thread.
     
-    cJSON* reponse              = NULL;
-    cJSON* json_code_statut     = NULL;
-    cJSON* json_token           = NULL;
+    \note Optional; without it, each node performs its own requests in its own thread.
     
-    cJSON* json_projet          = NULL;
-    cJSON* json_projet_algo     = NULL;
-    cJSON* json_projet_nom      = NULL;
-    cJSON* json_projet_sch_in   = NULL;
-    cJSON* json_projet_sch_out  = NULL;
-
+    \param info The master info.
+*/
+void demarrer_moteur_reseau(csc_master_info* info){
+    if(!info->moteur)
+        info->moteur = moteur_creer();
+}
 
-    if(!base){
-        retcode = CSC_ERR_FATAL_JSON_INTERNAL;
-        goto end;
+/*!
+    \brief Stops the network engine, after the requests in flight are done.
+    
+    \warning No node may be fetching or submitting work while the engine is stopped.
+    
+    \param info The master info.
+*/
+void arreter_moteur_reseau(csc_master_info* info){
+    // The refills in flight belong to the engine
+    csc_node_info* noeud = info->nodes;
+    while(noeud){
+        recuperer_recharge(info, noeud);
+        noeud = noeud->next;
     }
+    
+    moteur_detruire((csc_moteur*)info->moteur);
+    info->moteur = NULL;
+}
 
+/*!
+    \brief Enables the compression of the requests and answers of the nodes.
+    
+    \note The answers are compressed only if the server agrees to; the requests
+           are compressed with algo, when their body is at least seuil bytes long.
+    
+    \param info The master info.
+    \param algo CSC_COMPRESSION_AUCUNE, CSC_COMPRESSION_GZIP or CSC_COMPRESSION_ZSTD
+                 (the latter requires cruesli to be built with zstd).
+    \param seuil The size, in bytes, under which the requests are sent as is.
+    \return 0 if everything went well or CSC_ERR_FATAL_INVALID_TYPE if algo is not supported.
+*/
+int configurer_compression(csc_master_info* info, int algo, size_t seuil){
+    if(!transfert_compression_supportee(algo))
+        return CSC_ERR_FATAL_INVALID_TYPE;
+    
+    info->compression = algo;
+    info->seuil_compression = seuil;
+    
+    return CSC_NO_ERROR;
+}
 
-    json_mdp = cJSON_CreateString(info->mdp);
-    if(!json_mdp){
-        retcode = CSC_ERR_FATAL_JSON_INTERNAL;
-        goto end;
-    }
-    cJSON_AddItemToObject(base, "key", json_mdp);
+/*!
+    \brief Sets the timeouts of the requests to the master server.
     
-    json_nom = cJSON_CreateString(nom_suggere);
-    if(!json_nom){
-        retcode = CSC_ERR_FATAL_JSON_INTERNAL;
-        goto end;
-    }
-    cJSON_AddItemToObject(base,"name", json_nom);
+    \note Without them, a master that hangs would hang the nodes waiting for it as well.
     
+    \param info The master info.
+    \param connexion_ms The longest a connection may take to be established, in milliseconds; 0 for curl's default.
+    \param total_ms The longest a request may take, in milliseconds; 0 for no limit.
+*/
+void configurer_delais(csc_master_info* info, long connexion_ms, long total_ms){
+    csc_reprise* reprise = (csc_reprise*)info->reprise;
     
-    str = cJSON_Print(base);
+    reprise->delai_connexion_ms = connexion_ms;
+    reprise->delai_total_ms = total_ms;
+}
 
-    // str contains the connection info; we're all set now
-    headers = curl_slist_append(headers, "Expect:");
-    headers = curl_slist_append(headers, "Content-Type: application/json");
-    curl_easy_setopt((CURL*)info->handler, CURLOPT_HTTPHEADER, headers);
+/*!
+    \brief Sets how the requests to the master server are retried when they fail.
     
-    curl_easy_setopt((CURL*)info->handler, CURLOPT_POSTFIELDS, str);
-    curl_easy_setopt((CURL*)info->handler, CURLOPT_POSTFIELDSIZE, -1L);
+    \note The requests that did not reach the server are always retried; the others only if handling
+           them twice is harmless: fetching work, disconnecting, and submitting the results of tasks
+           the server gave an id to.
+    \note Before each retry, the node waits a random time, up to a backoff that starts at attente_base_ms
+           and doubles at each attempt, up to attente_max_ms.
     
-    curl_easy_setopt((CURL*)info->handler, CURLOPT_WRITEFUNCTION, dl2string);
-    curl_easy_setopt((CURL*)info->handler, CURLOPT_WRITEDATA, &writestruct);
+    \param info The master info.
+    \param reprises_max The number of retries after the first attempt; 0 to never retry.
+    \param attente_base_ms The backoff before the first retry, in milliseconds.
+    \param attente_max_ms The cap of the backoff, in milliseconds.
+*/
+void configurer_reprises(csc_master_info* info, unsigned reprises_max, long attente_base_ms, long attente_max_ms){
+    csc_reprise* reprise = (csc_reprise*)info->reprise;
+    
+    reprise->reprises_max = reprises_max;
+    reprise->attente_base_ms = attente_base_ms;
+    reprise->attente_max_ms = attente_max_ms;
+}
 
+/*!
+    \brief Sets the circuit breaker shared by the requests to the master server.
     
-    CURLcode res = curl_easy_perform((CURL*)(info->handler));
+    \note After seuil consecutive failures, the requests are shed for pause_ms milliseconds (they count as
+           failed attempts, and are retried like them); then a single request is let through, which closes
+           the breaker if it succeeds. A request that was shed until it ran out of retries fails with
+           CSC_ERR_NONFATAL_CIRCUIT_OPEN.
     
+    \param info The master info.
+    \param seuil The number of consecutive failures that trips the breaker; 0 so that it never trips.
+    \param pause_ms How long the breaker sheds the requests once tripped, in milliseconds.
+*/
+void configurer_disjoncteur(csc_master_info* info, unsigned seuil, long pause_ms){
+    csc_reprise* reprise = (csc_reprise*)info->reprise;
+    
+    pthread_mutex_lock(&reprise->verrou);
+    reprise->seuil = seuil;
+    reprise->pause_ms = pause_ms;
+    pthread_mutex_unlock(&reprise->verrou);
+}
 
-    curl_slist_free_all(headers);
+/*!
+    \brief Sets how long a master server that failed is left aside, when there are several of them.
     
-    if(res != CURLE_OK){
-        retcode = CSC_FATAL_CURL_ERROR;
-        goto end;
-    }
+    \note The requests go to the other servers in the meantime; the pause doubles while the server keeps failing.
+    
+    \param info The master info.
+    \param pause_ms The pause after a first failure, in milliseconds.
+*/
+void configurer_bascule(csc_master_info* info, long pause_ms){
+    csc_serveurs* serveurs = (csc_serveurs*)info->serveurs;
+    
+    pthread_mutex_lock(&serveurs->verrou);
+    serveurs->pause_ms = pause_ms;
+    pthread_mutex_unlock(&serveurs->verrou);
+}
 
-    reponse = cJSON_Parse(writestruct.ptr);
+/*!
+    \brief Has the nodes wait for work when the master server has none, instead of allouer_travail() returning CSC_NO_MORE_WORK.
+    
+    \note The requests for work tell the master it may hold them for up to longpoll_ms, until it has work: the
+           nodes then get it within milliseconds. If the master answers right away instead, the nodes back off
+           for a random time, up to a delay that doubles while there's no work, up to plafond_ms.
+    \note The master must answer a held request well before the timeout of the requests (see configurer_delais()):
+           longpoll_ms is capped to half of it.
+    
+    \param info The master info.
+    \param active Whether the nodes wait for work at all.
+    \param max_ms How long a node waits before allouer_travail() returns CSC_NO_MORE_WORK, in milliseconds;
+                   0 to wait until interrompre_attente_travail() is called.
+    \param longpoll_ms How long the master may hold a request for work, in milliseconds; 0 for no long polls.
+    \param plafond_ms The cap of the backoff, in milliseconds.
+*/
+void configurer_attente_travail(csc_master_info* info, bool active, long max_ms, long longpoll_ms, long plafond_ms){
+    csc_attente* attente = (csc_attente*)info->attente;
+    
+    attente->active = active;
+    attente->max_ms = max_ms;
+    attente->longpoll_ms = longpoll_ms;
+    attente->plafond_ms = plafond_ms;
+    if(attente->base_ms > plafond_ms)
+        attente->base_ms = plafond_ms;
+}
 
+/*!
+    \brief Has the nodes that wait for work give up: their allouer_travail() returns CSC_NO_MORE_WORK.
     
-    json_code_statut = cJSON_GetObjectItemCaseSensitive(reponse, "code");
-    if(!cJSON_IsNumber(json_code_statut)){
-        retcode = CSC_ERR_FATAL_MISSINGINFO;
-        goto end2;
-    }
-    retcode = json_code_statut->valueint;
-    if(json_code_statut->valueint != 0){
-        goto end2;
-    }
+    \note A request the master is holding is not cut short: the node gives up once it's answered.
+    \note The nodes won't wait anymore afterwards, until executer_cascada() runs them again.
     
-    json_token = cJSON_GetObjectItemCaseSensitive(reponse, "master_token");
-    if(!cJSON_IsString(json_token)){
+    \param info The master info.
+*/
+void interrompre_attente_travail(csc_master_info* info){
+    attente_interrompre((csc_attente*)info->attente);
+}
+
+/*!
+    \brief Has one node that waits for work give up, before it is removed: see interrompre_attente_travail().
+    
+    \note The node gives up once its current backoff is over, or its request is answered.
+    
+    \param info The master info.
+    \param noeud The node.
+*/
+void interrompre_attente_noeud(csc_master_info* info, csc_node_info* noeud){
+    csc_attente* attente = (csc_attente*)info->attente;
+    
+    pthread_mutex_lock(&attente->verrou);
+    noeud->depart = true;
+    pthread_mutex_unlock(&attente->verrou);
+}
+
+/*!
+    \brief Gives the counters of the wait for work.
+    
+    \param info The master info.
+    \param longpolls Where the number of requests the master held is written, or NULL.
+    \param sommeils Where the number of times a node backed off is written, or NULL.
+*/
+void statistiques_attente(const csc_master_info* info, size_t* longpolls, size_t* sommeils){
+    csc_attente* attente = (csc_attente*)info->attente;
+    
+    pthread_mutex_lock(&attente->verrou);
+    if(longpolls)
+        *longpolls = attente->nb_longpolls;
+    if(sommeils)
+        *sommeils = attente->nb_sommeils;
+    pthread_mutex_unlock(&attente->verrou);
+}
+
+/*!
+    \brief Gives the number of master servers given to init_cruesli().
+    
+    \param info The master info.
+    \return The number of servers.
+*/
+size_t nombre_serveurs(const csc_master_info* info){
+    return ((csc_serveurs*)info->serveurs)->nombre;
+}
+
+/*!
+    \brief Gives the counters of one of the master servers.
+    
+    \param info The master info.
+    \param indice The server, in the order they were given to init_cruesli().
+    \param requetes Where the number of attempts sent to it is written, or NULL.
+    \param echecs Where the number of those that failed is written, or NULL.
+    \param latence Where the moving average of the duration of its requests is written, in seconds, or NULL.
+    \return 0 if everything went well, or CSC_ERR_NONFATAL_MISSINGINFO if there is no such server.
+*/
+int statistiques_serveur(const csc_master_info* info, size_t indice, size_t* requetes, size_t* echecs, double* latence){
+    csc_serveurs* serveurs = (csc_serveurs*)info->serveurs;
+    csc_serveur* serveur = NULL;
+    
+    if(indice >= serveurs->nombre)
+        return CSC_ERR_NONFATAL_MISSINGINFO;
+    serveur = &serveurs->liste[indice];
+    
+    pthread_mutex_lock(&serveurs->verrou);
+    if(requetes)
+        *requetes = serveur->nb_requetes;
+    if(echecs)
+        *echecs = serveur->nb_echecs;
+    if(latence)
+        *latence = serveur->latence;
+    pthread_mutex_unlock(&serveurs->verrou);
+    
+    return CSC_NO_ERROR;
+}
+
+/*!
+    \brief Gives the counters of the retry policy.
+    
+    \param info The master info.
+    \param reprises Where the number of retries is written, or NULL.
+    \param declenchements Where the number of times the circuit breaker tripped is written, or NULL.
+    \param rejets Where the number of attempts shed by the circuit breaker is written, or NULL.
+*/
+void statistiques_reprises(const csc_master_info* info, size_t* reprises, size_t* declenchements, size_t* rejets){
+    csc_reprise* reprise = (csc_reprise*)info->reprise;
+    
+    pthread_mutex_lock(&reprise->verrou);
+    if(reprises)
+        *reprises = reprise->nb_reprises;
+    if(declenchements)
+        *declenchements = reprise->nb_declenchements;
+    if(rejets)
+        *rejets = reprise->nb_rejets;
+    pthread_mutex_unlock(&reprise->verrou);
+}
+
+/*!
+    \brief Streams the large submissions instead of building them in memory.
+    
+    \note A streamed submission is sent with the chunked transfer encoding, which the server must
+           support; it is not compressed. Submissions sent through the network engine while the node
+           keeps working, and grouped submissions, are always built in memory.
+    
+    \param info The master info.
+    \param seuil The estimated size, in bytes, from which a submission is streamed; 0 to never stream them.
+*/
+void configurer_flux_soumission(csc_master_info* info, size_t seuil){
+    info->seuil_flux = seuil;
+}
+
+/*!
+    \brief Sets the wire format to offer to the server.
+    
+    \note Must be called before connecter_cascada(). The server picks the format when we connect:
+           if it does not know CBOR, everything keeps being sent in JSON.
+    \note In CBOR, the values of the variables are sent in the width of their type, and the payloads
+           of the tasks are decoded straight into the variables bound by the nodes.
+    
+    \param info The master info.
+    \param format CSC_FORMAT_JSON or CSC_FORMAT_CBOR.
+    \return 0 if everything went well or CSC_ERR_FATAL_INVALID_TYPE if the format is unknown.
+*/
+int configurer_format(csc_master_info* info, int format){
+    if(format != CSC_FORMAT_JSON && format != CSC_FORMAT_CBOR)
+        return CSC_ERR_FATAL_INVALID_TYPE;
+    
+    info->format_souhaite = format;
+    
+    return CSC_NO_ERROR;
+}
+
+/*!
+    \brief Connects to the cascada server.
+    
+    \param info The master info.
+    \param nom_suggere The suggested name for our slave server, that the master server may or may not follow.
+    \return 0 if everything went well or an error code defined in cruesli.h.
+                    
+*/
+int connecter_cascada(csc_master_info* info, char* nom_suggere){
+    // Authentificating on the cascada network
+    
+    int retcode = CSC_NO_ERROR;
+    char* str = NULL;
+    struct curl_slist *headers = NULL;
+    www_writestruct writestruct = { .ptr = NULL, .size = 0};
+    
+    /* Building the request */
+    cJSON* base = cJSON_CreateObject();
+    cJSON* json_mdp             = NULL;
+    cJSON* json_nom             = NULL;
+    
+    cJSON* reponse              = NULL;
+    cJSON* json_code_statut     = NULL;
+    cJSON* json_token           = NULL;
+    cJSON* json_capacites       = NULL;
+    cJSON* json_capacite        = NULL;
+    
+    cJSON* json_projet          = NULL;
+    cJSON* json_projet_algo     = NULL;
+    cJSON* json_projet_nom      = NULL;
+    cJSON* json_projet_sch_in   = NULL;
+    cJSON* json_projet_sch_out  = NULL;
+    
+    
+    if(!base){
+        retcode = CSC_ERR_FATAL_JSON_INTERNAL;
+        goto end;
+    }
+    
+    
+    json_mdp = cJSON_CreateString(info->mdp);
+    if(!json_mdp){
+        retcode = CSC_ERR_FATAL_JSON_INTERNAL;
+        goto end;
+    }
+    cJSON_AddItemToObject(base, "key", json_mdp);
+    
+    json_nom = cJSON_CreateString(nom_suggere);
+    if(!json_nom){
+        retcode = CSC_ERR_FATAL_JSON_INTERNAL;
+        goto end;
+    }
+    cJSON_AddItemToObject(base,"name", json_nom);
+    
+    
+    str = cJSON_Print(base);
+    
+    // str contains the connection info; we're all set now
+    headers = curl_slist_append(headers, "Expect:");
+    headers = curl_slist_append(headers, "Content-Type: application/json");
+    // The request is in JSON; the answer tells us whether the server speaks CBOR as well
+    if(info->format_souhaite == CSC_FORMAT_CBOR)
+        headers = curl_slist_append(headers, "Accept: " WWW_TYPE_CBOR ", " WWW_TYPE_JSON ";q=0.5");
+    curl_easy_setopt((CURL*)info->handler, CURLOPT_HTTPHEADER, headers);
+    
+    curl_easy_setopt((CURL*)info->handler, CURLOPT_POSTFIELDS, str);
+    curl_easy_setopt((CURL*)info->handler, CURLOPT_POSTFIELDSIZE, -1L);
+    
+    curl_easy_setopt((CURL*)info->handler, CURLOPT_WRITEFUNCTION, dl2string);
+    curl_easy_setopt((CURL*)info->handler, CURLOPT_WRITEDATA, &writestruct);
+    
+    
+    // Registering twice would leave a ghost master behind
+    int statut = executer_requete(info, (CURL*)info->handler, &writestruct, false, API_ENREGISTREMENT, false);
+    
+    
+    curl_slist_free_all(headers);
+    
+    if(statut != CSC_NO_ERROR){
+        retcode = statut;
+        goto end;
+    }
+    
+    reponse = analyser_reponse((CURL*)info->handler, &writestruct);
+    info->format = reponse_en_cbor((CURL*)info->handler) ? CSC_FORMAT_CBOR : CSC_FORMAT_JSON;
+    
+    
+    json_code_statut = cJSON_GetObjectItemCaseSensitive(reponse, "code");
+    if(!cJSON_IsNumber(json_code_statut)){
+        retcode = CSC_ERR_FATAL_MISSINGINFO;
+        goto end2;
+    }
+    retcode = json_code_statut->valueint;
+    if(json_code_statut->valueint != 0){
+        goto end2;
+    }
+    
+    json_token = cJSON_GetObjectItemCaseSensitive(reponse, "master_token");
+    if(!cJSON_IsString(json_token)){
         retcode = CSC_ERR_FATAL_MISSINGINFO;
         goto end2;
     }
@@ -230,6 +932,13 @@ int connecter_cascada(csc_master_info* info, char* nom_suggere){
     }
     info->nom = strdup(json_nom->valuestring);
     
+    // Optional: what the master can do on top of the base protocol
+    json_capacites = cJSON_GetObjectItemCaseSensitive(reponse, "capabilities");
+    cJSON_ArrayForEach(json_capacite, json_capacites){
+        if(cJSON_IsString(json_capacite) && !strcmp(json_capacite->valuestring, "unregister-node"))
+            info->retrait_noeuds = true;
+    }
+    
     json_projet = cJSON_GetObjectItemCaseSensitive(reponse, "project");
     if(!cJSON_IsObject(json_projet)){
         retcode = CSC_ERR_FATAL_MISSINGINFO;
@@ -265,7 +974,7 @@ int connecter_cascada(csc_master_info* info, char* nom_suggere){
         retcode = CSC_ERR_FATAL_MISSINGINFO;
         goto end2;
     }
-
+    
     
     {
         cJSON* var;
@@ -289,20 +998,19 @@ int connecter_cascada(csc_master_info* info, char* nom_suggere){
             ajouter_variable(var->valueint, var->string, NULL, info->sch_out);
         }
     }
-
     
-
+    
+    
 end2:
      /* No need to perform a cJSON_Delete on the
      schemes because they belong to reponse */
     cJSON_Delete(reponse);
     free(writestruct.ptr);
-
+    
     
 end:
     cJSON_Delete(base);
     cJSON_free(str);
-    free(url_complete);
     
     return retcode;
 }
@@ -317,17 +1025,18 @@ end:
 int deconnecter_cascada(csc_master_info* info){
     
     int retcode = CSC_NO_ERROR;
-    char url[] = "/api/v1/unregister-master";
     
     struct curl_slist *headers = NULL;
     www_writestruct writestruct = { .ptr = NULL, .size = 0};
     
-    char* url_complete = strconc(info->server_base_url, url);
     char* str = NULL;
     
     cJSON* reponse = NULL;
     cJSON* json_code_statut = NULL;
     
+    // The buffered results must reach the server before we leave
+    vider_soumissions(info);
+    
     /* Building the request */
     cJSON* base = cJSON_CreateObject();
     if(!base){
@@ -342,27 +1051,26 @@ int deconnecter_cascada(csc_master_info* info){
     str = cJSON_Print(base);
     
     pthread_mutex_lock(&g_net_lock);
-
-    curl_easy_setopt((CURL*)info->handler, CURLOPT_URL, url_complete);
+    
     headers = curl_slist_append(headers, "Expect:");
     headers = curl_slist_append(headers, "Content-Type: application/json");
     curl_easy_setopt((CURL*)info->handler, CURLOPT_HTTPHEADER, headers);
-
+    
     curl_easy_setopt((CURL*)info->handler, CURLOPT_POSTFIELDS, str);
     curl_easy_setopt((CURL*)info->handler, CURLOPT_POSTFIELDSIZE, -1L);
     
     curl_easy_setopt((CURL*)info->handler, CURLOPT_WRITEFUNCTION, dl2string);
     curl_easy_setopt((CURL*)info->handler, CURLOPT_WRITEDATA, &writestruct);
     
-    CURLcode res = curl_easy_perform((CURL*)info->handler);
-
+    int statut = executer_requete(info, (CURL*)info->handler, &writestruct, true, API_DESENREGISTREMENT, false);
+    
     curl_slist_free_all(headers);
-
+    
     pthread_mutex_unlock(&g_net_lock);
-
-
-    if(res != CURLE_OK){
-        retcode = CSC_FATAL_CURL_ERROR;
+    
+    
+    if(statut != CSC_NO_ERROR){
+        retcode = statut;
         goto end;
     }
     
@@ -374,8 +1082,8 @@ int deconnecter_cascada(csc_master_info* info){
         goto end2;
     }
     retcode = json_code_statut->valueint;
-
-
+    
+    
 end2:
     cJSON_Delete(reponse);
     
@@ -383,31 +1091,25 @@ end2:
 end:
     cJSON_Delete(base);
     free(writestruct.ptr);
-    free(url_complete);
     free(str);
     
     return retcode;
 }
 
 /*!
-    \brief Asks the master server to allocate nodes for us.
+    \brief Asks the master server for nodes, and appends them to the list of the nodes.
     
-    \note No task will be allocated for the nodes.
-    \note The server will allocate AT MOST nb_noeuds.
-
     \param info The master info.
     \param nb_noeuds The number of nodes that should be allocated.
+    \param premier Where the first new node is written, or NULL.
     \return 0 if everything went well or an error code defined in cruesli.h.
-                    
 */
-int allouer_noeuds(csc_master_info* info, size_t nb_noeuds){
+static int enregistrer_noeuds(csc_master_info* info, size_t nb_noeuds, csc_node_info** premier){
     int retcode = CSC_NO_ERROR;
-    char url[] = "/api/v1/register-nodes";
     
     struct curl_slist *headers = NULL;
     www_writestruct writestruct = { .ptr = NULL, .size = 0};
     
-    char* url_complete = strconc(info->server_base_url, url);
     char* str = NULL;
         
     
@@ -435,33 +1137,33 @@ int allouer_noeuds(csc_master_info* info, size_t nb_noeuds){
         goto end;
     }
     cJSON_AddItemToObject(base, "nodenumber", json_nbnoeuds);
-
+    
     str = cJSON_Print(base);
     
     pthread_mutex_lock(&g_net_lock);
     
-    curl_easy_setopt((CURL*)info->handler, CURLOPT_URL, url_complete);
     headers = curl_slist_append(headers, "Expect:");
     headers = curl_slist_append(headers, "Content-Type: application/json");
     curl_easy_setopt((CURL*)info->handler, CURLOPT_HTTPHEADER, headers);
-
+    
     curl_easy_setopt((CURL*)info->handler, CURLOPT_POSTFIELDS, str);
     curl_easy_setopt((CURL*)info->handler, CURLOPT_POSTFIELDSIZE, -1L);
     
     curl_easy_setopt((CURL*)info->handler, CURLOPT_WRITEFUNCTION, dl2string);
     curl_easy_setopt((CURL*)info->handler, CURLOPT_WRITEDATA, &writestruct);
     
-    CURLcode res = curl_easy_perform((CURL*)info->handler);
-
+    // Registering the nodes twice would leave ghost nodes behind
+    int statut = executer_requete(info, (CURL*)info->handler, &writestruct, false, API_NOEUDS, false);
+    
     curl_slist_free_all(headers);
-
+    
     pthread_mutex_unlock(&g_net_lock);
-
-    if(res != CURLE_OK){
-        retcode = CSC_FATAL_CURL_ERROR;
+    
+    if(statut != CSC_NO_ERROR){
+        retcode = statut;
         goto end;
     }
-
+    
     reponse = cJSON_Parse(writestruct.ptr);
     
     json_code_statut = cJSON_GetObjectItemCaseSensitive(reponse, "code");
@@ -470,7 +1172,7 @@ int allouer_noeuds(csc_master_info* info, size_t nb_noeuds){
         goto end2;
     }
     retcode = json_code_statut->valueint;
-
+    
     json_liste_id_noeuds = cJSON_GetObjectItemCaseSensitive(reponse, "nodenames");
     if(!cJSON_IsArray(json_liste_id_noeuds)){
         retcode = CSC_ERR_FATAL_MISSINGINFO;
@@ -478,29 +1180,62 @@ int allouer_noeuds(csc_master_info* info, size_t nb_noeuds){
     }
     
     
+    csc_node_info* nouveaux = NULL;
     csc_node_info* tmp = NULL;
     csc_node_info* newtmp = NULL;
     if (retcode == 0){
         cJSON_ArrayForEach(json_id_noeud_courant, json_liste_id_noeuds){
+            if(!cJSON_IsString(json_id_noeud_courant)){
+                retcode = CSC_ERR_FATAL_MISSINGINFO;
+                break;
+            }
+            
         newtmp = safe_malloc(sizeof(csc_node_info));
         newtmp->localvars = nouvelle_liste();
+        newtmp->plan = plan_creer();
+        newtmp->next = NULL;
+        newtmp->statut_differe = CSC_NO_ERROR;
+        // Each node gets its own connection to the master server,
+        // so that the nodes don't have to wait for each other
+        newtmp->handler = nouveau_handler();
+        newtmp->taches = nouvelle_file();
+        newtmp->taches->recharge.handler = nouveau_handler();
+        newtmp->taches->envoi.handler = newtmp->handler;
+        newtmp->tache_courante = NULL;
+        newtmp->prefixe = NULL;
+        newtmp->taille_prefixe = 0;
+        newtmp->debut_nodeid = 0;
+        newtmp->cpu = -1;
+        newtmp->numa = -1;
+        newtmp->depart = false;
+        newtmp->taches_pretees = 0;
+        newtmp->desinscription = false;
             
         if(!tmp){
-            info->nodes = newtmp;
+            nouveaux = newtmp;
             tmp = newtmp;
         } else {
             tmp->next = newtmp;
         }
-            if(!cJSON_IsString(json_id_noeud_courant)){
-                retcode = CSC_ERR_FATAL_MISSINGINFO;
-                goto end2;
-            }
             
             newtmp->id = strdup(json_id_noeud_courant->valuestring);
+            preparer_noeud(info, newtmp);
             tmp = newtmp;
         }
     }
-    newtmp->next = NULL;
+    
+    // The other nodes may be working: the new ones are only linked once ready
+    if(nouveaux){
+        pthread_rwlock_wrlock(&g_noeuds_lock);
+        for(tmp = info->nodes; tmp && tmp->next; tmp = tmp->next);
+        if(tmp)
+            tmp->next = nouveaux;
+        else
+            info->nodes = nouveaux;
+        pthread_rwlock_unlock(&g_noeuds_lock);
+    }
+    if(premier)
+        *premier = nouveaux;
         
         
     
@@ -512,77 +1247,90 @@ end2:
 end:
     cJSON_Delete(base);
     free(writestruct.ptr);
-    free(url_complete);
     free(str);
     
-
+    
     
     
     return retcode;
 }
 
 /*!
-    \brief Asks the master server to allocate a task for the node mon_noeud.
+    \brief Asks the master server to allocate nodes for us.
+    
+    \note No task will be allocated for the nodes.
+    \note The server will allocate AT MOST nb_noeuds.
+    \note The nodes are appended to those already allocated.
     
     \param info The master info.
-    \param mon_noeud The node that needs to be allocated work.
+    \param nb_noeuds The number of nodes that should be allocated.
     \return 0 if everything went well or an error code defined in cruesli.h.
                     
 */
-int allouer_travail(csc_master_info* info, csc_node_info* mon_noeud){
-    
-    //csc_node_info* mon_noeud = trouver_noeud_par_id(info, id_noeud);
+int allouer_noeuds(csc_master_info* info, size_t nb_noeuds){
+    return enregistrer_noeuds(info, nb_noeuds, NULL);
+}
+
+/*!
+    \brief Asks the master server for one more node, while the others may be working.
     
+    \param info The master info.
+    \param noeud Where the new node is written; NULL if the server did not grant it.
+    \return 0 if everything went well or an error code defined in cruesli.h.
+*/
+int ajouter_noeud(csc_master_info* info, csc_node_info** noeud){
+    int retcode = enregistrer_noeuds(info, 1, noeud);
     
-    if(!mon_noeud || !info)
-        return CSC_FATAL_NULL_INFO;
+    if(retcode == CSC_NO_ERROR && !*noeud)
+        retcode = CSC_ERR_NONFATAL_MISSINGINFO;
+    return retcode;
+}
 
+/*!
+    \brief Tells the master server a removed node has left.
+    
+    \note Its buffered results are sent first: the master must not get any after the request.
+    \note The node is only marked as done once the master has answered: otherwise, conclure_retraits() tries again.
+    
+    \param info The master info.
+    \param noeud The node, removed by retirer_noeud(); none of its tasks is held by another node anymore.
+    \return The status sent by the master server, or an error code defined in cruesli.h.
+*/
+static int desinscrire_noeud(csc_master_info* info, csc_node_info* noeud){
     int retcode = CSC_NO_ERROR;
-    char url[] = "/api/v1/fetch-work-for-node";
     
     struct curl_slist *headers = NULL;
     www_writestruct writestruct = { .ptr = NULL, .size = 0};
-    
-    char* url_complete = strconc(info->server_base_url, url);
     char* str = NULL;
     
-    
-    
+    cJSON* base = NULL;
     cJSON* reponse = NULL;
     cJSON* json_code_statut = NULL;
-    cJSON* json_payload = NULL;
     
-    /* Là on construit la requête */
-    cJSON* base = cJSON_CreateObject();
+    vider_soumissions(info);
+    
+    /* Building the request */
+    base = cJSON_CreateObject();
     if(!base){
         retcode = CSC_ERR_FATAL_JSON_INTERNAL;
         goto end;
     }
-    cJSON* json_token = cJSON_CreateString(info->authcode);
-    if(!json_token){
+    if(!cJSON_AddStringToObject(base, "mastertoken", info->authcode) || !cJSON_AddStringToObject(base, "nodeid", noeud->id)){
         retcode = CSC_ERR_FATAL_JSON_INTERNAL;
         goto end;
     }
-    cJSON_AddItemToObject(base, "mastertoken", json_token);
     
-    cJSON* json_idnoeud = cJSON_CreateString(mon_noeud->id);
-    if(!json_idnoeud){
+    str = cJSON_Print(base);
+    if(!str){
         retcode = CSC_ERR_FATAL_JSON_INTERNAL;
         goto end;
     }
-    cJSON_AddItemToObject(base, "nodeid", json_idnoeud);
-    
-    str = cJSON_Print(base);
-    
-    
     
     pthread_mutex_lock(&g_net_lock);
     
-    curl_easy_setopt((CURL*)info->handler, CURLOPT_URL, url_complete);
     headers = curl_slist_append(headers, "Expect:");
     headers = curl_slist_append(headers, "Content-Type: application/json");
     curl_easy_setopt((CURL*)info->handler, CURLOPT_HTTPHEADER, headers);
-
     
     curl_easy_setopt((CURL*)info->handler, CURLOPT_POSTFIELDS, str);
     curl_easy_setopt((CURL*)info->handler, CURLOPT_POSTFIELDSIZE, -1L);
@@ -590,105 +1338,1493 @@ int allouer_travail(csc_master_info* info, csc_node_info* mon_noeud){
     curl_easy_setopt((CURL*)info->handler, CURLOPT_WRITEFUNCTION, dl2string);
     curl_easy_setopt((CURL*)info->handler, CURLOPT_WRITEDATA, &writestruct);
     
-    CURLcode res = curl_easy_perform((CURL*)info->handler);
+    // Removing a node twice is harmless
+    retcode = executer_requete(info, (CURL*)info->handler, &writestruct, true, API_RETRAIT_NOEUD, false);
     
     curl_slist_free_all(headers);
-
+    
     pthread_mutex_unlock(&g_net_lock);
-
-    if(res != CURLE_OK){
-        retcode = CSC_FATAL_CURL_ERROR;
+    
+    if(retcode != CSC_NO_ERROR)
         goto end;
-    }
     
     reponse = cJSON_Parse(writestruct.ptr);
     
     json_code_statut = cJSON_GetObjectItemCaseSensitive(reponse, "code");
     if(!cJSON_IsNumber(json_code_statut)){
-        retcode = CSC_ERR_FATAL_MISSINGINFO;
-        goto end2;
+        retcode = CSC_ERR_NONFATAL_MISSINGINFO;
+        goto end;
     }
     retcode = json_code_statut->valueint;
-    if(retcode != CSC_NO_ERROR){
-        goto end2;
-    }
     
-    json_payload = cJSON_GetObjectItemCaseSensitive(reponse, "task-payload");
-    if(!cJSON_IsObject(json_payload)){
-        retcode = CSC_ERR_FATAL_MISSINGINFO;
-        goto end2;
-    }
+    // The master has heard of it: asking again would get the same answer
+    noeud->desinscription = false;
     
-    // Lecture + conversion/assignation
-    {
-        cJSON* var;
-        csc_var* local_var;
-        cJSON_ArrayForEach(var, json_payload){
-            if(!cJSON_IsNumber(var)){
-                retcode = CSC_ERR_FATAL_MISSINGINFO;
-                goto end2;
+end:
+    cJSON_Delete(reponse);
+    cJSON_Delete(base);
+    free(writestruct.ptr);
+    free(str);
+    
+    return retcode;
+}
+
+/*!
+    \brief Removes a node while the others may be working, frees what it used, and tells the master server
+            it has left.
+    
+    \note The node must not be in use anymore: its thread is over, and its task handles are released.
+    \note The tasks still in the node's queue are handed over to another node, and submitted under its id.
+           Without any other node, they are dropped: the master gives them to someone else in time.
+    \note The master is only told once the tasks of the node held by the others (handed over, or taken
+           by them earlier) are submitted; until then, the request waits for conclure_retraits().
+    \note The node's id stays valid until cleanup_cruesli().
+    
+    \param info The master info.
+    \param noeud The node.
+    \return The status sent by the master server; CSC_NO_ERROR as well if the master is yet to be told;
+            CSC_ERR_NONFATAL_UNSUPPORTED if the master can't release a single node: the node is only removed
+            here. Or an error code defined in cruesli.h: if the master didn't answer, conclure_retraits()
+            tries again.
+*/
+int retirer_noeud(csc_master_info* info, csc_node_info* noeud){
+    csc_node_info** lien = NULL;
+    csc_node_info* candidat = NULL;
+    csc_node_info* heritier = NULL;
+    csc_tache* taches = NULL;
+    csc_tache* tache = NULL;
+    size_t longueur, plus_courte = 0;
+    size_t nombre;
+    bool trouve = false;
+    
+    if(!info || !noeud)
+        return CSC_FATAL_NULL_INFO;
+    
+    // Once unlinked, no other node takes tasks from its queue anymore
+    pthread_rwlock_wrlock(&g_noeuds_lock);
+    for(lien = &info->nodes; *lien && *lien != noeud; lien = &(*lien)->next);
+    if(*lien){
+        *lien = noeud->next;
+        noeud->next = info->retires;
+        info->retires = noeud;
+        trouve = true;
+    }
+    pthread_rwlock_unlock(&g_noeuds_lock);
+    
+    if(!trouve)
+        return CSC_FATAL_NULL_INFO;
+    
+    // Its tasks, including those of a refill in flight, go to the node with the fewest of them
+    recuperer_recharge(info, noeud);
+    
+    pthread_rwlock_rdlock(&g_noeuds_lock);
+    for(candidat = info->nodes; candidat; candidat = candidat->next){
+        longueur = file_longueur(candidat->taches);
+        if(!heritier || longueur < plus_courte){
+            plus_courte = longueur;
+            heritier = candidat;
+        }
+    }
+    while(heritier && (taches = file_ceder(noeud->taches, &nombre))){
+        for(tache = taches; tache; tache = tache->suivante)
+            tache_preter(tache, noeud);
+        file_accueillir(heritier->taches, taches, nombre);
+    }
+    pthread_rwlock_unlock(&g_noeuds_lock);
+    
+    liberer_noeud(noeud);
+    
+    if(!info->retrait_noeuds)
+        return CSC_ERR_NONFATAL_UNSUPPORTED;
+    
+    noeud->desinscription = true;
+    if(taches_pretees(noeud))
+        return CSC_NO_ERROR;
+    
+    return desinscrire_noeud(info, noeud);
+}
+
+/*!
+    \brief Tells the master server about the removed nodes whose tasks, held by the other nodes, are now
+            all submitted (see retirer_noeud()).
+    
+    \note Should be called from time to time while nodes are removed, and from the thread that removes them.
+    
+    \note A node the master couldn't be told about, for want of an answer, is tried again at the next call.
+    
+    \param info The master info.
+    \param echecs Where the number of nodes the master couldn't be told about this time is added, or NULL.
+    \return The number of removed nodes the master is still to be told about, including those.
+*/
+size_t conclure_retraits(csc_master_info* info, size_t* echecs){
+    csc_node_info* noeud = NULL;
+    size_t restants = 0;
+    
+    if(!info)
+        return 0;
+    
+    // The removed nodes are never unlinked before cleanup_cruesli(): the list can be walked from its head
+    pthread_rwlock_rdlock(&g_noeuds_lock);
+    noeud = info->retires;
+    pthread_rwlock_unlock(&g_noeuds_lock);
+    
+    for(; noeud; noeud = noeud->next){
+        if(!noeud->desinscription)
+            continue;
+        if(taches_pretees(noeud)){
+            restants += 1;
+            continue;
+        }
+    
+        if(desinscrire_noeud(info, noeud) != CSC_NO_ERROR && echecs)
+            *echecs += 1;
+        if(noeud->desinscription)
+            restants += 1;
+    }
+    
+    return restants;
+}
+
+/*!
+    \brief Makes sure the plan of a node is up to date with its variables and the schemes.
+    
+    \param info The master info.
+    \param mon_noeud The node.
+    \return 0 if the node bound every variable of the schemes, CSC_ERR_FATAL_UNREGISTERED_VAR if not.
+*/
+static int preparer_plan(csc_master_info* info, csc_node_info* mon_noeud){
+    csc_plan* plan = (csc_plan*)mon_noeud->plan;
+    
+    if(plan_perime(plan, mon_noeud->localvars, info->sch_in, info->sch_out))
+        plan_compiler(plan, mon_noeud->localvars, info->sch_in, info->sch_out);
+    
+    return plan->manquantes ? CSC_ERR_FATAL_UNREGISTERED_VAR : CSC_NO_ERROR;
+}
+
+/*!
+    \brief Resolves the variables of the schemes against those bound by the node, and tells which are missing or mismatched.
+    
+    \note This is done anyway when the node gets its first task, and again whenever it binds another
+           variable; calling it beforehand reports the problems up front.
+    \note A variable bound with another type than the scheme's is still read and written in its own type.
+    
+    \param info The master info.
+    \param mon_noeud The node, once its variables are bound.
+    \param manquantes Where the number of variables of the schemes the node did not bind is written, or NULL.
+    \param incompatibles Where the number of variables bound with another type than the scheme's is written, or NULL.
+    \return 0 if everything matches, CSC_ERR_FATAL_UNREGISTERED_VAR if variables are missing, CSC_ERR_FATAL_INVALID_TYPE if types don't match.
+*/
+int lier_noeud(csc_master_info* info, csc_node_info* mon_noeud, size_t* manquantes, size_t* incompatibles){
+    
+    if(!mon_noeud || !info)
+        return CSC_FATAL_NULL_INFO;
+    
+    csc_plan* plan = (csc_plan*)mon_noeud->plan;
+    int retcode = preparer_plan(info, mon_noeud);
+    
+    if(manquantes)
+        *manquantes = plan->manquantes;
+    if(incompatibles)
+        *incompatibles = plan->incompatibles;
+    
+    if(retcode == CSC_NO_ERROR && plan->incompatibles)
+        retcode = CSC_ERR_FATAL_INVALID_TYPE;
+    return retcode;
+}
+
+/*!
+    \brief Binds the fields of a C struct to the node, as a whole, instead of binding them one by one with ajouter_variable().
+    
+    \note The fields are described once, with CSC_CHAMP(): a variable bound with ajouter_variable()
+           takes precedence over a field of the same name. Another description replaces this one;
+           NULL unbinds the structure.
+    
+    \param mon_noeud The node.
+    \param champs The description of the fields; it must outlive the binding.
+    \param nombre The number of fields.
+    \param instance The instance of the structure the fields are read from and written to; see changer_instance().
+    \return 0 if everything went well or an error code defined in cruesli.h.
+*/
+int lier_structure(csc_node_info* mon_noeud, const csc_champ* champs, size_t nombre, void* instance){
+    
+    if(!mon_noeud || (champs && !instance))
+        return CSC_FATAL_NULL_INFO;
+    
+    plan_lier_structure((csc_plan*)mon_noeud->plan, champs, nombre, instance);
+    
+    return CSC_NO_ERROR;
+}
+
+/*!
+    \brief Has the fields of the structure bound by the node read from and written to another instance, from the next task on.
+    
+    \note Nothing is resolved again: a node can alternate between several instances at no cost, for instance
+           to fill one with the next task while the previous one is still being used.
+    
+    \param mon_noeud The node, which bound a structure with lier_structure().
+    \param instance The instance.
+*/
+void changer_instance(csc_node_info* mon_noeud, void* instance){
+    csc_plan* plan = (csc_plan*)mon_noeud->plan;
+    
+    if(instance)
+        plan->instance = instance;
+}
+
+/*!
+    \brief Finds the variable a key of a payload refers to.
+    
+    \note The keys usually come in the order of the input scheme: the entry of the plan following the previous match is tried first.
+    
+    \param nom The key; it does not need to be NUL-terminated.
+    \param longueur The length of the key.
+    \param mon_noeud The node, which plan is up to date.
+    \param indice The entry of the plan to try first, updated to the one following the match.
+    \param tampon Where the variable is built, if it's a field of the structure bound by the node.
+    \return The variable, or NULL if the node did not bind it.
+*/
+static csc_var* trouver_variable(const char* nom, size_t longueur, csc_node_info* mon_noeud, size_t* indice, csc_var* tampon){
+    csc_plan* plan = (csc_plan*)mon_noeud->plan;
+    csc_var* var = NULL;
+    size_t i;
+    
+    if(*indice < plan->nombre_in && nom_egal(&plan->entrees[*indice].var, nom, longueur))
+        return plan_variable(plan, &plan->entrees[(*indice)++], tampon);
+    
+    // Not in the scheme, or out of order
+    var = recup_variable_n(nom, longueur, mon_noeud->localvars);
+    if(var)
+        return var;
+    
+    for(i = 0; i < plan->nombre_in; i++){
+        if(plan->entrees[i].champ && nom_egal(&plan->entrees[i].var, nom, longueur)){
+            *indice = i + 1;
+            return plan_variable(plan, &plan->entrees[i], tampon);
+        }
+    }
+    
+    return NULL;
+}
+
+/*!
+    \brief Writes the values of a task payload sent in JSON into the variables bound by the node.
+    
+    \note The payload is read in a single pass, without building a tree.
+    
+    \param payload The task-payload object sent by the master server.
+    \param taille The size of the object, in bytes.
+    \param mon_noeud The node which variables should be written.
+    \return 0 if everything went well or an error code defined in cruesli.h.
+*/
+static int charger_payload_json(const char* payload, size_t taille, csc_node_info* mon_noeud){
+    json_curseur curseur;
+    json_conteneur objet;
+    const char* nom;
+    size_t longueur;
+    bool echappee;
+    char tampon_nom[256];
+    size_t indice = 0;
+    csc_var champ;
+    csc_var* local_var;
+    
+    json_curseur_init(&curseur, payload, taille);
+    if(!json_ouvrir(&curseur, '{', &objet))
+        return CSC_ERR_NONFATAL_MISSINGINFO;
+    
+    while(json_suivant(&curseur, &objet)){
+        if(!json_lire_cle(&curseur, &nom, &longueur, &echappee))
+            return CSC_ERR_NONFATAL_MISSINGINFO;
+        
+        // Rare enough: the key is decoded on the stack
+        if(echappee){
+            longueur = json_desechapper(nom, longueur, tampon_nom, sizeof(tampon_nom));
+            if(longueur == (size_t)-1)
+                return CSC_ERR_FATAL_UNREGISTERED_VAR;
+            nom = tampon_nom;
+        }
+        
+        local_var = trouver_variable(nom, longueur, mon_noeud, &indice, &champ);
+        if(!local_var){
+            // Variable pas trouvée -> erreur critique;
+            return CSC_ERR_FATAL_UNREGISTERED_VAR;
+        }
+        
+        // Conversion et assignation directement depuis le message
+        if(!json_lire_var(&curseur, local_var))
+            return CSC_ERR_NONFATAL_MISSINGINFO;
+    }
+    
+    return CSC_NO_ERROR;
+}
+    
+/*!
+    \brief Writes the values of a task payload sent in CBOR into the variables bound by the node.
+    
+    \param payload The task-payload map sent by the master server.
+    \param taille The size of the map, in bytes.
+    \param mon_noeud The node which variables should be written.
+    \return 0 if everything went well or an error code defined in cruesli.h.
+*/
+static int charger_payload_cbor(const char* payload, size_t taille, csc_node_info* mon_noeud){
+    cbor_curseur curseur;
+    cbor_conteneur map;
+    const char* nom;
+    size_t longueur;
+    size_t indice = 0;
+    csc_var champ;
+    csc_var* local_var;
+    
+    cbor_curseur_init(&curseur, payload, taille);
+    if(!cbor_ouvrir(&curseur, CBOR_MAP, &map))
+        return CSC_ERR_NONFATAL_MISSINGINFO;
+    
+    while(cbor_suivant(&curseur, &map)){
+        if(!cbor_lire_texte(&curseur, &nom, &longueur))
+            return CSC_ERR_NONFATAL_MISSINGINFO;
+        
+        local_var = trouver_variable(nom, longueur, mon_noeud, &indice, &champ);
+        if(!local_var){
+            // Variable pas trouvée -> erreur critique;
+            return CSC_ERR_FATAL_UNREGISTERED_VAR;
+        }
+        
+        // Conversion et assignation directement depuis le message
+        if(!cbor_lire_var(&curseur, local_var))
+            return CSC_ERR_NONFATAL_MISSINGINFO;
+    }
+    
+    return CSC_NO_ERROR;
+}
+    
+/*!
+    \brief Writes the payload of a task into the variables bound by the node, and frees the payload.
+    
+    \param info The master info.
+    \param tache The task.
+    \param mon_noeud The node which variables should be written.
+    \return 0 if everything went well or an error code defined in cruesli.h.
+*/
+static int charger_tache(csc_master_info* info, csc_tache* tache, csc_node_info* mon_noeud){
+    // A node that misses variables of the schemes could not submit its result anyway
+    int retcode = preparer_plan(info, mon_noeud);
+    
+    if(retcode == CSC_NO_ERROR){
+        if(tache->format == CSC_FORMAT_CBOR)
+            retcode = charger_payload_cbor(tache->payload, tache->taille_payload, mon_noeud);
+        else
+            retcode = charger_payload_json(tache->payload, tache->taille_payload, mon_noeud);
+    }
+    
+    // Only the id is needed from now on, for the submission
+    free(tache->payload);
+    tache->payload = NULL;
+    tache->taille_payload = 0;
+    
+    return retcode;
+}
+    
+/*!
+    \brief Prepares, on the refill transfer of the node, a request for nombre tasks.
+    
+    \param info The master info.
+    \param mon_noeud The node that needs to be allocated work.
+    \param nombre The number of tasks to ask for.
+    \param attente_ms How long the master may hold the request until it has work, in milliseconds; 0 if it should answer right away.
+    \return 0 if everything went well or an error code defined in cruesli.h.
+*/
+static int preparer_requete_travail(csc_master_info* info, csc_node_info* mon_noeud, size_t nombre, long attente_ms){
+    
+    www_writestruct* sortie = &mon_noeud->taches->recharge.sortie;
+    
+    ecriture_vider(sortie);
+    
+    if(info->format == CSC_FORMAT_CBOR){
+        cbor_tampon tampon;
+        emprunter_tampon(sortie, &tampon);
+        
+        cbor_ecrire_entete(&tampon, CBOR_MAP, 2 + (nombre > 1) + (attente_ms > 0));
+        cbor_ecrire_brut(&tampon, mon_noeud->prefixe, mon_noeud->taille_prefixe);
+        if(nombre > 1){
+            cbor_ecrire_texte(&tampon, "count");
+            cbor_ecrire_entete(&tampon, CBOR_NATUREL, nombre);
+        }
+        if(attente_ms > 0){
+            cbor_ecrire_texte(&tampon, "wait");
+            cbor_ecrire_entete(&tampon, CBOR_NATUREL, (uint64_t)attente_ms);
+        }
+        
+        rendre_tampon(sortie, &tampon);
+    } else {
+        JSON_ECRIRE_LITTERAL(sortie, "{");
+        json_ecrire_brut(sortie, mon_noeud->prefixe, mon_noeud->taille_prefixe);
+        // Without count, the server sends a single task
+        if(nombre > 1){
+            JSON_ECRIRE_LITTERAL(sortie, ",\"count\":");
+            json_ecrire_entier(sortie, (int64_t)nombre);
+        }
+        // A master that can't hold requests ignores it
+        if(attente_ms > 0){
+            JSON_ECRIRE_LITTERAL(sortie, ",\"wait\":");
+            json_ecrire_entier(sortie, (int64_t)attente_ms);
+        }
+        JSON_ECRIRE_LITTERAL(sortie, "}");
+    }
+    
+    preparer_transfert(info, &mon_noeud->taches->recharge, sortie->ptr, sortie->size);
+    
+    return CSC_NO_ERROR;
+}
+    
+/*!
+    \brief Queues the tasks of an answer to a refill request sent in CBOR.
+    
+    \note The payloads are kept encoded: they are decoded straight into the variables of the node
+           when the tasks are handed over.
+    
+    \param file The queue of the node.
+    \param data The answer.
+    \param taille The size of the answer.
+    \return 0 if everything went well or an error code defined in cruesli.h.
+*/
+static int integrer_reponse_cbor(csc_file_taches* file, const char* data, size_t taille){
+    cbor_curseur reponse, valeur, ids;
+    cbor_conteneur payloads, liste_ids;
+    cbor_nombre code;
+    const uint8_t* debut = NULL;
+    cJSON* json_id = NULL;
+    bool avec_ids = false;
+    
+    cbor_curseur_init(&reponse, data, taille);
+    
+    if(!cbor_trouver(reponse, "code", &valeur) || !cbor_lire_nombre(&valeur, &code))
+        return CSC_ERR_NONFATAL_MISSINGINFO;
+    if(code.entier != CSC_NO_ERROR)
+        return (int)code.entier;
+    
+    // A batch of tasks, and possibly their ids...
+    if(cbor_trouver(reponse, "task-payloads", &valeur) && cbor_ouvrir(&valeur, CBOR_TABLEAU, &payloads)){
+        avec_ids = cbor_trouver(reponse, "task-ids", &ids) && cbor_ouvrir(&ids, CBOR_TABLEAU, &liste_ids);
+        
+        while(cbor_suivant(&valeur, &payloads)){
+            debut = valeur.p;
+            if(cbor_type(&valeur) != CBOR_MAP || !cbor_sauter(&valeur))
+                return CSC_ERR_NONFATAL_MISSINGINFO;
+            
+            json_id = NULL;
+            if(avec_ids && cbor_suivant(&ids, &liste_ids)){
+                json_id = cbor_vers_json(&ids);
+                if(!json_id)
+                    return CSC_ERR_NONFATAL_MISSINGINFO;
+            }
+            file_pousser(file, debut, valeur.p - debut, CSC_FORMAT_CBOR, json_id);
+        }
+        return CSC_NO_ERROR;
+    }
+    
+    // ...or a single one
+    if(!cbor_trouver(reponse, "task-payload", &valeur) || cbor_type(&valeur) != CBOR_MAP)
+        return CSC_ERR_NONFATAL_MISSINGINFO;
+    debut = valeur.p;
+    if(!cbor_sauter(&valeur))
+        return CSC_ERR_NONFATAL_MISSINGINFO;
+    
+    if(cbor_trouver(reponse, "task-id", &ids)){
+        json_id = cbor_vers_json(&ids);
+        if(!json_id)
+            return CSC_ERR_NONFATAL_MISSINGINFO;
+    }
+    file_pousser(file, debut, valeur.p - debut, CSC_FORMAT_CBOR, json_id);
+    
+    return CSC_NO_ERROR;
+}
+    
+/*!
+    \brief Queues the tasks of an answer to a refill request sent in JSON.
+    
+    \note The answer is scanned once, without building a tree; the payloads are kept as is, and are
+           decoded straight into the variables of the node when the tasks are handed over.
+    
+    \param file The queue of the node.
+    \param data The answer.
+    \param taille The size of the answer.
+    \return 0 if everything went well or an error code defined in cruesli.h.
+*/
+static int integrer_reponse_json(csc_file_taches* file, const char* data, size_t taille){
+    json_curseur reponse, payload, payloads, ids;
+    json_conteneur objet, liste_payloads, liste_ids;
+    const char* cle;
+    const char* debut;
+    size_t longueur;
+    bool echappee;
+    bool code_lu = false;
+    int64_t code = CSC_NO_ERROR;
+    cJSON* json_id = NULL;
+    
+    payload.p = payloads.p = ids.p = NULL;
+    
+    // A single pass over the members: only the position of the interesting ones is kept
+    json_curseur_init(&reponse, data, taille);
+    if(!json_ouvrir(&reponse, '{', &objet))
+        return CSC_ERR_NONFATAL_MISSINGINFO;
+    
+    while(json_suivant(&reponse, &objet)){
+        if(!json_lire_cle(&reponse, &cle, &longueur, &echappee))
+            return CSC_ERR_NONFATAL_MISSINGINFO;
+        
+        if(longueur == 4 && !memcmp(cle, "code", 4)){
+            if(!json_lire_entier(&reponse, &code))
+                return CSC_ERR_NONFATAL_MISSINGINFO;
+            code_lu = true;
+            continue;
+        }
+        
+        if(longueur == 12 && !memcmp(cle, "task-payload", 12))
+            payload = reponse;
+        else if(longueur == 13 && !memcmp(cle, "task-payloads", 13))
+            payloads = reponse;
+        else if((longueur == 7 && !memcmp(cle, "task-id", 7)) || (longueur == 8 && !memcmp(cle, "task-ids", 8)))
+            ids = reponse;
+        
+        if(!json_sauter(&reponse))
+            return CSC_ERR_NONFATAL_MISSINGINFO;
+    }
+    
+    if(!code_lu)
+        return CSC_ERR_NONFATAL_MISSINGINFO;
+    if(code != CSC_NO_ERROR)
+        return (int)code;
+    
+    // A batch of tasks, and possibly their ids...
+    if(payloads.p && json_ouvrir(&payloads, '[', &liste_payloads)){
+        if(ids.p && !json_ouvrir(&ids, '[', &liste_ids))
+            ids.p = NULL;
+        
+        while(json_suivant(&payloads, &liste_payloads)){
+            if(json_type(&payloads) != '{')
+                return CSC_ERR_NONFATAL_MISSINGINFO;
+            debut = payloads.p;
+            if(!json_sauter(&payloads))
+                return CSC_ERR_NONFATAL_MISSINGINFO;
+            
+            // The ids are opaque: they are kept as JSON values, for the submissions
+            json_id = NULL;
+            if(ids.p && json_suivant(&ids, &liste_ids)){
+                json_type(&ids);
+                cle = ids.p;
+                if(!json_sauter(&ids))
+                    return CSC_ERR_NONFATAL_MISSINGINFO;
+                json_id = cJSON_ParseWithLength(cle, ids.p - cle);
             }
+            file_pousser(file, debut, payloads.p - debut, CSC_FORMAT_JSON, json_id);
+        }
+        return CSC_NO_ERROR;
+    }
+    
+    // ...or a single one
+    if(!payload.p || json_type(&payload) != '{')
+        return CSC_ERR_NONFATAL_MISSINGINFO;
+    debut = payload.p;
+    if(!json_sauter(&payload))
+        return CSC_ERR_NONFATAL_MISSINGINFO;
+    
+    if(ids.p){
+        json_type(&ids);
+        cle = ids.p;
+        if(!json_sauter(&ids))
+            return CSC_ERR_NONFATAL_MISSINGINFO;
+        json_id = cJSON_ParseWithLength(cle, ids.p - cle);
+    }
+    file_pousser(file, debut, payload.p - debut, CSC_FORMAT_JSON, json_id);
+    
+    return CSC_NO_ERROR;
+}
+    
+/*!
+    \brief Reads the answer to a refill request, and queues the tasks it contains.
+    
+    \param mon_noeud The node that asked for work.
+    \param statut The status of the request, once its retries are over.
+    \param longpoll Whether the master could hold the request: how long it took then says nothing of the latency.
+    \return 0 if everything went well or an error code defined in cruesli.h.
+*/
+static int integrer_reponse_travail(csc_node_info* mon_noeud, int statut, bool longpoll){
+    
+    int retcode = CSC_NO_ERROR;
+    csc_file_taches* file = mon_noeud->taches;
+    double rtt = 0.0;
+    
+    if(statut != CSC_NO_ERROR){
+        retcode = statut;
+        goto end;
+    }
+    
+    if(!longpoll && curl_easy_getinfo(file->recharge.handler, CURLINFO_TOTAL_TIME, &rtt) == CURLE_OK)
+        file_noter_rtt(file, rtt);
+    
+    if(reponse_en_cbor(file->recharge.handler))
+        retcode = integrer_reponse_cbor(file, file->recharge.ecriture.ptr, file->recharge.ecriture.size);
+    else
+        retcode = integrer_reponse_json(file, file->recharge.ecriture.ptr, file->recharge.ecriture.size);
+    
+end:
+    transfert_liberer(&file->recharge);
+    
+    return retcode;
+}
+    
+/*!
+    \brief Collects the refill request of a node that's in flight in the background, if any.
+    
+    \param info The master info.
+    \param mon_noeud The node.
+    \return 0 if everything went well or an error code defined in cruesli.h.
+*/
+static int recuperer_recharge(csc_master_info* info, csc_node_info* mon_noeud){
+    csc_file_taches* file = mon_noeud->taches;
+    CURLcode res;
+    
+    if(!file->recharge.requete)
+        return CSC_NO_ERROR;
+    
+    res = moteur_attendre((csc_requete*)file->recharge.requete);
+    file->recharge.requete = NULL;
+    
+    // Asking for work again is harmless: the tasks of a lost answer are given to someone else in time
+    return integrer_reponse_travail(mon_noeud, conclure_requete(info, file->recharge.handler, &file->recharge.ecriture, true, API_TRAVAIL, (csc_serveur*)file->recharge.serveur, res, NULL, false), false);
+}
+    
+/*!
+    \brief Starts refilling the queue of the node in the background, if the network engine is running.
+    
+    \param info The master info.
+    \param mon_noeud The node.
+    \param nombre The number of tasks to ask for.
+*/
+static void lancer_recharge(csc_master_info* info, csc_node_info* mon_noeud, size_t nombre){
+    csc_file_taches* file = mon_noeud->taches;
+    
+    if(!info->moteur || file->recharge.requete)
+        return;
+    
+    // While the breaker sheds the requests, the queue is refilled when it's empty, with the retries
+    if(preparer_requete_travail(info, mon_noeud, nombre, 0) == CSC_NO_ERROR && (file->recharge.serveur = engager_requete(info, file->recharge.handler, API_TRAVAIL, NULL))){
+        file->recharge.requete = poster_requete(info, file->recharge.handler);
+    } else {
+        transfert_liberer(&file->recharge);
+    }
+}
+    
+/*!
+    \brief Sets how many tasks are fetched at once for each node.
+    
+    \note Within [lot_min, lot_max], the size of the batches adapts to the time spent on
+          each task compared to the time spent waiting for the server.
+    \note When the network engine is running, a node's queue is refilled in the background
+          as soon as it holds seuil_bas tasks or less; otherwise it is refilled when empty.
+    
+    \param info The master info.
+    \param lot_min The smallest batch size.
+    \param lot_max The largest batch size; 1 disables batching.
+    \param seuil_bas The low-water mark of the local queues.
+*/
+void configurer_lots(csc_master_info* info, size_t lot_min, size_t lot_max, size_t seuil_bas){
+    if(lot_min < 1)
+        lot_min = 1;
+    if(lot_max < lot_min)
+        lot_max = lot_min;
+    
+    info->lot_min = lot_min;
+    info->lot_max = lot_max;
+    info->seuil_bas = seuil_bas;
+}
+    
+/*!
+    \brief Has the nodes that ran out of tasks take some from the queues of the other nodes, rather than stay idle.
+    
+    \note A node takes the second half of the longest queue, before asking the master server for work. The
+          result of a task is still submitted under the id of the node that fetched it.
+    \note Only worth it when the tasks are fetched by batches (see configurer_lots()): a long task then
+          no longer holds back the tasks queued behind it.
+    
+    \param info The master info.
+    \param actif Whether the nodes take tasks from the others.
+*/
+void configurer_vol_taches(csc_master_info* info, bool actif){
+    info->vol_taches = actif;
+}
+    
+/*!
+    \brief Fetches tasks for the node from the master server, and waits for them.
+    
+    \param info The master info.
+    \param mon_noeud The node.
+    \param nombre The number of tasks to ask for.
+    \param attente_ms How long the master may hold the request until it has work, in milliseconds; 0 if it should answer right away.
+    \return 0 if everything went well or an error code defined in cruesli.h.
+*/
+static int recharger_file(csc_master_info* info, csc_node_info* mon_noeud, size_t nombre, long attente_ms){
+    csc_file_taches* file = mon_noeud->taches;
+    int retcode = preparer_requete_travail(info, mon_noeud, nombre, attente_ms);
+    
+    if(retcode != CSC_NO_ERROR){
+        transfert_liberer(&file->recharge);
+        return retcode;
+    }
+    
+    return integrer_reponse_travail(mon_noeud, executer_requete(info, file->recharge.handler, &file->recharge.ecriture, true, API_TRAVAIL, attente_ms > 0), attente_ms > 0);
+}
+    
+/*!
+    \brief Takes tasks from the longest queue of the other nodes, for a node that ran out of them.
+    
+    \param info The master info.
+    \param mon_noeud The node; the tasks are appended to its queue.
+    \return The number of tasks taken.
+*/
+static size_t voler_taches(csc_master_info* info, csc_node_info* mon_noeud){
+    csc_node_info* victime = NULL;
+    csc_node_info* noeud = NULL;
+    csc_tache* taches = NULL;
+    csc_tache* tache = NULL;
+    size_t longueur, plus_longue = 0;
+    size_t nombre = 0;
+    
+    if(!info->vol_taches)
+        return 0;
+    
+    // The victim can't be removed while we take its tasks
+    pthread_rwlock_rdlock(&g_noeuds_lock);
+    
+    for(noeud = info->nodes; noeud; noeud = noeud->next){
+        if(noeud == mon_noeud)
+            continue;
+        longueur = file_longueur(noeud->taches);
+        if(longueur > plus_longue){
+            plus_longue = longueur;
+            victime = noeud;
+        }
+    }
+    
+    // The queue may have shrunk since: we take what's left of it
+    if(victime){
+        taches = file_ceder(victime->taches, &nombre);
+        for(tache = taches; tache; tache = tache->suivante)
+            tache_preter(tache, victime);
+        file_accueillir(mon_noeud->taches, taches, nombre);
+    }
+    
+    pthread_rwlock_unlock(&g_noeuds_lock);
+    
+    return nombre;
+}
+    
+/*!
+    \brief Waits until the master server has work for the node: with long polls, or else by backing off.
+    
+    \param info The master info.
+    \param mon_noeud The node; its queue is empty.
+    \param nombre The number of tasks to ask for.
+    \return 0 once there's work, CSC_NO_MORE_WORK if the node gave up waiting, or an error code defined in cruesli.h.
+*/
+static int attendre_travail(csc_master_info* info, csc_node_info* mon_noeud, size_t nombre){
+    csc_attente* attente = (csc_attente*)info->attente;
+    csc_file_taches* file = mon_noeud->taches;
+    double echeance = attente->max_ms > 0 ? temps_monotone() + attente->max_ms*1e-3 : 0.0;
+    double debut;
+    long longpoll;
+    unsigned tentative = 0;
+    bool depart;
+    int retcode = CSC_NO_MORE_WORK;
+    
+    while(retcode == CSC_NO_MORE_WORK && !file_longueur(file) && !attente_finie(attente, echeance)){
+        pthread_mutex_lock(&attente->verrou);
+        depart = mon_noeud->depart;
+        pthread_mutex_unlock(&attente->verrou);
+        if(depart)
+            break;
+        
+        longpoll = attente_longpoll(attente, echeance, ((csc_reprise*)info->reprise)->delai_total_ms);
+        debut = temps_monotone();
+        retcode = recharger_file(info, mon_noeud, nombre, longpoll);
+        if(retcode != CSC_NO_MORE_WORK)
+            break;
+        
+        // The master held the request: it can be asked again right away, it'll answer as soon as it has work
+        if(longpoll && temps_monotone() - debut >= longpoll*1e-3/2){
+            attente_noter_longpoll(attente);
+            tentative = 0;
+            continue;
+        }
+        
+        // The other nodes may still hold tasks
+        if(voler_taches(info, mon_noeud)){
+            retcode = CSC_NO_ERROR;
+            break;
+        }
+        
+        // It answered right away: it can't hold requests, so we back off
+        if(!attente_dormir(attente, tentative++, echeance))
+            break;
+    }
+    
+    return retcode;
+}
+    
+/*!
+    \brief Takes the next task of the node, from its queue or from the master server.
+    
+    \param info The master info.
+    \param mon_noeud The node that needs to be allocated work.
+    \param retcode Where the error code is written if there's no task.
+    \return The task, or NULL if there's none.
+*/
+static csc_tache* obtenir_tache(csc_master_info* info, csc_node_info* mon_noeud, int* retcode){
+    
+    csc_file_taches* file = mon_noeud->taches;
+    csc_tache* tache = NULL;
+    size_t nombre;
+    
+    *retcode = CSC_NO_ERROR;
+    
+    // A refill that's already over is collected. If it failed while there are still tasks in the queue,
+    // it'll be retried later.
+    if(file->recharge.requete && moteur_requete_terminee((csc_requete*)file->recharge.requete)){
+        *retcode = recuperer_recharge(info, mon_noeud);
+    }
+    
+    // The queue may be empty, or emptied by other nodes in the meantime: the tasks of the others come first,
+    // then those of the refill in flight, then those of a new one
+    tache = file_retirer(file);
+    if(!tache && voler_taches(info, mon_noeud))
+        tache = file_retirer(file);
+    
+    if(!tache && file->recharge.requete){
+        *retcode = recuperer_recharge(info, mon_noeud);
+        tache = file_retirer(file);
+    }
+    
+    if(!tache){
+        // Enough for us and for the task handles that are waiting as well
+        nombre = file->lot > file->reservations + 1 ? file->lot : file->reservations + 1;
+        if(nombre > info->lot_max)
+            nombre = info->lot_max;
+        
+        *retcode = recharger_file(info, mon_noeud, nombre, 0);
+        
+        // No work for now: in wait-for-work mode, the node waits for some instead of giving up
+        if(*retcode == CSC_NO_MORE_WORK && ((csc_attente*)info->attente)->active)
+            *retcode = attendre_travail(info, mon_noeud, nombre);
+        // Otherwise, the master may have handed its last tasks to the others
+        else if(*retcode == CSC_NO_MORE_WORK && voler_taches(info, mon_noeud))
+            *retcode = CSC_NO_ERROR;
+        
+        tache = file_retirer(file);
+    }
+    
+    if(!tache){
+        // The server didn't give us anything
+        if(*retcode == CSC_NO_ERROR)
+            *retcode = CSC_ERR_NONFATAL_MISSINGINFO;
+        return NULL;
+    }
+    
+    // Refilling in the background, while the node works
+    file_ajuster_lot(file, info->lot_min, info->lot_max);
+    if(info->lot_max > 1 && file_longueur(file) <= info->seuil_bas){
+        lancer_recharge(info, mon_noeud, file->lot);
+    }
+    
+    return tache;
+}
+    
+/*!
+    \brief Asks the master server to allocate a task for the node mon_noeud.
+    
+    \note If batching is enabled (see configurer_lots()), the task may come from the local queue of the node.
+    
+    \param info The master info.
+    \param mon_noeud The node that needs to be allocated work.
+    \return 0 if everything went well or an error code defined in cruesli.h.
+                    
+*/
+int allouer_travail(csc_master_info* info, csc_node_info* mon_noeud){
+    
+    //csc_node_info* mon_noeud = trouver_noeud_par_id(info, id_noeud);
+    
+    
+    if(!mon_noeud || !info)
+        return CSC_FATAL_NULL_INFO;
+    
+    int retcode = CSC_NO_ERROR;
+    csc_file_taches* file = mon_noeud->taches;
+    csc_tache* tache = NULL;
+    
+    file_noter_allocation(file, temps_monotone());
+    
+    // The previous task is over
+    detruire_tache(mon_noeud->tache_courante);
+    mon_noeud->tache_courante = NULL;
+    
+    tache = obtenir_tache(info, mon_noeud, &retcode);
+    if(tache){
+        // Lecture + conversion/assignation
+        retcode = charger_tache(info, tache, mon_noeud);
+        mon_noeud->tache_courante = tache;
+    }
+    
+    file->fin_allocation = temps_monotone();
+    
+    return retcode;
+}
+    
+/*!
+    \brief Sends a batch of buffered results to the master server, and dispatches the status of each of them.
+    
+    \param info The master info.
+    \param lot The list of results.
+*/
+static void envoyer_lot_resultats(csc_master_info* info, csc_resultat* lot){
+    
+    csc_groupe_soumission* groupe = (csc_groupe_soumission*)info->soumission;
+    www_transfert* transfert = &groupe->envoi;
+    
+    int retcode = CSC_NO_ERROR;
+    
+    www_writestruct* sortie = &transfert->sortie;
+    size_t nombre = 0;
+    bool idempotent = true;
+    
+    csc_resultat* resultat = NULL;
+    cJSON* reponse = NULL;
+    cJSON* json_code_statut = NULL;
+    cJSON* json_codes = NULL;
+    cJSON* json_code = NULL;
+    
+    // The batch can be sent again only if the server can tell every result apart from a copy of it
+    for(resultat = lot; resultat; resultat = resultat->suivant){
+        nombre++;
+        idempotent = idempotent && resultat->avec_id;
+    }
+    
+    ecriture_vider(sortie);
+    
+    if(info->format == CSC_FORMAT_CBOR){
+        cbor_tampon tampon;
+        emprunter_tampon(sortie, &tampon);
+        
+        cbor_ecrire_entete(&tampon, CBOR_MAP, 2);
+        cbor_ecrire_texte(&tampon, "mastertoken");
+        cbor_ecrire_texte(&tampon, info->authcode);
+        cbor_ecrire_texte(&tampon, "results");
+        cbor_ecrire_entete(&tampon, CBOR_TABLEAU, nombre);
+        for(resultat = lot; resultat; resultat = resultat->suivant)
+            cbor_ecrire_brut(&tampon, resultat->donnees, resultat->taille);
+        
+        rendre_tampon(sortie, &tampon);
+        goto envoi;
+    }
+    
+    /* {"mastertoken": ..., "results": [ ... ]} is assembled from the serialized results */
+    JSON_ECRIRE_LITTERAL(sortie, "{\"mastertoken\":");
+    json_ecrire_texte(sortie, info->authcode);
+    JSON_ECRIRE_LITTERAL(sortie, ",\"results\":[");
+    for(resultat = lot; resultat; resultat = resultat->suivant){
+        json_ecrire_brut(sortie, resultat->donnees, resultat->taille);
+        if(resultat->suivant)
+            JSON_ECRIRE_LITTERAL(sortie, ",");
+    }
+    JSON_ECRIRE_LITTERAL(sortie, "]}");
+    
+envoi:
+    preparer_transfert(info, transfert, sortie->ptr, sortie->size);
+    
+    retcode = executer_requete(info, transfert->handler, &transfert->ecriture, idempotent, API_SOUMISSION, false);
+    if(retcode != CSC_NO_ERROR)
+        goto statuts;
+    
+    reponse = analyser_reponse(transfert->handler, &transfert->ecriture);
+    
+    json_code_statut = cJSON_GetObjectItemCaseSensitive(reponse, "code");
+    if(!cJSON_IsNumber(json_code_statut)){
+        retcode = CSC_ERR_NONFATAL_MISSINGINFO;
+        goto statuts;
+    }
+    retcode = json_code_statut->valueint;
+    
+    // One status code per result, in the order they were sent
+    json_codes = cJSON_GetObjectItemCaseSensitive(reponse, "codes");
+    if(!cJSON_IsArray(json_codes))
+        json_codes = NULL;
+    
+statuts:
+    json_code = json_codes ? json_codes->child : NULL;
+    
+    pthread_mutex_lock(&groupe->verrou);
+    for(resultat = lot; resultat; resultat = resultat->suivant){
+        int statut = retcode;
+        if(json_code){
+            statut = cJSON_IsNumber(json_code) ? json_code->valueint : CSC_ERR_NONFATAL_MISSINGINFO;
+            json_code = json_code->next;
+        } else if(json_codes){
+            // The server sent less codes than there were results
+            statut = CSC_ERR_NONFATAL_MISSINGINFO;
+        }
+        // Only the first error is kept until the node reads it
+        if(statut != CSC_NO_ERROR && resultat->noeud->statut_differe == CSC_NO_ERROR)
+            resultat->noeud->statut_differe = statut;
+    }
+    pthread_mutex_unlock(&groupe->verrou);
+    
+    cJSON_Delete(reponse);
+    transfert_liberer(transfert);
+}
+    
+/*!
+    \brief The flushing thread: sends the buffered results whenever a threshold is hit.
+    
+    \param info The master info.
+    \return NULL
+*/
+static void* th_soumission(csc_master_info* info){
+    csc_groupe_soumission* groupe = (csc_groupe_soumission*)info->soumission;
+    csc_resultat* lot = NULL;
+    
+    while((lot = groupe_attendre_lot(groupe))){
+        envoyer_lot_resultats(info, lot);
+        groupe_lot_envoye(groupe, lot);
+    }
+    
+    return NULL;
+}
+    
+/*!
+    \brief Enables grouped submissions: the results of all the nodes are buffered and sent together.
+    
+    \note The buffered results are sent as soon as one of the thresholds is hit.
+    \note In this mode, soumettre_travail() returns as soon as the result is buffered. If the submission
+          of a result fails, the error is returned by the next call to soumettre_travail() for the same node.
+    
+    \param info The master info.
+    \param seuil_nombre The number of buffered results that triggers a flush.
+    \param seuil_taille The size of the buffered results, in bytes, that triggers a flush.
+    \param delai_max_ms How long a result may be buffered, in milliseconds.
+*/
+void configurer_soumission_groupee(csc_master_info* info, size_t seuil_nombre, size_t seuil_taille, long delai_max_ms){
+    csc_groupe_soumission* groupe = (csc_groupe_soumission*)info->soumission;
+    sigset_t signaux, masque;
+    
+    if(groupe){
+        pthread_mutex_lock(&groupe->verrou);
+        groupe->seuil_nombre = seuil_nombre;
+        groupe->seuil_taille = seuil_taille;
+        groupe->delai_max = delai_max_ms/1000.0;
+        pthread_cond_signal(&groupe->reveil);
+        pthread_mutex_unlock(&groupe->verrou);
+        return;
+    }
+    
+    groupe = groupe_creer(seuil_nombre, seuil_taille, delai_max_ms/1000.0);
+    groupe->envoi.handler = nouveau_handler();
+    info->soumission = groupe;
+    
+    // SIGTERM and SIGINT are left to the other threads: executer_cascada() waits for them there
+    sigemptyset(&signaux);
+    sigaddset(&signaux, SIGTERM);
+    sigaddset(&signaux, SIGINT);
+    pthread_sigmask(SIG_BLOCK, &signaux, &masque);
+    
+    if(pthread_create(&groupe->thread, NULL, (void*)th_soumission, info)){
+        die("Could not spawn the submission thread");
+    }
+    
+    pthread_sigmask(SIG_SETMASK, &masque, NULL);
+}
+    
+/*!
+    \brief Sends the buffered results right away, and waits until they are sent.
+    
+    \param info The master info.
+*/
+void vider_soumissions(csc_master_info* info){
+    if(info->soumission)
+        groupe_vider((csc_groupe_soumission*)info->soumission);
+}
+    
+/*!
+    \brief Stops grouped submissions, after sending the buffered results.
+    
+    \param info The master info.
+*/
+static void arreter_soumission_groupee(csc_master_info* info){
+    csc_groupe_soumission* groupe = (csc_groupe_soumission*)info->soumission;
+    
+    if(!groupe)
+        return;
+    
+    groupe_arreter(groupe);
+    pthread_join(groupe->thread, NULL);
+    
+    curl_easy_cleanup((CURL*)groupe->envoi.handler);
+    groupe_detruire(groupe);
+    info->soumission = NULL;
+}
+    
+// The steps of a submission being produced
+#define FLUX_ENTETE     0   /* The token, the ids, up to the opening of the payload */
+#define FLUX_VARIABLES  1   /* One variable at a time */
+#define FLUX_FIN        2   /* The closing of the payload and of the submission */
+#define FLUX_TERMINE    3
+    
+// A submission, produced one piece at a time in the negotiated format
+typedef struct csc_flux_soumission {
+    csc_master_info* info;
+    csc_node_info* noeud;
+    csc_tache* tache;
+    bool avec_token;
+    
+    int etape;                  // FLUX_...
+    csc_plan* plan;             // The node's plan, up to date
+    size_t suivante;            // The next entry of the plan
+    bool premiere;              // No variable was written yet
+    
+    www_writestruct* sortie;    // Where the pieces are appended
+    size_t lu;                  // What curl already took from sortie, when the submission is streamed
+    int retcode;
+} csc_flux_soumission;
+    
+/*!
+    \brief Gets ready to produce a submission: the node's id, the task's id and the payload.
+    
+    \param flux The submission.
+    \param info The master info.
+    \param mon_noeud The node which work should be submitted; its plan must be up to date.
+    \param tache The task being submitted, or NULL.
+    \param avec_token Whether the master token should be included.
+    \param sortie Where the submission is written.
+*/
+static void commencer_soumission(csc_flux_soumission* flux, csc_master_info* info, csc_node_info* mon_noeud, csc_tache* tache, bool avec_token, www_writestruct* sortie){
+    flux->info = info;
+    flux->noeud = mon_noeud;
+    flux->tache = tache;
+    flux->avec_token = avec_token;
+    flux->etape = FLUX_ENTETE;
+    flux->plan = (csc_plan*)mon_noeud->plan;
+    flux->suivante = 0;
+    flux->premiere = true;
+    flux->sortie = sortie;
+    flux->lu = 0;
+    flux->retcode = CSC_NO_ERROR;
+}
+    
+/*!
+    \brief Starts producing a submission again from the start, so that it can be sent again.
+    
+    \param flux The submission.
+*/
+static void reprendre_soumission(csc_flux_soumission* flux){
+    flux->sortie->size = 0;
+    commencer_soumission(flux, flux->info, flux->noeud, flux->tache, flux->avec_token, flux->sortie);
+}
+    
+/*!
+    \brief Writes the beginning of a submission, up to the opening of its payload.
+    
+    \param flux The submission.
+    \return false if it can't be written; flux->retcode tells why.
+*/
+static bool ecrire_entete_soumission(csc_flux_soumission* flux){
+    csc_master_info* info = flux->info;
+    // A task taken from another node is submitted under the id of the node that fetched it
+    csc_node_info* noeud = flux->tache && flux->tache->origine ? flux->tache->origine : flux->noeud;
+    www_writestruct* sortie = flux->sortie;
+    bool avec_id = flux->tache && flux->tache->id;
+    // Without the token, the node's precomputed prefix is taken from its id on
+    size_t debut = flux->avec_token ? 0 : noeud->debut_nodeid;
+    
+    if(info->format == CSC_FORMAT_CBOR){
+        cbor_tampon tampon;
+        bool ok = true;
+        emprunter_tampon(sortie, &tampon);
+        
+        cbor_ecrire_entete(&tampon, CBOR_MAP, 2 + flux->avec_token + avec_id);
+        cbor_ecrire_brut(&tampon, noeud->prefixe + debut, noeud->taille_prefixe - debut);
+        // The server told us which task it was: we tell it back
+        if(avec_id){
+            cbor_ecrire_texte(&tampon, "taskid");
+            ok = cbor_ecrire_json(&tampon, flux->tache->id);
+        }
+        cbor_ecrire_texte(&tampon, "payload");
+        cbor_ecrire_entete(&tampon, CBOR_MAP, flux->plan->nombre);
+        
+        rendre_tampon(sortie, &tampon);
+        if(!ok)
+            flux->retcode = CSC_ERR_FATAL_JSON_INTERNAL;
+        return ok;
+    }
+    
+    JSON_ECRIRE_LITTERAL(sortie, "{");
+    json_ecrire_brut(sortie, noeud->prefixe + debut, noeud->taille_prefixe - debut);
+    // The server told us which task it was: we tell it back
+    if(avec_id){
+        JSON_ECRIRE_LITTERAL(sortie, ",\"taskid\":");
+        if(!json_ecrire_json(sortie, flux->tache->id)){
+            flux->retcode = CSC_ERR_FATAL_JSON_INTERNAL;
+            return false;
+        }
+    }
+    JSON_ECRIRE_LITTERAL(sortie, ",\"payload\":{");
+    
+    return true;
+}
+    
+/*!
+    \brief Writes a variable of the payload, straight from the variable bound by the node.
+    
+    \param flux The submission.
+    \param var_local The entry of the plan.
+    \return false if it can't be written; flux->retcode tells why.
+*/
+static bool ecrire_variable_soumission(csc_flux_soumission* flux, const csc_var* var_local){
+    www_writestruct* sortie = flux->sortie;
+    bool ok = true;
+    
+    if(flux->info->format == CSC_FORMAT_CBOR){
+        cbor_tampon tampon;
+        emprunter_tampon(sortie, &tampon);
+        cbor_ecrire_texte(&tampon, var_local->name);
+        ok = cbor_ecrire_var(&tampon, var_local);
+        rendre_tampon(sortie, &tampon);
+    } else {
+        if(!flux->premiere)
+            JSON_ECRIRE_LITTERAL(sortie, ",");
+        json_ecrire_texte(sortie, var_local->name);
+        JSON_ECRIRE_LITTERAL(sortie, ":");
+        ok = json_ecrire_var(sortie, var_local);
+    }
+    flux->premiere = false;
+    
+    if(!ok)
+        flux->retcode = CSC_ERR_FATAL_INVALID_TYPE;
+    return ok;
+}
+    
+/*!
+    \brief Appends the next piece of a submission to its output.
+    
+    \param flux The submission.
+    \return false once the submission is over, or if it can't be produced (then flux->retcode tells why).
+*/
+static bool produire_soumission(csc_flux_soumission* flux){
+    csc_var champ;
+    bool ok = true;
+    
+    switch (flux->etape) {
+        case FLUX_ENTETE:
+            ok = ecrire_entete_soumission(flux);
+            flux->etape = FLUX_VARIABLES;
+            break;
             
-            local_var = recup_variable(var->string, mon_noeud->localvars);
-            if(!local_var){
-                // Variable pas trouvée -> erreur critique;
-                retcode = CSC_ERR_FATAL_UNREGISTERED_VAR;
-                goto end2;
+        case FLUX_VARIABLES:
+            if(flux->suivante < flux->plan->nombre){
+                ok = ecrire_variable_soumission(flux, plan_variable(flux->plan, &flux->plan->entrees[flux->suivante++], &champ));
+                break;
             }
+            flux->etape = FLUX_FIN;
+            // fall through
             
-            // On convertit la variable...
-            switch (local_var->type) {
-                case VARTYPE_FLOAT:
-                    *((float*)(local_var->value))  = (float)var->valuedouble;
-                    break;
-                case VARTYPE_DOUBLE:
-                    *((double*)(local_var->value))  = (double)var->valuedouble;
-                    break;
-                case VARTYPE_U8:
-                    *((uint8_t*)(local_var->value))  = (uint8_t)var->valueint;
-                    break;
-                case VARTYPE_U32:
-                    *((uint32_t*)(local_var->value)) = (uint32_t)var->valueint;
-                    break;
-                case VARTYPE_U64:
-                    *((uint64_t*)(local_var->value)) = (uint64_t)var->valueint;
-                    break;
-                case VARTYPE_I32:
-                    *((int32_t*)(local_var->value))  = (int32_t)var->valueint;
-                    break;
-                case VARTYPE_I64:
-                    *((int64_t*)(local_var->value))  = (int64_t)var->valueint;
-                    break;
-                default:
-                    // Variable non supportée...
-                    retcode = CSC_ERR_FATAL_INVALID_TYPE;
-                    break;
+        case FLUX_FIN:
+            // Nothing to close in CBOR: the maps have a definite length
+            if(flux->info->format != CSC_FORMAT_CBOR)
+                JSON_ECRIRE_LITTERAL(flux->sortie, "}}");
+            flux->etape = FLUX_TERMINE;
+            break;
+            
+        default:
+            return false;
+    }
+    
+    if(!ok)
+        flux->etape = FLUX_TERMINE;
+    return ok;
+}
+    
+/*!
+    \brief Serializes a submission in the negotiated format, in a single pass over the node's variables.
+    
+    \param info The master info.
+    \param mon_noeud The node which work should be submitted; its plan must be up to date.
+    \param tache The task being submitted, or NULL.
+    \param avec_token Whether the master token should be included.
+    \param sortie The buffer the submission is written in; its memory is reused from one submission to the next.
+    \return 0 if everything went well or an error code defined in cruesli.h.
+*/
+static int serialiser_soumission(csc_master_info* info, csc_node_info* mon_noeud, csc_tache* tache, bool avec_token, www_writestruct* sortie){
+    csc_flux_soumission flux;
+    
+    ecriture_vider(sortie);
+    commencer_soumission(&flux, info, mon_noeud, tache, avec_token, sortie);
+    while(produire_soumission(&flux));
+    
+    if(flux.retcode != CSC_NO_ERROR)
+        ecriture_vider(sortie);
+    return flux.retcode;
+}
+    
+/*!
+    \brief Read callback of a streamed submission: produces the body as curl sends it.
+    
+    \param buffer Where curl wants the body.
+    \param size Always 1.
+    \param nitems The size of buffer.
+    \param flux The submission.
+    \return The number of bytes written; 0 once the submission is over.
+*/
+static size_t lire_soumission(char* buffer, size_t size, size_t nitems, csc_flux_soumission* flux){
+    size_t capacite = size*nitems;
+    size_t ecrit = 0;
+    size_t morceau = 0;
+    
+    while(ecrit < capacite){
+        // What was produced is sent: the next piece reuses the buffer
+        if(flux->lu == flux->sortie->size){
+            ecriture_vider(flux->sortie);
+            flux->lu = 0;
+            if(!produire_soumission(flux)){
+                if(flux->retcode != CSC_NO_ERROR)
+                    return CURL_READFUNC_ABORT;
+                break;
             }
+            continue;
         }
+        
+        morceau = flux->sortie->size - flux->lu;
+        if(morceau > capacite - ecrit)
+            morceau = capacite - ecrit;
+        memcpy(buffer + ecrit, flux->sortie->ptr + flux->lu, morceau);
+        flux->lu += morceau;
+        ecrit += morceau;
     }
     
+    return ecrit;
+}
     
+/*!
+    \brief Reads the answer of the server to a submission.
     
+    \param transfert The transfer of the submission.
+    \param statut The status of the request, once its retries are over.
+    \return The status sent by the server, or an error code defined in cruesli.h.
+*/
+static int lire_reponse_soumission(www_transfert* transfert, int statut){
+    int retcode = CSC_NO_ERROR;
+    cJSON* reponse = NULL;
+    cJSON* json_code_statut = NULL;
     
+    if(statut != CSC_NO_ERROR){
+        retcode = statut;
+        goto end;
+    }
     
-end2:
-    cJSON_Delete(reponse);
+    reponse = analyser_reponse(transfert->handler, &transfert->ecriture);
+    
+    json_code_statut = cJSON_GetObjectItemCaseSensitive(reponse, "code");
+    if(!cJSON_IsNumber(json_code_statut)){
+        retcode = CSC_ERR_NONFATAL_MISSINGINFO;
+        goto end;
+    }
+    retcode = json_code_statut->valueint;
     
 end:
-    cJSON_Delete(base);
-    free(writestruct.ptr);
-    free(url_complete);
-    free(str);
+    cJSON_Delete(reponse);
+    transfert_liberer(transfert);
     
+    return retcode;
+}
     
+/*!
+    \brief Submits the result of mon_noeud's work for a task.
     
-    return retcode;
+    \param info The master info.
+    \param mon_noeud The node which work should be submitted.
+    \param tache The task, or NULL if the server did not give it an id.
+    \param transfert The transfer to use; it is posted to the network engine if asynchrone is true.
+    \param asynchrone Whether to return as soon as the request is posted, instead of waiting for its result.
+    \return 0 if everything went well or an error code defined in cruesli.h.
+*/
+static int envoyer_soumission(csc_master_info* info, csc_node_info* mon_noeud, csc_tache* tache, www_transfert* transfert, bool asynchrone){
+    
+    int retcode = CSC_NO_ERROR;
+    char* str = NULL;
+    csc_flux_soumission flux;
+    // The server can recognize a submission it already has from the id of its task
+    bool idempotent = tache && tache->id;
+    CURLcode res;
+    csc_serveur* serveur = NULL;
+    
+    retcode = preparer_plan(info, mon_noeud);
+    if(retcode != CSC_NO_ERROR)
+        return retcode;
+    
+    // Grouped submission: the result is buffered, and we report the errors of the previous ones
+    if(info->soumission){
+        csc_groupe_soumission* groupe = (csc_groupe_soumission*)info->soumission;
+        
+        retcode = serialiser_soumission(info, mon_noeud, tache, false, &transfert->sortie);
+        if(retcode != CSC_NO_ERROR)
+            return retcode;
+        // The buffered result outlives the transfer: it gets a copy of its own
+        str = safe_malloc(transfert->sortie.size);
+        memcpy(str, transfert->sortie.ptr, transfert->sortie.size);
+        groupe_ajouter(groupe, mon_noeud, str, transfert->sortie.size, idempotent);
+        ecriture_vider(&transfert->sortie);
+        
+        pthread_mutex_lock(&groupe->verrou);
+        retcode = mon_noeud->statut_differe;
+        mon_noeud->statut_differe = CSC_NO_ERROR;
+        pthread_mutex_unlock(&groupe->verrou);
+        
+        return retcode;
+    }
+    
+    // A large submission is streamed rather than built in memory; the variables are read while
+    // the body is being sent, so the node must be waiting for the request to be over
+    if(info->seuil_flux && !(asynchrone && info->moteur)){
+        if(((csc_plan*)mon_noeud->plan)->taille_json >= info->seuil_flux){
+            commencer_soumission(&flux, info, mon_noeud, tache, true, &transfert->sortie);
+            transfert_diffuser(transfert, (www_entetes*)info->entetes, (curl_read_callback)lire_soumission, &flux, info->format);
+            annoncer_encodages(info, transfert->handler);
+            
+            // The body is produced again from the start if the request has to be retried
+            serveur = engager_requete(info, transfert->handler, API_SOUMISSION, NULL);
+            res = serveur ? tenter_requete(info, transfert->handler) : CURLE_OK;
+            retcode = lire_reponse_soumission(transfert, conclure_requete(info, transfert->handler, &transfert->ecriture, idempotent, API_SOUMISSION, serveur, res, &flux, false));
+            return flux.retcode != CSC_NO_ERROR ? flux.retcode : retcode;
+        }
+    }
+    
+    retcode = serialiser_soumission(info, mon_noeud, tache, true, &transfert->sortie);
+    if(retcode != CSC_NO_ERROR)
+        return retcode;
+    
+    preparer_transfert(info, transfert, transfert->sortie.ptr, transfert->sortie.size);
+    
+    // While the breaker sheds the requests, the node waits for it like a synchronous submission would
+    serveur = engager_requete(info, transfert->handler, API_SOUMISSION, NULL);
+    if(asynchrone && info->moteur && serveur){
+        transfert->serveur = serveur;
+        transfert->requete = poster_requete(info, transfert->handler);
+        return CSC_NO_ERROR;
+    }
+    
+    res = serveur ? tenter_requete(info, transfert->handler) : CURLE_OK;
+    return lire_reponse_soumission(transfert, conclure_requete(info, transfert->handler, &transfert->ecriture, idempotent, API_SOUMISSION, serveur, res, NULL, false));
 }
-
-
+    
 /*!
     \brief Submits the result of mon_noeud's work.
     
+    \note If grouped submissions are enabled (see configurer_soumission_groupee()), the result is only buffered.
+    
     \param info The master info.
     \param mon_noeud The node which work should be submitted.
     \return 0 if everything went well or an error code defined in cruesli.h.
@@ -701,139 +2837,179 @@ int soumettre_travail(csc_master_info* info, csc_node_info* mon_noeud){
     if(!mon_noeud || !info)
         return CSC_FATAL_NULL_INFO;
     
+    // The node's handler is its own: no need to take g_net_lock
+    return envoyer_soumission(info, mon_noeud, mon_noeud->tache_courante, &mon_noeud->taches->envoi, false);
+}
     
-    int retcode = CSC_NO_ERROR;
-    char url[] = "/api/v1/submit-results";
+/*!
+    \brief Starts fetching a task for the node, and returns a handle to it.
     
-    struct curl_slist *headers = NULL;
-    www_writestruct writestruct = { .ptr = NULL, .size = 0};
+    \note With the network engine running, the task is fetched in the background; the node
+          can keep working on its current task in the meantime.
     
-    char* url_complete = strconc(info->server_base_url, url);
-    char* str = NULL;
+    \param info The master info.
+    \param mon_noeud The node that needs to be allocated work.
+    \return The handle of the task, to be given to demarrer_tache().
+*/
+csc_tache* prelever_tache(csc_master_info* info, csc_node_info* mon_noeud){
     
+    if(!mon_noeud || !info)
+        return NULL;
     
+    int retcode = CSC_NO_ERROR;
+    csc_file_taches* file = mon_noeud->taches;
+    csc_tache* tache = NULL;
+    size_t nombre;
+    
+    // A task is already there...
+    if(file_longueur(file) && !file->reservations){
+        tache = obtenir_tache(info, mon_noeud, &retcode);
+        if(tache)
+            return tache;
+    }
     
-    cJSON* reponse = NULL;
-    cJSON* json_code_statut = NULL;
-    cJSON* json_payload = NULL;
+    tache = nouvelle_tache();
+    file->reservations += 1;
     
-    /* Là on construit la requête */
-    cJSON* base = cJSON_CreateObject();
-    if(!base){
-        retcode = CSC_ERR_FATAL_JSON_INTERNAL;
-        goto end;
-    }
-    cJSON* json_token = cJSON_CreateString(info->authcode);
-    if(!json_token){
-        retcode = CSC_ERR_FATAL_JSON_INTERNAL;
-        goto end;
+    // ...or it'll be: we make sure the queue is being refilled
+    if(info->moteur){
+        if(file_longueur(file) < file->reservations){
+            nombre = file->lot > file->reservations ? file->lot : file->reservations;
+            if(nombre > info->lot_max)
+                nombre = info->lot_max;
+            lancer_recharge(info, mon_noeud, nombre);
+        }
     }
-    cJSON_AddItemToObject(base, "mastertoken", json_token);
     
-    cJSON* json_idnoeud = cJSON_CreateString(mon_noeud->id);
-    if(!json_idnoeud){
-        retcode = CSC_ERR_FATAL_JSON_INTERNAL;
-        goto end;
-    }
-    cJSON_AddItemToObject(base, "nodeid", json_idnoeud);
+    return tache;
+}
     
+/*!
+    \brief Waits for the task of a handle, and writes its values into the variables bound by the node.
     
-    json_payload = cJSON_CreateObject();
-    if(!json_payload){
-        retcode = CSC_ERR_FATAL_JSON_INTERNAL;
-        goto end;
-    }
+    \param info The master info.
+    \param mon_noeud The node that fetched the task.
+    \param tache The handle returned by prelever_tache().
+    \return 0 if everything went well or an error code defined in cruesli.h.
+*/
+int demarrer_tache(csc_master_info* info, csc_node_info* mon_noeud, csc_tache* tache){
     
-    // We start by copying the input scheme
-    {
-        csc_var_list* var_iter_cour = info->sch_in;
-        csc_var* var_local     = NULL;
-        cJSON*   json_valeur = NULL;
-        while(var_iter_cour){
-            if(var_iter_cour->local){
-                var_local = recup_variable(var_iter_cour->local->name, mon_noeud->localvars);
-                // The requested local variable does not exist...
-                if(!var_local){
-                    retcode = CSC_ERR_FATAL_UNREGISTERED_VAR;
-                    goto end;
-                }
-                json_valeur = cJSON_CreateNumber(var2double(var_local));
-                
-                cJSON_AddItemToObject(json_payload, var_local->name, json_valeur);
-            }
-            var_iter_cour = var_iter_cour->next;
-        }
+    if(!mon_noeud || !info || !tache)
+        return CSC_FATAL_NULL_INFO;
+    
+    int retcode = CSC_NO_ERROR;
+    csc_file_taches* file = mon_noeud->taches;
+    csc_tache* recue = NULL;
+    
+    file_noter_allocation(file, temps_monotone());
+    
+    if(!tache->recue){
+        file->reservations -= 1;
         
-        // And then the output scheme
-        var_iter_cour = info->sch_out;
-        while(var_iter_cour){
-            if(var_iter_cour->local){
-                var_local = recup_variable(var_iter_cour->local->name, mon_noeud->localvars);
-                // The requested local variable does not exist...
-                if(!var_local){
-                    retcode = CSC_ERR_FATAL_UNREGISTERED_VAR;
-                    goto end;
-                }
-                json_valeur = cJSON_CreateNumber(var2double(var_local));
-                cJSON_AddItemToObject(json_payload, var_local->name, json_valeur);
-            }
-            var_iter_cour = var_iter_cour->next;
+        recue = obtenir_tache(info, mon_noeud, &retcode);
+        tache->recue = true;
+        if(!recue){
+            tache->statut = retcode;
+            goto end;
         }
+        
+        tache->payload = recue->payload;
+        tache->taille_payload = recue->taille_payload;
+        tache->format = recue->format;
+        tache->id = recue->id;
+        tache->origine = recue->origine;
+        recue->payload = NULL;
+        recue->id = NULL;
+        recue->origine = NULL;
+        detruire_tache(recue);
     }
     
-    cJSON_AddItemToObject(base, "payload", json_payload);
+    // Already started, or its fetch failed
+    if(!tache->payload){
+        retcode = tache->statut != CSC_NO_ERROR ? tache->statut : CSC_ERR_NONFATAL_MISSINGINFO;
+        goto end;
+    }
     
-    str = cJSON_Print(base);
+    retcode = charger_tache(info, tache, mon_noeud);
     
-    pthread_mutex_lock(&g_net_lock);
+end:
+    file->fin_allocation = temps_monotone();
     
-    curl_easy_setopt((CURL*)info->handler, CURLOPT_URL, url_complete);
-    headers = curl_slist_append(headers, "Expect:");
-    headers = curl_slist_append(headers, "Content-Type: application/json");
-    curl_easy_setopt((CURL*)info->handler, CURLOPT_HTTPHEADER, headers);
+    return retcode;
+}
     
-    curl_easy_setopt((CURL*)info->handler, CURLOPT_POSTFIELDS, str);
-    curl_easy_setopt((CURL*)info->handler, CURLOPT_POSTFIELDSIZE, -1L);
+/*!
+    \brief Submits the values of the variables bound by the node as the result of a task.
     
-    curl_easy_setopt((CURL*)info->handler, CURLOPT_WRITEFUNCTION, dl2string);
-    curl_easy_setopt((CURL*)info->handler, CURLOPT_WRITEDATA, &writestruct);
+    \note The values are copied right away: the node can start working on its next task immediately.
+    \note With the network engine running, this function does not wait for the answer of the server;
+          liberer_tache() does.
     
-    CURLcode res = curl_easy_perform((CURL*)info->handler);
+    \param info The master info.
+    \param mon_noeud The node that computed the task.
+    \param tache The handle of the task.
+    \return 0 if everything went well so far or an error code defined in cruesli.h.
+*/
+int rendre_tache(csc_master_info* info, csc_node_info* mon_noeud, csc_tache* tache){
     
-    curl_slist_free_all(headers);
-
-    pthread_mutex_unlock(&g_net_lock);
-
-    if(res != CURLE_OK){
-        retcode = CSC_FATAL_CURL_ERROR;
-        goto end;
+    if(!mon_noeud || !info || !tache)
+        return CSC_FATAL_NULL_INFO;
+    
+    csc_file_taches* file = mon_noeud->taches;
+    
+    // Without the network engine, the submission is done right away with the node's own transfer
+    if(!info->moteur){
+        tache->statut = envoyer_soumission(info, mon_noeud, tache, &file->envoi, false);
+        return tache->statut;
     }
     
-
-    reponse = cJSON_Parse(writestruct.ptr);
+    // The submission gets its own handler, since it'll be in flight while the node does something else
+    if(!file_prendre_transfert(file, &tache->soumission))
+        tache->soumission.handler = nouveau_handler();
     
-    json_code_statut = cJSON_GetObjectItemCaseSensitive(reponse, "code");
-    if(!cJSON_IsNumber(json_code_statut)){
-        retcode = CSC_ERR_NONFATAL_MISSINGINFO;
-        goto end2;
+    tache->statut = envoyer_soumission(info, mon_noeud, tache, &tache->soumission, true);
+    
+    // Nothing in flight: the handler can be given back right away
+    if(!tache->soumission.requete)
+        file_rendre_transfert(file, &tache->soumission);
+    
+    return tache->statut;
+}
+    
+/*!
+    \brief Waits for the submission of a task to be over, and frees its handle.
+    
+    \param info The master info.
+    \param mon_noeud The node that computed the task.
+    \param tache The handle of the task.
+    \return The status of the submission: 0 if everything went well or an error code defined in cruesli.h.
+*/
+int liberer_tache(csc_master_info* info, csc_node_info* mon_noeud, csc_tache* tache){
+    
+    if(!mon_noeud || !info || !tache)
+        return CSC_FATAL_NULL_INFO;
+    
+    int retcode = tache->statut;
+    CURLcode res;
+    
+    if(tache->soumission.requete){
+        res = moteur_attendre((csc_requete*)tache->soumission.requete);
+        retcode = lire_reponse_soumission(&tache->soumission, conclure_requete(info, tache->soumission.handler, &tache->soumission.ecriture, tache->id != NULL, API_SOUMISSION, (csc_serveur*)tache->soumission.serveur, res, NULL, false));
+        tache->soumission.requete = NULL;
+        file_rendre_transfert(mon_noeud->taches, &tache->soumission);
     }
-    retcode = json_code_statut->valueint;
-
-end2:
-    cJSON_Delete(reponse);
     
-end:
-    cJSON_Delete(base);
-    free(writestruct.ptr);
-    free(url_complete);
-    free(str);
+    // A handle that never got its task still holds a reservation
+    if(!tache->recue)
+        mon_noeud->taches->reservations -= 1;
     
-    return retcode;
+    detruire_tache(tache);
     
+    return retcode;
 }
-
-
-
+    
+    
+    
 int connexion(char* adresse){
     CURL* monCurl = NULL;
     monCurl = curl_easy_init();
@@ -847,3 +3023,4 @@ int connexion(char* adresse){
     
     return 0;
 }
+    
\ No newline at end of file
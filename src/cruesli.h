@@ -18,11 +18,49 @@ csc_node_info* trouver_noeud_par_id(const csc_master_info* info, const char* nod
 
 csc_master_info init_cruesli(const char* url_serveur, const char* mdp);
 void cleanup_cruesli(csc_master_info* info);
+void demarrer_moteur_reseau(csc_master_info* info);
+void statistiques_reception(const csc_master_info* info, size_t* pic, size_t* agrandissements);
+void statistiques_reprises(const csc_master_info* info, size_t* reprises, size_t* declenchements, size_t* rejets);
+size_t nombre_serveurs(const csc_master_info* info);
+int statistiques_serveur(const csc_master_info* info, size_t indice, size_t* requetes, size_t* echecs, double* latence);
+void statistiques_attente(const csc_master_info* info, size_t* longpolls, size_t* sommeils);
+void arreter_moteur_reseau(csc_master_info* info);
+int configurer_compression(csc_master_info* info, int algo, size_t seuil);
+int configurer_format(csc_master_info* info, int format);
+void configurer_flux_soumission(csc_master_info* info, size_t seuil);
+void configurer_delais(csc_master_info* info, long connexion_ms, long total_ms);
+void configurer_reprises(csc_master_info* info, unsigned reprises_max, long attente_base_ms, long attente_max_ms);
+void configurer_disjoncteur(csc_master_info* info, unsigned seuil, long pause_ms);
+void configurer_bascule(csc_master_info* info, long pause_ms);
+void configurer_attente_travail(csc_master_info* info, bool active, long max_ms, long longpoll_ms, long plafond_ms);
+void interrompre_attente_travail(csc_master_info* info);
+void interrompre_attente_noeud(csc_master_info* info, csc_node_info* noeud);
 int connecter_cascada(csc_master_info* info, char* nom_suggere);
 int deconnecter_cascada(csc_master_info* info);
 int allouer_noeuds(csc_master_info* info, size_t nb_noeuds);
+int ajouter_noeud(csc_master_info* info, csc_node_info** noeud);
+int retirer_noeud(csc_master_info* info, csc_node_info* noeud);
+size_t conclure_retraits(csc_master_info* info, size_t* echecs);
+void configurer_lots(csc_master_info* info, size_t lot_min, size_t lot_max, size_t seuil_bas);
+void configurer_vol_taches(csc_master_info* info, bool actif);
 int allouer_travail(csc_master_info* info, csc_node_info* mon_noeud);
+void configurer_soumission_groupee(csc_master_info* info, size_t seuil_nombre, size_t seuil_taille, long delai_max_ms);
+void vider_soumissions(csc_master_info* info);
 int soumettre_travail(csc_master_info* info, csc_node_info* mon_noeud);
+csc_tache* prelever_tache(csc_master_info* info, csc_node_info* mon_noeud);
+int demarrer_tache(csc_master_info* info, csc_node_info* mon_noeud, csc_tache* tache);
+int rendre_tache(csc_master_info* info, csc_node_info* mon_noeud, csc_tache* tache);
+int liberer_tache(csc_master_info* info, csc_node_info* mon_noeud, csc_tache* tache);
+int lier_noeud(csc_master_info* info, csc_node_info* mon_noeud, size_t* manquantes, size_t* incompatibles);
+int lier_structure(csc_node_info* mon_noeud, const csc_champ* champs, size_t nombre, void* instance);
+void changer_instance(csc_node_info* mon_noeud, void* instance);
+csc_execution init_execution(csc_calcul calculer, void* contexte);
+int classer_erreur(int code);
+size_t cpus_disponibles(void);
+int executer_cascada(csc_master_info* info, const csc_execution* execution, csc_bilan* bilan);
+int placer_noeuds(csc_master_info* info, int politique, bool smt);
+int placer_noeud(csc_master_info* info, csc_node_info* noeud, int politique, bool smt);
+void afficher_placement(const csc_master_info* info);
 int connexion(char* adresse);
 
 #endif /* cruesli_h */
@@ -9,5 +9,18 @@
 #define CSC_ERR_FATAL_INVALID_TYPE      -5
 #define CSC_FATAL_NULL_INFO             -6
 #define CSC_FATAL_CURL_ERROR            -7
+#define CSC_ERR_NONFATAL_TIMEOUT        -8
+#define CSC_ERR_NONFATAL_CIRCUIT_OPEN   -9
+#define CSC_ERR_NONFATAL_UNSUPPORTED    -10
+#define CSC_ERR_NONFATAL_HTTP           -11
+
+// Sent by the master server
+#define CSC_NO_MORE_WORK                 7
+
+// What an error code means for the node that got it, see classer_erreur()
+#define CSC_CLASSE_SUCCES       0   // No error
+#define CSC_CLASSE_FIN          1   // The master has no more work: the node is done
+#define CSC_CLASSE_PASSAGERE    2   // The node may try again later
+#define CSC_CLASSE_FATALE       3   // Trying again won't help: the run should stop
 
 #endif
\ No newline at end of file
@@ -1,18 +1,61 @@
 #ifndef entites_h
 #define entites_h
 
+#include <stddef.h>
+#include <stdbool.h>
+
+// Compression algorithms, see configurer_compression()
+#define CSC_COMPRESSION_AUCUNE 0
+#define CSC_COMPRESSION_GZIP   1
+#define CSC_COMPRESSION_ZSTD   2
+
+// Wire formats, see configurer_format()
+#define CSC_FORMAT_JSON 0
+#define CSC_FORMAT_CBOR 1
+
+// How the nodes are spread over the CPUs, see placer_noeuds()
+#define CSC_PLACEMENT_AUCUN     0
+#define CSC_PLACEMENT_COMPACT   1
+#define CSC_PLACEMENT_DISPERSE  2
+
+// Handle of a task, see prelever_tache()
+typedef struct csc_tache csc_tache;
+
 
 typedef struct csc_node_info {
     char* id;
     struct csc_node_info* next;
     struct csc_var_list* localvars;
+    void* plan;      // Actually a csc_plan*: the variables of the schemes, resolved against localvars
+    void* handler;   // Actually a CURL*, private to the node
+    struct csc_file_taches* taches;     // Tasks allocated to the node but not yet handed over
+    struct csc_tache* tache_courante;   // The task handed over by allouer_travail()
+    int statut_differe;                 // First error of the node's grouped submissions, not yet reported
+    
+    char* prefixe;          // The master token and the node's id, as they begin its requests in the negotiated format
+    size_t taille_prefixe;
+    size_t debut_nodeid;    // Where the node's id starts in prefixe, for the requests without the token
+    
+    int cpu;                // The CPU the node's thread is pinned to, see placer_noeuds(); -1: anywhere
+    int numa;               // The NUMA node of that CPU; -1 if unknown
+    
+    bool depart;            // The node stops waiting for work, as it is about to be removed; under the lock of the wait
+    size_t taches_pretees;  // Tasks it fetched that other nodes hold, see tache_preter()
+    bool desinscription;    // Removed, and the master is still to be told, see conclure_retraits()
 } csc_node_info;
 
 typedef struct csc_master_info{
     char* authcode;
     struct csc_node_info* nodes;
+    struct csc_node_info* retires;  // Nodes removed by retirer_noeud(): tasks taken from them may still be submitted under their id
     void* handler;   // Actually a CURL*
+    void* moteur;    // Actually a csc_moteur*; NULL if the network engine is not running
+    void* soumission;   // Actually a csc_groupe_soumission*; NULL unless submissions are grouped
     char* server_base_url;
+    void* serveurs;         // Actually a csc_serveurs*: the master servers given by server_base_url, and their health
+    void* entetes;          // Actually a www_entetes*, shared by the requests of the nodes
+    void* reprise;          // Actually a csc_reprise*: the timeouts, retries and circuit breaker of the requests
+    void* attente;          // Actually a csc_attente*: how the nodes wait for work when the master has none
     char* mdp;
     char* nom;
     
@@ -21,6 +64,61 @@ typedef struct csc_master_info{
     
     struct csc_var_list* sch_in;
     struct csc_var_list* sch_out;
+    
+    int compression;            // CSC_COMPRESSION_...
+    size_t seuil_compression;   // Smaller request bodies are not compressed
+    
+    size_t seuil_flux;          // Larger submissions are streamed instead of being built in memory; 0: never
+    
+    int format_souhaite;    // CSC_FORMAT_..., offered to the server when connecting
+    int format;             // CSC_FORMAT_..., the one the server agreed to
+    
+    size_t lot_min;     // Batch size bounds when fetching tasks
+    size_t lot_max;
+    size_t seuil_bas;   // Low-water mark of the nodes' task queues
+    bool vol_taches;    // A node that ran out of tasks takes some from the queues of the others, see configurer_vol_taches()
+    bool retrait_noeuds;    // The master can release a single node (it said so when connecting), see retirer_noeud()
 } csc_master_info;
 
+
+// Called by executer_cascada() with the node, its instance of the structure and the context of the run
+typedef int (*csc_calcul)(csc_node_info* noeud, void* instance, void* contexte);
+
+// A run of the nodes managed by the library, see executer_cascada()
+typedef struct csc_execution {
+    size_t nb_noeuds;               // The nodes asked for if none were allocated yet; 0: as many as cpus_disponibles()
+    
+    const struct csc_champ* champs; // The fields bound to each node with lier_structure(), or NULL
+    size_t nb_champs;
+    size_t taille_instance;         // The size of the structure: each node gets its own instance, zeroed
+    
+    csc_calcul preparer;    // Called once by each node, in its thread, before its first task: binds other variables; or NULL
+    csc_calcul calculer;    // Computes a task, from the input variables to the output ones; anything but 0 drops the task
+    void* contexte;         // Given to preparer and calculer
+    
+    int placement;          // CSC_PLACEMENT_...: the nodes are placed anew, see placer_noeuds(); CSC_PLACEMENT_AUCUN keeps their placement
+    bool smt;               // Whether the nodes fill the hardware threads of a core before moving on to the next one
+    
+    size_t noeuds_min;      // With noeuds_max, the number of nodes follows the CPUs left free by the rest of the host
+    size_t noeuds_max;      // 0: the number of nodes stays the same
+    unsigned periode_ms;    // How often the number of nodes may change, by one
+    
+    bool signaux;           // SIGTERM and SIGINT stop the run cleanly, instead of killing the process
+    unsigned erreurs_max;   // Transient errors in a row after which a node gives up
+} csc_execution;
+
+// What happened during a run, see executer_cascada()
+typedef struct csc_bilan {
+    size_t noeuds;          // The nodes that worked
+    size_t taches;          // Tasks computed and submitted
+    size_t abandons;        // Tasks calculer() dropped
+    size_t erreurs;         // Transient errors the nodes got past
+    size_t perdues;         // Results the master didn't accept
+    size_t ajouts;          // Nodes added during the run
+    size_t retraits;        // Nodes removed during the run
+    size_t retraits_echoues;    // Of which the master couldn't be told, or can't release a single node
+    bool interrompu;        // The run was stopped by a signal
+    int code;               // The error that stopped the run, or CSC_NO_ERROR
+} csc_bilan;
+
 #endif
\ No newline at end of file
@@ -0,0 +1,954 @@
+//
+//  execution.c
+//  cruesli
+//
+
+/*!
+    The nodes run by the library: a thread per node, fetching its next task while it computes the
+    current one, and sending the results in the background.
+    
+    The user only gives the function computing a task, and the variables it works on (the fields of
+    a structure, of which each node gets its own instance, or variables bound by the node itself).
+    The number of nodes defaults to the CPUs the process may actually use: those it is allowed to run
+    on, capped by the CPU quota of its cgroup, if it runs in a container.
+    
+    A transient error has the node back off and try again; a fatal one stops the run. SIGTERM and
+    SIGINT stop it as well: the nodes finish the task they hold, and their results are sent before
+    executer_cascada() returns.
+    
+    A node pinned to a CPU (see placer_noeuds()) allocates its memory from its own thread, once pinned:
+    with the first-touch policy of the system, it then lives on the NUMA node of the CPU.
+    
+    On a host shared with other work, the number of nodes can follow the CPUs the rest of the host
+    leaves free (from /proc/stat, on Linux): once per period, a node is added while there are free
+    CPUs and tasks to compute, and one is removed when the host is oversubscribed or the nodes are idle.
+    A node being removed finishes the task it holds, and its queue is handed over to the others.
+*/
+
+// For sched_getaffinity() and CPU_COUNT()
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <time.h>
+
+#include <pthread.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include "safe_malloc.h"
+#include "cscerrs.h"
+#include "entities.h"
+#include "varstructs.h"
+#include "attente.h"
+#include "taches.h"
+#include "plan.h"
+#include "vartable.h"
+#include "topologie.h"
+#include "cruesli.h"
+#include "execution.h"
+
+// Transient errors in a row after which a node gives up, by default
+#define EXECUTION_ERREURS_MAX 10
+
+// What the receive buffers of a pinned node are presized to, from its thread
+#define EXECUTION_TAMPON_RECEPTION (64*1024)
+
+// How often the number of nodes may change, by default
+#define EXECUTION_PERIODE_MS 1000
+
+// The cgroup (v2) of the process, and the hierarchies of cgroup v1
+#define CGROUP_PROCESSUS    "/proc/self/cgroup"
+#define CGROUP_RACINE       "/sys/fs/cgroup"
+
+// What the CPUs of the host have done since they booted
+#define STAT_PROCESSEURS    "/proc/stat"
+
+// What the threads of a run share
+typedef struct csc_etat_execution {
+    csc_master_info* info;
+    const csc_execution* execution;
+    sigset_t signaux;           // Those the watcher waits for
+    
+    pthread_mutex_t verrou;     // Protects everything below
+    pthread_cond_t changement;  // Signalled when a node is done
+    int code;                   // The first error that stopped the run
+    bool interrompu;
+    bool fini;                  // The nodes are done: the watcher should return
+} csc_etat_execution;
+
+// A node of the run, and what happened to it
+typedef struct csc_travailleur {
+    csc_etat_execution* etat;
+    csc_node_info* noeud;
+    void* instance;             // Its instance of the structure, or NULL
+    pthread_t thread;
+    
+    // Under the lock of the run
+    size_t taches;
+    size_t abandons;
+    bool occupe;                // It computes a task
+    bool retrait;               // It should stop after the task it holds, to be removed
+    bool termine;               // Its thread is over
+    
+    bool joint;                 // Its thread was joined, and its node removed if it had to be
+    size_t erreurs;
+    size_t perdues;
+} csc_travailleur;
+
+// The nodes of a run, as they come and go; only used by the thread of executer_cascada()
+typedef struct csc_equipe {
+    csc_travailleur** membres;
+    size_t nombre;
+    size_t capacite;
+    size_t ajouts;
+    size_t retraits;
+    size_t retraits_echoues;
+} csc_equipe;
+
+// What the CPUs of the host, and the process, have done up to some point
+typedef struct csc_mesure {
+    double instant;             // In seconds, from a monotonic clock
+    double processus;           // CPU time of the process, in seconds
+    unsigned long long total;   // Time of all the CPUs of the host, in ticks; 0 if unknown
+    unsigned long long inactif; // Of which idle
+} csc_mesure;
+
+
+/*!
+    \brief Creates the settings of a run, with their defaults.
+    
+    \param calculer The function computing a task.
+    \param contexte Given to calculer.
+    \return The settings; the variables the nodes work on are still to be given.
+*/
+csc_execution init_execution(csc_calcul calculer, void* contexte){
+    csc_execution execution;
+    
+    execution.nb_noeuds = 0;
+    execution.champs = NULL;
+    execution.nb_champs = 0;
+    execution.taille_instance = 0;
+    execution.preparer = NULL;
+    execution.calculer = calculer;
+    execution.contexte = contexte;
+    execution.placement = CSC_PLACEMENT_AUCUN;
+    execution.smt = false;
+    execution.noeuds_min = 1;
+    execution.noeuds_max = 0;
+    execution.periode_ms = EXECUTION_PERIODE_MS;
+    execution.signaux = true;
+    execution.erreurs_max = EXECUTION_ERREURS_MAX;
+    
+    return execution;
+}
+
+
+/*!
+    \brief Tells what an error code means for the node that got it.
+    
+    \param code The code, returned by a function of the library or sent by the master server.
+    \return CSC_CLASSE_SUCCES, CSC_CLASSE_FIN when the master has no more work, CSC_CLASSE_PASSAGERE
+            when trying again later may work, or CSC_CLASSE_FATALE.
+*/
+int classer_erreur(int code){
+    switch (code) {
+        case CSC_NO_ERROR:
+            return CSC_CLASSE_SUCCES;
+        case CSC_NO_MORE_WORK:
+            return CSC_CLASSE_FIN;
+        // Local misconfiguration, or a master that could not register the slave: trying again gives the same answer.
+        // A malformed answer to a request of the run is CSC_ERR_NONFATAL_MISSINGINFO
+        case CSC_ERR_FATAL_JSON_INTERNAL:
+        case CSC_ERR_FATAL_MISSINGINFO:
+        case CSC_ERR_FATAL_UNREGISTERED_VAR:
+        case CSC_ERR_FATAL_INVALID_TYPE:
+        case CSC_FATAL_NULL_INFO:
+            return CSC_CLASSE_FATALE;
+        default:
+            // A network error that outlived the retries, a master being restarted, or a code sent by the master
+            // refusing a request: none of them is the end of the run
+            return CSC_CLASSE_PASSAGERE;
+    }
+}
+
+
+#ifdef __linux__
+/*!
+    \brief Reads the quota of a cgroup v2, from its cpu.max file ("quota period", or "max period").
+    
+    \param chemin The path of the file.
+    \return The number of CPUs the quota amounts to; 0 if there is none.
+*/
+static double lire_cpu_max(const char* chemin){
+    FILE* fichier = fopen(chemin, "r");
+    char quota[32];
+    double periode;
+    double cpus = 0.0;
+    
+    if(!fichier)
+        return 0.0;
+    
+    if(fscanf(fichier, "%31s %lf", quota, &periode) == 2 && strcmp(quota, "max") && periode > 0)
+        cpus = atof(quota)/periode;
+    
+    fclose(fichier);
+    return cpus;
+}
+
+
+/*!
+    \brief Reads a number from a file of cgroup v1.
+    
+    \param chemin The path of the file.
+    \return The number; -1 if the file can't be read.
+*/
+static double lire_nombre_cgroup(const char* chemin){
+    FILE* fichier = fopen(chemin, "r");
+    double valeur = -1.0;
+    
+    if(!fichier)
+        return -1.0;
+    
+    if(fscanf(fichier, "%lf", &valeur) != 1)
+        valeur = -1.0;
+    
+    fclose(fichier);
+    return valeur;
+}
+
+
+/*!
+    \brief Finds the CPU quota of the cgroup of the process, and of its parents.
+    
+    \return The number of CPUs the smallest quota amounts to; 0 if there is none.
+*/
+static double quota_cgroup(void){
+    FILE* fichier = NULL;
+    char ligne[1024];
+    char chemin[1200];
+    char* fin = NULL;
+    double quota = 0.0;
+    double cpus, periode;
+    
+    // cgroup v2: the line "0::/path", and a cpu.max at each level of the path
+    fichier = fopen(CGROUP_PROCESSUS, "r");
+    if(fichier){
+        while(fgets(ligne, sizeof(ligne), fichier)){
+            if(strncmp(ligne, "0::", 3))
+                continue;
+            ligne[strcspn(ligne, "\n")] = '\0';
+    
+            while(1){
+                snprintf(chemin, sizeof(chemin), CGROUP_RACINE "%s/cpu.max", ligne + 3);
+                cpus = lire_cpu_max(chemin);
+                if(cpus > 0.0 && (quota == 0.0 || cpus < quota))
+                    quota = cpus;
+    
+                fin = strrchr(ligne + 3, '/');
+                if(!fin)
+                    break;
+                // The root has no cpu.max, but a container may see its own cgroup as the root
+                if(fin == ligne + 3){
+                    if(!fin[1])
+                        break;
+                    fin[1] = '\0';
+                } else {
+                    *fin = '\0';
+                }
+            }
+        }
+        fclose(fichier);
+    }
+    
+    if(quota > 0.0)
+        return quota;
+    
+    // cgroup v1
+    cpus = lire_nombre_cgroup(CGROUP_RACINE "/cpu/cpu.cfs_quota_us");
+    periode = lire_nombre_cgroup(CGROUP_RACINE "/cpu/cpu.cfs_period_us");
+    if(cpus > 0.0 && periode > 0.0)
+        return cpus/periode;
+    
+    return 0.0;
+}
+#endif
+
+
+/*!
+    \brief Tells how many CPUs the process may keep busy.
+    
+    \note The CPUs online, or those the process is allowed to run on if there are fewer; capped by the
+           CPU quota of its cgroup (Linux), rounded up.
+    
+    \return The number of CPUs, at least 1.
+*/
+size_t cpus_disponibles(void){
+    long en_ligne = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t cpus = en_ligne > 0 ? (size_t)en_ligne : 1;
+    
+#ifdef __linux__
+    cpu_set_t ensemble;
+    double quota;
+    size_t plafond;
+    
+    if(!sched_getaffinity(0, sizeof(ensemble), &ensemble) && CPU_COUNT(&ensemble) > 0 && (size_t)CPU_COUNT(&ensemble) < cpus)
+        cpus = CPU_COUNT(&ensemble);
+    
+    // A quota of 1.5 CPU keeps 2 of them busy
+    quota = quota_cgroup();
+    plafond = (size_t)quota;
+    if(plafond < quota)
+        plafond += 1;
+    if(quota > 0.0 && plafond < cpus)
+        cpus = plafond;
+#endif
+    
+    return cpus ? cpus : 1;
+}
+
+
+/*!
+    \brief Allocates a receive buffer of a node, and touches its pages, from the calling thread.
+    
+    \param ecriture The receive buffer.
+*/
+static void localiser_tampon(www_writestruct* ecriture){
+    size_t agrandissements = ecriture->agrandissements;
+    
+    // Not a growth the statistics should see
+    if(!ecriture_reserver(ecriture, EXECUTION_TAMPON_RECEPTION))
+        return;
+    ecriture->agrandissements = agrandissements;
+    memset(ecriture->ptr, 0, ecriture->capacite);
+}
+
+
+/*!
+    \brief Allocates what a node uses again, from the calling thread.
+    
+    \note The node's variables are allocated as it binds them: only the empty list allocated along with
+           the node has to be moved, if it has none bound yet.
+    \note Its receive buffers are filled by the network engine, when it runs, whose thread would touch
+           their pages first: they are presized here. One that grows past that later is reallocated from
+           the engine's thread.
+    
+    \param noeud The node.
+*/
+static void localiser_noeud(csc_node_info* noeud){
+    csc_file_taches* file = noeud->taches;
+    
+    // The reserve is still empty: its transfers get their buffers as the node's task handles submit
+    localiser_tampon(&file->recharge.ecriture);
+    localiser_tampon(&file->envoi.ecriture);
+    
+    if(noeud->localvars->nombre)
+        return;
+    
+    detruire_liste(noeud->localvars);
+    noeud->localvars = nouvelle_liste();
+    plan_detruire((csc_plan*)noeud->plan);
+    noeud->plan = plan_creer();
+}
+
+
+/*!
+    \brief Stops the run: the nodes finish the task they hold, and don't fetch any other.
+    
+    \param etat The state of the run.
+    \param code The error that stops it, or CSC_NO_ERROR.
+*/
+static void arreter_execution(csc_etat_execution* etat, int code){
+    pthread_mutex_lock(&etat->verrou);
+    if(etat->code == CSC_NO_ERROR)
+        etat->code = code;
+    pthread_mutex_unlock(&etat->verrou);
+    
+    interrompre_attente_travail(etat->info);
+}
+
+
+/*!
+    \brief Accounts for the answer of the master to a submission.
+    
+    \param travailleur The node.
+    \param code The status of the submission, from liberer_tache().
+*/
+static void noter_soumission(csc_travailleur* travailleur, int code){
+    switch (classer_erreur(code)) {
+        case CSC_CLASSE_SUCCES:
+            break;
+        case CSC_CLASSE_FATALE:
+            arreter_execution(travailleur->etat, code);
+            // Fallthrough: the result is lost all the same
+        default:
+            travailleur->perdues += 1;
+            break;
+    }
+}
+
+
+/*!
+    \brief Tells whether a node should stop after the task it holds, to be removed.
+    
+    \param travailleur The node.
+    \return true if it should.
+*/
+static bool est_retire(csc_travailleur* travailleur){
+    bool retrait;
+    
+    pthread_mutex_lock(&travailleur->etat->verrou);
+    retrait = travailleur->retrait;
+    pthread_mutex_unlock(&travailleur->etat->verrou);
+    
+    return retrait;
+}
+
+
+/*!
+    \brief Notes that a node starts computing a task.
+    
+    \param travailleur The node.
+    \return true if it should stop after this task, to be removed.
+*/
+static bool commencer_calcul(csc_travailleur* travailleur){
+    bool retrait;
+    
+    pthread_mutex_lock(&travailleur->etat->verrou);
+    travailleur->occupe = true;
+    retrait = travailleur->retrait;
+    pthread_mutex_unlock(&travailleur->etat->verrou);
+    
+    return retrait;
+}
+
+
+/*!
+    \brief Notes that a node is done computing a task.
+    
+    \param travailleur The node.
+    \param calculee Whether the task was computed, or dropped by calculer().
+*/
+static void finir_calcul(csc_travailleur* travailleur, bool calculee){
+    pthread_mutex_lock(&travailleur->etat->verrou);
+    travailleur->occupe = false;
+    if(calculee)
+        travailleur->taches += 1;
+    else
+        travailleur->abandons += 1;
+    pthread_mutex_unlock(&travailleur->etat->verrou);
+}
+
+
+/*!
+    \brief The thread of a node: computes tasks until the master has no more, or the run is stopped.
+    
+    \note The next task is fetched while the current one is computed, and the result of the previous
+           one is sent meanwhile (see prelever_tache()).
+    
+    \param travailleur The node.
+    \return NULL.
+*/
+static void* travailler(csc_travailleur* travailleur){
+    csc_etat_execution* etat = travailleur->etat;
+    const csc_execution* execution = etat->execution;
+    csc_master_info* info = etat->info;
+    csc_node_info* noeud = travailleur->noeud;
+    csc_attente* attente = (csc_attente*)info->attente;
+    csc_tache* tache = NULL;
+    csc_tache* suivante = NULL;
+    csc_tache* precedente = NULL;
+    unsigned erreurs = 0;
+    bool arreter = true;
+    int code = CSC_NO_ERROR;
+    
+    // Pinned first, so that what the node allocates from now on is on its NUMA node
+    if(noeud->cpu >= 0 && epingler_thread(noeud->cpu))
+        localiser_noeud(noeud);
+    
+    if(execution->taille_instance){
+        travailleur->instance = safe_malloc(execution->taille_instance);
+        memset(travailleur->instance, 0, execution->taille_instance);
+    }
+    
+    if(execution->champs && (code = lier_structure(noeud, execution->champs, execution->nb_champs, travailleur->instance)))
+        goto end;
+    if(execution->preparer && (code = execution->preparer(noeud, travailleur->instance, execution->contexte)))
+        goto end;
+    
+    // A variable of the schemes left unbound would fail every task: better stop before fetching any
+    if((code = lier_noeud(info, noeud, NULL, NULL)) == CSC_ERR_FATAL_UNREGISTERED_VAR)
+        goto end;
+    code = CSC_NO_ERROR;
+    
+    arreter = false;
+    suivante = prelever_tache(info, noeud);
+    
+    while(suivante){
+        tache = suivante;
+        suivante = NULL;
+    
+        code = demarrer_tache(info, noeud, tache);
+        if(code){
+            liberer_tache(info, noeud, tache);
+            if(classer_erreur(code) != CSC_CLASSE_PASSAGERE){
+                arreter = classer_erreur(code) == CSC_CLASSE_FATALE;
+                break;
+            }
+    
+            // The master may be down for good: once a node gives up, the others do as well
+            travailleur->erreurs += 1;
+            if(++erreurs >= execution->erreurs_max){
+                arreter = true;
+                break;
+            }
+            if(!attente_dormir(attente, erreurs - 1, 0.0) || est_retire(travailleur))
+                break;
+    
+            code = CSC_NO_ERROR;
+            suivante = prelever_tache(info, noeud);
+            continue;
+        }
+        erreurs = 0;
+    
+        // Once the run is stopping, or the node is to be removed, it only finishes the task it holds
+        if(!commencer_calcul(travailleur) && !attente_finie(attente, 0.0))
+            suivante = prelever_tache(info, noeud);
+    
+        if(execution->calculer(noeud, travailleur->instance, execution->contexte) == 0){
+            rendre_tache(info, noeud, tache);
+            finir_calcul(travailleur, true);
+        } else {
+            finir_calcul(travailleur, false);
+            liberer_tache(info, noeud, tache);
+            tache = NULL;
+        }
+    
+        if(precedente)
+            noter_soumission(travailleur, liberer_tache(info, noeud, precedente));
+        precedente = tache;
+    }
+    
+    if(precedente)
+        noter_soumission(travailleur, liberer_tache(info, noeud, precedente));
+    if(suivante)
+        liberer_tache(info, noeud, suivante);
+    
+end:
+    // A node that could not even start, or that gave up, stops the run
+    if(arreter)
+        arreter_execution(etat, code);
+    
+    pthread_mutex_lock(&etat->verrou);
+    travailleur->termine = true;
+    pthread_cond_signal(&etat->changement);
+    pthread_mutex_unlock(&etat->verrou);
+    
+    return NULL;
+}
+
+
+/*!
+    \brief The thread that waits for SIGTERM and SIGINT, blocked in every other thread, and stops the run.
+    
+    \param etat The state of the run.
+    \return NULL.
+*/
+static void* guetter_signaux(csc_etat_execution* etat){
+    int signal;
+    bool fini;
+    
+    while(1){
+        if(sigwait(&etat->signaux, &signal))
+            continue;
+    
+        pthread_mutex_lock(&etat->verrou);
+        fini = etat->fini;
+        if(!fini)
+            etat->interrompu = true;
+        pthread_mutex_unlock(&etat->verrou);
+    
+        // executer_cascada() wakes us up with a signal of our own once the nodes are done
+        if(fini)
+            return NULL;
+    
+        interrompre_attente_travail(etat->info);
+    }
+}
+
+
+/*!
+    \brief Starts the thread of a node.
+    
+    \param etat The state of the run.
+    \param equipe The nodes of the run, to which it is added.
+    \param noeud The node.
+*/
+static void lancer_travailleur(csc_etat_execution* etat, csc_equipe* equipe, csc_node_info* noeud){
+    csc_travailleur* travailleur = safe_malloc(sizeof(csc_travailleur));
+    csc_travailleur** membres = NULL;
+    
+    memset(travailleur, 0, sizeof(csc_travailleur));
+    travailleur->etat = etat;
+    travailleur->noeud = noeud;
+    
+    if(equipe->nombre == equipe->capacite){
+        equipe->capacite = equipe->capacite ? 2*equipe->capacite : 8;
+        membres = realloc(equipe->membres, equipe->capacite*sizeof(csc_travailleur*));
+        if(!membres)
+            die("Erreur d'allocation\n");
+        equipe->membres = membres;
+    }
+    equipe->membres[equipe->nombre++] = travailleur;
+    
+    pthread_create(&travailleur->thread, NULL, (void*)travailler, travailleur);
+}
+
+
+/*!
+    \brief Reads what the CPUs of the host, and the process, have done so far.
+    
+    \param mesure Where it is written.
+*/
+static void mesurer_cpus(csc_mesure* mesure){
+    struct timespec temps;
+    
+    clock_gettime(CLOCK_MONOTONIC, &temps);
+    mesure->instant = temps.tv_sec + temps.tv_nsec/1e9;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &temps);
+    mesure->processus = temps.tv_sec + temps.tv_nsec/1e9;
+    
+    mesure->total = 0;
+    mesure->inactif = 0;
+    
+#ifdef __linux__
+    FILE* fichier = fopen(STAT_PROCESSEURS, "r");
+    unsigned long long temps_cpu[8] = {0};
+    size_t i;
+    
+    if(!fichier)
+        return;
+    
+    // user nice system idle iowait irq softirq steal: the guests are already counted in user and nice
+    if(fscanf(fichier, "cpu %llu %llu %llu %llu %llu %llu %llu %llu", &temps_cpu[0], &temps_cpu[1], &temps_cpu[2], &temps_cpu[3], &temps_cpu[4], &temps_cpu[5], &temps_cpu[6], &temps_cpu[7]) >= 4){
+        for(i = 0; i < 8; i++)
+            mesure->total += temps_cpu[i];
+        mesure->inactif = temps_cpu[3] + temps_cpu[4];
+    }
+    
+    fclose(fichier);
+#endif
+}
+
+
+/*!
+    \brief Tells how many nodes the host has room for, between two measures.
+    
+    \note The CPUs the rest of the host kept busy are taken from those online; the result is capped by
+           cpus_disponibles(). Without /proc/stat, the rest of the host is assumed idle.
+    
+    \param avant The first measure.
+    \param apres The second one.
+    \param capacite The CPUs the process may keep busy.
+    \return The number of nodes.
+*/
+static size_t cpus_libres(const csc_mesure* avant, const csc_mesure* apres, size_t capacite){
+    long en_ligne = sysconf(_SC_NPROCESSORS_ONLN);
+    double cpus = en_ligne > 0 ? en_ligne : 1;
+    double duree = apres->instant - avant->instant;
+    double autres = 0.0;
+    double libres;
+    
+    if(duree > 0 && apres->total > avant->total){
+        autres = cpus*(1.0 - (double)(apres->inactif - avant->inactif)/(apres->total - avant->total));
+        autres -= (apres->processus - avant->processus)/duree;
+        if(autres < 0)
+            autres = 0.0;
+    }
+    
+    // Half a CPU used by someone else doesn't take one from us
+    libres = cpus - autres + 0.5;
+    if(libres < 0)
+        return 0;
+    
+    return (size_t)libres < capacite ? (size_t)libres : capacite;
+}
+
+
+/*!
+    \brief Adds a node to the run, or removes one, depending on the CPUs the rest of the host leaves free
+           and on the work there is to do.
+    
+    \note One change at a time: a node being removed must be done with the task it holds before any
+           other change.
+    
+    \param etat The state of the run.
+    \param equipe The nodes of the run.
+    \param cible The number of nodes the host has room for.
+    \param faites Where the tasks computed or dropped so far are kept, from one call to the next.
+*/
+static void ajuster_noeuds(csc_etat_execution* etat, csc_equipe* equipe, size_t cible, size_t* faites){
+    const csc_execution* execution = etat->execution;
+    csc_master_info* info = etat->info;
+    csc_travailleur* travailleur = NULL;
+    csc_travailleur* dernier = NULL;
+    csc_node_info* noeud = NULL;
+    size_t actifs = 0;
+    size_t total = 0;
+    size_t en_file = 0;
+    size_t i;
+    bool occupe = false;
+    bool en_retrait = false;
+    bool fin = false;
+    bool travail;
+    
+    pthread_mutex_lock(&etat->verrou);
+    for(i = 0; i < equipe->nombre; i++){
+        travailleur = equipe->membres[i];
+        total += travailleur->taches + travailleur->abandons;
+        occupe = occupe || travailleur->occupe;
+        if(travailleur->retrait && !travailleur->joint)
+            en_retrait = true;
+        else if(travailleur->termine)
+            fin = fin || !travailleur->retrait;
+        else if(!travailleur->retrait){
+            actifs += 1;
+            dernier = travailleur;
+        }
+    }
+    // A node done on its own means the run is ending
+    fin = fin || etat->code != CSC_NO_ERROR || etat->interrompu;
+    pthread_mutex_unlock(&etat->verrou);
+    
+    travail = occupe || total > *faites;
+    *faites = total;
+    
+    // The node being removed is done: its queue goes to the others
+    if(en_retrait){
+        for(i = 0; i < equipe->nombre; i++){
+            travailleur = equipe->membres[i];
+            pthread_mutex_lock(&etat->verrou);
+            noeud = travailleur->retrait && travailleur->termine && !travailleur->joint ? travailleur->noeud : NULL;
+            pthread_mutex_unlock(&etat->verrou);
+            if(!noeud)
+                continue;
+    
+            pthread_join(travailleur->thread, NULL);
+            travailleur->joint = true;
+            // Unless the master is yet to answer: conclure_retraits() tries again then
+            if(retirer_noeud(info, noeud) != CSC_NO_ERROR && !noeud->desinscription)
+                equipe->retraits_echoues += 1;
+            equipe->retraits += 1;
+        }
+        return;
+    }
+    
+    // The nodes removed earlier whose tasks the others have now submitted
+    conclure_retraits(info, NULL);
+    
+    if(fin || attente_finie((csc_attente*)info->attente, 0.0))
+        return;
+    
+    // Only this thread adds and removes nodes: the list can be read without its lock
+    for(noeud = info->nodes; noeud; noeud = noeud->next)
+        en_file += file_longueur(noeud->taches);
+    travail = travail || en_file;
+    
+    if(actifs > execution->noeuds_min && (actifs > cible || !travail)){
+        pthread_mutex_lock(&etat->verrou);
+        dernier->retrait = true;
+        pthread_mutex_unlock(&etat->verrou);
+        interrompre_attente_noeud(info, dernier->noeud);
+    } else if(actifs < cible && actifs < execution->noeuds_max && travail){
+        // The master may refuse: we'll ask again in a while
+        if(ajouter_noeud(info, &noeud) != CSC_NO_ERROR)
+            return;
+        if(execution->placement != CSC_PLACEMENT_AUCUN)
+            placer_noeud(info, noeud, execution->placement, execution->smt);
+        lancer_travailleur(etat, equipe, noeud);
+        equipe->ajouts += 1;
+    }
+}
+
+
+/*!
+    \brief Adjusts the number of nodes once per period, until they are all done.
+    
+    \param etat The state of the run.
+    \param equipe The nodes of the run.
+*/
+static void piloter_noeuds(csc_etat_execution* etat, csc_equipe* equipe){
+    const csc_execution* execution = etat->execution;
+    size_t capacite = cpus_disponibles();
+    struct timespec echeance;
+    csc_mesure avant, apres;
+    size_t faites = 0;
+    size_t i;
+    bool fini = false;
+    
+    mesurer_cpus(&avant);
+    
+    while(!fini){
+        clock_gettime(CLOCK_REALTIME, &echeance);
+        echeance.tv_sec += execution->periode_ms/1000;
+        echeance.tv_nsec += (execution->periode_ms%1000)*1000000L;
+        if(echeance.tv_nsec >= 1000000000L){
+            echeance.tv_sec += 1;
+            echeance.tv_nsec -= 1000000000L;
+        }
+    
+        // Woken up early when a node is done, in case it was the last one
+        pthread_mutex_lock(&etat->verrou);
+        while(1){
+            for(i = 0, fini = true; i < equipe->nombre && fini; i++)
+                fini = equipe->membres[i]->termine;
+            if(fini || pthread_cond_timedwait(&etat->changement, &etat->verrou, &echeance) == ETIMEDOUT)
+                break;
+        }
+        pthread_mutex_unlock(&etat->verrou);
+    
+        if(fini)
+            break;
+    
+        mesurer_cpus(&apres);
+        ajuster_noeuds(etat, equipe, cpus_libres(&avant, &apres, capacite), &faites);
+        avant = apres;
+    }
+}
+
+
+/*!
+    \brief Runs the nodes: each computes tasks in its own thread until the master has no more work, an
+           error stops the run, or the process gets SIGTERM or SIGINT.
+    
+    \note The nodes are allocated, unless they already were: as many as execution->nb_noeuds, or as
+           cpus_disponibles(). The master may grant fewer.
+    \note The nodes don't stop when there's no more work if they were told to wait for it (see
+           configurer_attente_travail()): only a signal, or interrompre_attente_travail(), stops them then.
+           An interruption only stops the run it happens in.
+    \note Stopping, a node finishes the task it holds; the tasks already fetched by batches are not
+           computed, and the master will hand them over again. All the results are sent before returning.
+    \note The nodes placed by placer_noeuds() (or by execution->placement) run pinned to their CPU.
+    \note With execution->noeuds_max, nodes are added and removed during the run, as the rest of the host
+           leaves CPUs free; the nodes removed are released on the master (see retirer_noeud()).
+    \note With execution->signaux, SIGTERM and SIGINT are blocked in the calling thread (and so in the
+           threads of the nodes) for the duration of the run. The network engine and the grouped submissions
+           run with them blocked from the start, so that they don't take a signal meant for the run.
+    
+    \param info The master info, connected.
+    \param execution The settings of the run, see init_execution().
+    \param bilan Where what happened is written, or NULL.
+    \return CSC_NO_ERROR if the nodes ran out of work or were stopped by a signal; otherwise the error
+            that stopped the run.
+*/
+int executer_cascada(csc_master_info* info, const csc_execution* execution, csc_bilan* bilan){
+    csc_etat_execution etat;
+    csc_equipe equipe = { .membres = NULL, .nombre = 0, .capacite = 0, .ajouts = 0, .retraits = 0, .retraits_echoues = 0 };
+    csc_travailleur* travailleur = NULL;
+    csc_node_info* noeud = NULL;
+    pthread_t guetteur;
+    sigset_t masque;
+    size_t nombre;
+    size_t i;
+    int retcode = CSC_NO_ERROR;
+    
+    if(!info || !execution || !execution->calculer)
+        return CSC_FATAL_NULL_INFO;
+    
+    if(bilan)
+        memset(bilan, 0, sizeof(csc_bilan));
+    
+    if(!info->nodes){
+        nombre = execution->nb_noeuds ? execution->nb_noeuds : cpus_disponibles();
+        if(execution->noeuds_max && nombre > execution->noeuds_max)
+            nombre = execution->noeuds_max;
+        if(execution->noeuds_max && nombre < execution->noeuds_min)
+            nombre = execution->noeuds_min;
+        retcode = allouer_noeuds(info, nombre);
+        if(retcode != CSC_NO_ERROR)
+            goto end;
+    }
+    
+    if(execution->placement != CSC_PLACEMENT_AUCUN)
+        placer_noeuds(info, execution->placement, execution->smt);
+    
+    // The stop of the previous run, if any, is not this one's
+    attente_rearmer((csc_attente*)info->attente);
+    
+    etat.info = info;
+    etat.execution = execution;
+    etat.code = CSC_NO_ERROR;
+    etat.fini = false;
+    etat.interrompu = false;
+    pthread_mutex_init(&etat.verrou, NULL);
+    pthread_cond_init(&etat.changement, NULL);
+    
+    // The signals are blocked before the threads are created, which inherit the mask
+    if(execution->signaux){
+        sigemptyset(&etat.signaux);
+        sigaddset(&etat.signaux, SIGTERM);
+        sigaddset(&etat.signaux, SIGINT);
+        pthread_sigmask(SIG_BLOCK, &etat.signaux, &masque);
+        pthread_create(&guetteur, NULL, (void*)guetter_signaux, &etat);
+    }
+    
+    for(noeud = info->nodes; noeud; noeud = noeud->next)
+        lancer_travailleur(&etat, &equipe, noeud);
+    
+    if(execution->noeuds_max && execution->periode_ms)
+        piloter_noeuds(&etat, &equipe);
+    
+    for(i = 0; i < equipe.nombre; i++){
+        if(!equipe.membres[i]->joint)
+            pthread_join(equipe.membres[i]->thread, NULL);
+    }
+    
+    // The grouped submissions still buffered, and the master told about the nodes removed
+    vider_soumissions(info);
+    equipe.retraits_echoues += conclure_retraits(info, NULL);
+    
+    if(execution->signaux){
+        pthread_mutex_lock(&etat.verrou);
+        etat.fini = true;
+        pthread_mutex_unlock(&etat.verrou);
+        pthread_kill(guetteur, SIGTERM);
+        pthread_join(guetteur, NULL);
+        pthread_sigmask(SIG_SETMASK, &masque, NULL);
+    }
+    
+    retcode = etat.code;
+    
+    if(bilan){
+        bilan->noeuds = equipe.nombre;
+        bilan->ajouts = equipe.ajouts;
+        bilan->retraits = equipe.retraits;
+        bilan->retraits_echoues = equipe.retraits_echoues;
+        bilan->interrompu = etat.interrompu;
+        for(i = 0; i < equipe.nombre; i++){
+            travailleur = equipe.membres[i];
+            bilan->taches += travailleur->taches;
+            bilan->abandons += travailleur->abandons;
+            bilan->erreurs += travailleur->erreurs;
+            bilan->perdues += travailleur->perdues;
+        }
+    }
+    
+    for(i = 0; i < equipe.nombre; i++){
+        free(equipe.membres[i]->instance);
+        free(equipe.membres[i]);
+    }
+    free(equipe.membres);
+    pthread_cond_destroy(&etat.changement);
+    pthread_mutex_destroy(&etat.verrou);
+    
+end:
+    if(bilan)
+        bilan->code = retcode;
+    
+    return retcode;
+}
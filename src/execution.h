@@ -0,0 +1,18 @@
+//
+//  execution.h
+//  cruesli
+//
+
+#ifndef execution_h
+#define execution_h
+
+#include <stddef.h>
+
+#include "entities.h"
+
+csc_execution init_execution(csc_calcul calculer, void* contexte);
+int classer_erreur(int code);
+size_t cpus_disponibles(void);
+int executer_cascada(csc_master_info* info, const csc_execution* execution, csc_bilan* bilan);
+
+#endif /* execution_h */
@@ -0,0 +1,776 @@
+//
+//  jsonflux.c
+//  cruesli
+//
+
+/*!
+    A streaming JSON reader: the document is read in place, in a single pass, without building a tree.
+    Numbers are converted straight into the Cascada variables they are meant for.
+    Skipping over large objects and arrays is done 16 bytes at a time when SSE2 is available.
+    
+    And its counterpart, a compact JSON writer appending to a reusable buffer.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <cjson/cJSON.h>
+
+#include "safe_malloc.h"
+#include "varstructs.h"
+#include "tableaux.h"
+#include "www.h"
+#include "jsonflux.h"
+
+// Longest number we accept (digits, sign, dot and exponent)
+#define JSON_NOMBRE_MAX 64
+
+
+/*!
+    \brief Initializes a cursor at the beginning of a document.
+    
+    \param curseur The cursor.
+    \param data The document.
+    \param taille The size of the document.
+*/
+void json_curseur_init(json_curseur* curseur, const char* data, size_t taille){
+    curseur->p = data;
+    curseur->fin = data + taille;
+}
+
+
+/*!
+    \brief Moves the cursor past the whitespace.
+*/
+static void sauter_blancs(json_curseur* curseur){
+    while(curseur->p < curseur->fin && (*curseur->p == ' ' || *curseur->p == '\n' || *curseur->p == '\r' || *curseur->p == '\t'))
+        curseur->p++;
+}
+
+
+/*!
+    \brief Searches the end of a string, or the next escape sequence in it.
+    
+    \param p Where to start.
+    \param fin The end of the document.
+    \return The address of the next '"' or '\\', or fin.
+*/
+static const char* chercher_fin_chaine(const char* p, const char* fin){
+#ifdef __SSE2__
+    const __m128i guillemet = _mm_set1_epi8('"');
+    const __m128i barre = _mm_set1_epi8('\\');
+    
+    while(fin - p >= 16){
+        __m128i bloc = _mm_loadu_si128((const __m128i*)p);
+        int masque = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(bloc, guillemet), _mm_cmpeq_epi8(bloc, barre)));
+        if(masque)
+            return p + __builtin_ctz(masque);
+        p += 16;
+    }
+#endif
+    while(p < fin && *p != '"' && *p != '\\')
+        p++;
+    
+    return p;
+}
+
+
+/*!
+    \brief Searches the next structural character of an object or an array.
+    
+    \param p Where to start, outside of any string.
+    \param fin The end of the document.
+    \return The address of the next '"', '{', '}', '[' or ']', or fin.
+*/
+static const char* chercher_structure(const char* p, const char* fin){
+#ifdef __SSE2__
+    const __m128i guillemet = _mm_set1_epi8('"');
+    const __m128i accolade_o = _mm_set1_epi8('{');
+    const __m128i accolade_f = _mm_set1_epi8('}');
+    const __m128i crochet_o = _mm_set1_epi8('[');
+    const __m128i crochet_f = _mm_set1_epi8(']');
+    
+    while(fin - p >= 16){
+        __m128i bloc = _mm_loadu_si128((const __m128i*)p);
+        __m128i egal = _mm_or_si128(_mm_cmpeq_epi8(bloc, guillemet),
+                       _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bloc, accolade_o), _mm_cmpeq_epi8(bloc, accolade_f)),
+                                    _mm_or_si128(_mm_cmpeq_epi8(bloc, crochet_o), _mm_cmpeq_epi8(bloc, crochet_f))));
+        int masque = _mm_movemask_epi8(egal);
+        if(masque)
+            return p + __builtin_ctz(masque);
+        p += 16;
+    }
+#endif
+    while(p < fin && *p != '"' && *p != '{' && *p != '}' && *p != '[' && *p != ']')
+        p++;
+    
+    return p;
+}
+
+
+/*!
+    \brief Moves the cursor past a string.
+    
+    \param curseur The cursor, on the opening '"'.
+    \param echappee If not NULL, where is written whether the string holds escape sequences.
+    \return false if the string is not terminated.
+*/
+static bool sauter_chaine(json_curseur* curseur, bool* echappee){
+    const char* p = curseur->p + 1;
+    
+    if(echappee)
+        *echappee = false;
+    
+    for(;;){
+        p = chercher_fin_chaine(p, curseur->fin);
+        if(p >= curseur->fin)
+            return false;
+        if(*p == '"')
+            break;
+        // An escape sequence: the next character can't end the string
+        if(echappee)
+            *echappee = true;
+        p += 2;
+    }
+    
+    curseur->p = p + 1;
+    return true;
+}
+
+
+/*!
+    \brief Gives the kind of the next value, without reading it.
+    
+    \param curseur The cursor; the whitespace is skipped.
+    \return The first character of the value ('{', '[', '"', 't', 'f', 'n', or '0' for any number), or -1 at the end of the document.
+*/
+int json_type(json_curseur* curseur){
+    sauter_blancs(curseur);
+    
+    if(curseur->p >= curseur->fin)
+        return -1;
+    if(*curseur->p == '-' || (*curseur->p >= '0' && *curseur->p <= '9'))
+        return '0';
+    
+    return *curseur->p;
+}
+    
+    
+/*!
+    \brief Enters an object or an array.
+    
+    \param curseur The cursor.
+    \param ouvrant '{' or '['.
+    \param conteneur Where the state of the container is kept.
+    \return false if the next value is not a container of that kind.
+*/
+bool json_ouvrir(json_curseur* curseur, char ouvrant, json_conteneur* conteneur){
+    if(json_type(curseur) != ouvrant)
+        return false;
+    
+    curseur->p++;
+    conteneur->fermant = (ouvrant == '{') ? '}' : ']';
+    conteneur->premier = true;
+    
+    return true;
+}
+    
+    
+/*!
+    \brief Tells whether there's another element in the container (for an object, another key/value pair).
+    
+    \param curseur The cursor, which must be between two elements.
+    \param conteneur The state of the container.
+    \return true if there's another element; false if the container is over (or malformed), in which case the cursor leaves it.
+*/
+bool json_suivant(json_curseur* curseur, json_conteneur* conteneur){
+    sauter_blancs(curseur);
+    if(curseur->p >= curseur->fin)
+        return false;
+    
+    if(*curseur->p == conteneur->fermant){
+        curseur->p++;
+        return false;
+    }
+    
+    if(!conteneur->premier){
+        if(*curseur->p != ',')
+            return false;
+        curseur->p++;
+        sauter_blancs(curseur);
+    }
+    conteneur->premier = false;
+    
+    return curseur->p < curseur->fin;
+}
+    
+    
+/*!
+    \brief Reads the key of the next member of an object, without copying it.
+    
+    \param curseur The cursor, moved to the value of the member.
+    \param cle Where the address of the key in the document is written; it is NOT NUL-terminated.
+    \param longueur Where the length of the key is written.
+    \param echappee Where is written whether the key holds escape sequences (see json_desechapper()).
+    \return false if there's no key.
+*/
+bool json_lire_cle(json_curseur* curseur, const char** cle, size_t* longueur, bool* echappee){
+    const char* debut;
+    
+    if(json_type(curseur) != '"')
+        return false;
+    
+    debut = curseur->p + 1;
+    if(!sauter_chaine(curseur, echappee))
+        return false;
+    
+    *cle = debut;
+    *longueur = curseur->p - 1 - debut;
+    
+    sauter_blancs(curseur);
+    if(curseur->p >= curseur->fin || *curseur->p != ':')
+        return false;
+    curseur->p++;
+    
+    return true;
+}
+    
+    
+/*!
+    \brief Reads 4 hexadecimal digits.
+    
+    \return The value, or -1 if the digits are invalid.
+*/
+static long lire_hexa(const char* p){
+    long valeur = 0;
+    
+    for(int i = 0; i < 4; i++){
+        valeur <<= 4;
+        if(p[i] >= '0' && p[i] <= '9')
+            valeur |= p[i] - '0';
+        else if((p[i] | 0x20) >= 'a' && (p[i] | 0x20) <= 'f')
+            valeur |= (p[i] | 0x20) - 'a' + 10;
+        else
+            return -1;
+    }
+    
+    return valeur;
+}
+    
+    
+/*!
+    \brief Decodes the escape sequences of a string.
+    
+    \param texte The string, as found in the document (without its quotes).
+    \param longueur The length of the string.
+    \param sortie Where the decoded string is written, NUL-terminated.
+    \param taille_sortie The size of sortie.
+    \return The length of the decoded string, or (size_t)-1 if it is invalid or too long.
+*/
+size_t json_desechapper(const char* texte, size_t longueur, char* sortie, size_t taille_sortie){
+    const char* fin = texte + longueur;
+    size_t n = 0;
+    long point;
+    long bas;
+    char c;
+    
+    while(texte < fin){
+        // The longest sequence takes 4 bytes in UTF-8, and there's the final NUL
+        if(n + 5 > taille_sortie)
+            return (size_t)-1;
+        
+        if(*texte != '\\'){
+            sortie[n++] = *texte++;
+            continue;
+        }
+        
+        if(fin - texte < 2)
+            return (size_t)-1;
+        c = texte[1];
+        texte += 2;
+        
+        switch (c) {
+            case '"':  sortie[n++] = '"';  break;
+            case '\\': sortie[n++] = '\\'; break;
+            case '/':  sortie[n++] = '/';  break;
+            case 'b':  sortie[n++] = '\b'; break;
+            case 'f':  sortie[n++] = '\f'; break;
+            case 'n':  sortie[n++] = '\n'; break;
+            case 'r':  sortie[n++] = '\r'; break;
+            case 't':  sortie[n++] = '\t'; break;
+            case 'u':
+                if(fin - texte < 4 || (point = lire_hexa(texte)) < 0)
+                    return (size_t)-1;
+                texte += 4;
+                // A surrogate pair
+                if(point >= 0xd800 && point <= 0xdbff){
+                    if(fin - texte < 6 || texte[0] != '\\' || texte[1] != 'u' || (bas = lire_hexa(texte + 2)) < 0xdc00 || bas > 0xdfff)
+                        return (size_t)-1;
+                    texte += 6;
+                    point = 0x10000 + ((point - 0xd800) << 10) + (bas - 0xdc00);
+                }
+                if(point < 0x80){
+                    sortie[n++] = (char)point;
+                } else if(point < 0x800){
+                    sortie[n++] = (char)(0xc0 | point >> 6);
+                    sortie[n++] = (char)(0x80 | (point & 0x3f));
+                } else if(point < 0x10000){
+                    sortie[n++] = (char)(0xe0 | point >> 12);
+                    sortie[n++] = (char)(0x80 | ((point >> 6) & 0x3f));
+                    sortie[n++] = (char)(0x80 | (point & 0x3f));
+                } else {
+                    sortie[n++] = (char)(0xf0 | point >> 18);
+                    sortie[n++] = (char)(0x80 | ((point >> 12) & 0x3f));
+                    sortie[n++] = (char)(0x80 | ((point >> 6) & 0x3f));
+                    sortie[n++] = (char)(0x80 | (point & 0x3f));
+                }
+                break;
+            default:
+                return (size_t)-1;
+        }
+    }
+    
+    sortie[n] = '\0';
+    return n;
+}
+    
+    
+/*!
+    \brief Moves the cursor past the next value, whatever it is.
+    
+    \param curseur The cursor.
+    \return false if the document is malformed.
+*/
+bool json_sauter(json_curseur* curseur){
+    const char* p;
+    size_t profondeur = 0;
+    
+    switch (json_type(curseur)) {
+        case -1:
+            return false;
+            
+        case '"':
+            return sauter_chaine(curseur, NULL);
+            
+        case '{':
+        case '[':
+            // Only the structural characters matter: the brackets, and the strings that may contain some
+            p = curseur->p;
+            for(;;){
+                p = chercher_structure(p, curseur->fin);
+                if(p >= curseur->fin)
+                    return false;
+                
+                if(*p == '"'){
+                    curseur->p = p;
+                    if(!sauter_chaine(curseur, NULL))
+                        return false;
+                    p = curseur->p;
+                    continue;
+                }
+                
+                if(*p == '{' || *p == '[')
+                    profondeur++;
+                else if(--profondeur == 0)
+                    break;
+                p++;
+            }
+            curseur->p = p + 1;
+            return true;
+            
+        default:
+            // A number, true, false or null
+            p = curseur->p;
+            while(p < curseur->fin && *p != ',' && *p != '}' && *p != ']' && *p != ' ' && *p != '\n' && *p != '\r' && *p != '\t')
+                p++;
+            if(p == curseur->p)
+                return false;
+            curseur->p = p;
+            return true;
+    }
+}
+    
+    
+/*!
+    \brief Reads a number, keeping its integer value exact when it has one.
+    
+    \param curseur The cursor.
+    \param entier Where the value is written if the number is an integer.
+    \param naturel Where the value is written if the number is an integer (modulo 2^64, for the unsigned types).
+    \param flottant Where the value is written, in any case.
+    \return -1 if the next value is not a number, 1 if it is an integer, 0 if not.
+*/
+static int lire_nombre(json_curseur* curseur, int64_t* entier, uint64_t* naturel, double* flottant){
+    const char* p;
+    const char* debut;
+    char tampon[JSON_NOMBRE_MAX + 1];
+    bool negatif = false;
+    uint64_t valeur = 0;
+    size_t chiffres = 0;
+    
+    if(json_type(curseur) != '0')
+        return -1;
+    
+    p = debut = curseur->p;
+    if(*p == '-'){
+        negatif = true;
+        p++;
+    }
+    // The common case: an integer, converted while it's read; 19 digits can't overflow a uint64_t,
+    // but a negative one has to fit in an int64_t as well
+    while(p < curseur->fin && *p >= '0' && *p <= '9'){
+        valeur = valeur*10 + (uint64_t)(*p - '0');
+        chiffres++;
+        p++;
+    }
+    
+    if(chiffres <= 19 && (!negatif || valeur <= (uint64_t)INT64_MAX + 1) && (p >= curseur->fin || (*p != '.' && *p != 'e' && *p != 'E'))){
+        if(p == debut + negatif)
+            return -1;
+        curseur->p = p;
+        *naturel = negatif ? (uint64_t)0 - valeur : valeur;
+        *entier = (int64_t)*naturel;
+        *flottant = negatif ? -(double)valeur : (double)valeur;
+        return 1;
+    }
+    
+    // A decimal number, or a longer integer: strtod gets its own NUL-terminated copy
+    while(p < curseur->fin && ((*p >= '0' && *p <= '9') || *p == '.' || *p == 'e' || *p == 'E' || *p == '+' || *p == '-'))
+        p++;
+    if(p - debut > JSON_NOMBRE_MAX)
+        return -1;
+    memcpy(tampon, debut, p - debut);
+    tampon[p - debut] = '\0';
+    
+    *flottant = strtod(tampon, NULL);
+    flottant_vers_entiers(*flottant, entier, naturel);
+    curseur->p = p;
+    
+    return 0;
+}
+    
+    
+/*!
+    \brief Reads an integer.
+    
+    \param curseur The cursor.
+    \param valeur Where the integer is written.
+    \return false if the next value is not a number.
+*/
+bool json_lire_entier(json_curseur* curseur, int64_t* valeur){
+    uint64_t naturel;
+    double flottant;
+    
+    return lire_nombre(curseur, valeur, &naturel, &flottant) >= 0;
+}
+    
+    
+/*!
+    \brief Reads a number straight into a cascada variable, converting it to the type of the variable.
+    
+    \param curseur The cursor.
+    \param var The variable; an array is read from an array of exactly as many numbers.
+    \return false if the next value is not a number (an array of numbers of the right length) or if the type of the variable is unknown.
+*/
+bool json_lire_var(json_curseur* curseur, csc_var* var){
+    json_conteneur tableau;
+    size_t taille = vartype_taille(var->type);
+    int64_t entier;
+    uint64_t naturel;
+    double flottant;
+    size_t i = 0;
+    
+    if(!VARTYPE_EST_TABLEAU(var->type)){
+        if(lire_nombre(curseur, &entier, &naturel, &flottant) < 0)
+            return false;
+        return vartype_affecter(var->value, var->type, entier, naturel, flottant);
+    }
+    
+    if(!taille || !json_ouvrir(curseur, '[', &tableau))
+        return false;
+    
+    while(json_suivant(curseur, &tableau)){
+        if(i >= var->longueur || lire_nombre(curseur, &entier, &naturel, &flottant) < 0)
+            return false;
+        vartype_affecter((char*)var->value + i*taille, var->type, entier, naturel, flottant);
+        i++;
+    }
+    
+    return i == var->longueur;
+}
+    
+    
+/*!
+    \brief Appends raw bytes to the buffer; it stays NUL-terminated.
+    
+    \param sortie The buffer.
+    \param data The bytes.
+    \param taille The number of bytes.
+*/
+void json_ecrire_brut(www_writestruct* sortie, const char* data, size_t taille){
+    if(taille > SIZE_MAX - sortie->size || !ecriture_reserver(sortie, sortie->size + taille))
+        die("Erreur d'allocation\n");
+    
+    memcpy(sortie->ptr + sortie->size, data, taille);
+    sortie->size += taille;
+    sortie->ptr[sortie->size] = '\0';
+}
+    
+    
+/*!
+    \brief Appends a string, quoted and escaped.
+    
+    \param sortie The buffer.
+    \param texte The NUL-terminated string, in UTF-8.
+*/
+void json_ecrire_texte(www_writestruct* sortie, const char* texte){
+    static const char hexa[] = "0123456789abcdef";
+    const char* debut = texte;
+    char echappement[6] = { '\\', 'u', '0', '0', 0, 0 };
+    
+    JSON_ECRIRE_LITTERAL(sortie, "\"");
+    
+    // The runs of characters that need no escaping are copied at once
+    for(; *texte; texte++){
+        unsigned char c = (unsigned char)*texte;
+        if(c >= 0x20 && c != '"' && c != '\\')
+            continue;
+        
+        json_ecrire_brut(sortie, debut, texte - debut);
+        debut = texte + 1;
+        
+        switch (c) {
+            case '"':
+                JSON_ECRIRE_LITTERAL(sortie, "\\\"");
+                break;
+            case '\\':
+                JSON_ECRIRE_LITTERAL(sortie, "\\\\");
+                break;
+            case '\b':
+                JSON_ECRIRE_LITTERAL(sortie, "\\b");
+                break;
+            case '\f':
+                JSON_ECRIRE_LITTERAL(sortie, "\\f");
+                break;
+            case '\n':
+                JSON_ECRIRE_LITTERAL(sortie, "\\n");
+                break;
+            case '\r':
+                JSON_ECRIRE_LITTERAL(sortie, "\\r");
+                break;
+            case '\t':
+                JSON_ECRIRE_LITTERAL(sortie, "\\t");
+                break;
+            default:
+                echappement[4] = hexa[c >> 4];
+                echappement[5] = hexa[c & 0xF];
+                json_ecrire_brut(sortie, echappement, sizeof(echappement));
+        }
+    }
+    json_ecrire_brut(sortie, debut, texte - debut);
+    
+    JSON_ECRIRE_LITTERAL(sortie, "\"");
+}
+    
+    
+/*!
+    \brief Appends an unsigned integer, in decimal.
+    
+    \param sortie The buffer.
+    \param valeur The integer.
+    \param negatif Whether a minus sign should be written before it.
+*/
+static void ecrire_naturel(www_writestruct* sortie, uint64_t valeur, bool negatif){
+    char chiffres[21];
+    char* p = chiffres + sizeof(chiffres);
+    
+    do {
+        *--p = '0' + (char)(valeur % 10);
+        valeur /= 10;
+    } while(valeur);
+    
+    if(negatif)
+        *--p = '-';
+    
+    json_ecrire_brut(sortie, p, chiffres + sizeof(chiffres) - p);
+}
+    
+    
+/*!
+    \brief Appends a signed integer, in decimal.
+    
+    \param sortie The buffer.
+    \param valeur The integer.
+*/
+void json_ecrire_entier(www_writestruct* sortie, int64_t valeur){
+    // The negation is done on the unsigned value, so that INT64_MIN does not overflow
+    if(valeur < 0)
+        ecrire_naturel(sortie, 0 - (uint64_t)valeur, true);
+    else
+        ecrire_naturel(sortie, (uint64_t)valeur, false);
+}
+    
+    
+/*!
+    \brief Appends a double, the way cJSON prints it: with the shortest of 15 or 17 digits that reads back the same.
+    
+    \param sortie The buffer.
+    \param valeur The double; NaN and infinities are written as null, as JSON can't represent them.
+*/
+void json_ecrire_double(www_writestruct* sortie, double valeur){
+    char nombre[32];
+    int longueur;
+    
+    if(!isfinite(valeur)){
+        JSON_ECRIRE_LITTERAL(sortie, "null");
+        return;
+    }
+    
+    longueur = snprintf(nombre, sizeof(nombre), "%1.15g", valeur);
+    if(strtod(nombre, NULL) != valeur)
+        longueur = snprintf(nombre, sizeof(nombre), "%1.17g", valeur);
+    
+    json_ecrire_brut(sortie, nombre, longueur);
+}
+    
+    
+/*!
+    \brief Appends a float, with the 9 digits that always read back the same float.
+    
+    \param sortie The buffer.
+    \param valeur The float; NaN and infinities are written as null, as JSON can't represent them.
+*/
+void json_ecrire_float(www_writestruct* sortie, float valeur){
+    char nombre[32];
+    int longueur;
+    
+    if(!isfinite(valeur)){
+        JSON_ECRIRE_LITTERAL(sortie, "null");
+        return;
+    }
+    
+    longueur = snprintf(nombre, sizeof(nombre), "%.9g", (double)valeur);
+    json_ecrire_brut(sortie, nombre, longueur);
+}
+    
+    
+/*!
+    \brief Appends a value of a Cascada type, read in its native width.
+    
+    \param sortie The buffer.
+    \param type The type of the value; for an array, the type of its elements.
+    \param valeur The value.
+    \return false if the type is not supported.
+*/
+static bool ecrire_valeur(www_writestruct* sortie, csc_var_type type, const void* valeur){
+    switch (VARTYPE_BASE(type)) {
+        case VARTYPE_U8:
+            ecrire_naturel(sortie, *((uint8_t*)valeur), false);
+            break;
+        case VARTYPE_U32:
+            ecrire_naturel(sortie, *((uint32_t*)valeur), false);
+            break;
+        case VARTYPE_U64:
+            ecrire_naturel(sortie, *((uint64_t*)valeur), false);
+            break;
+        case VARTYPE_I32:
+            json_ecrire_entier(sortie, *((int32_t*)valeur));
+            break;
+        case VARTYPE_I64:
+            json_ecrire_entier(sortie, *((int64_t*)valeur));
+            break;
+        case VARTYPE_FLOAT:
+            json_ecrire_float(sortie, *((float*)valeur));
+            break;
+        case VARTYPE_DOUBLE:
+            json_ecrire_double(sortie, *((double*)valeur));
+            break;
+        case VARTYPE_I8:
+            json_ecrire_entier(sortie, *((int8_t*)valeur));
+            break;
+        case VARTYPE_U16:
+            ecrire_naturel(sortie, *((uint16_t*)valeur), false);
+            break;
+        case VARTYPE_I16:
+            json_ecrire_entier(sortie, *((int16_t*)valeur));
+            break;
+        case VARTYPE_FP16:
+            json_ecrire_float(sortie, demi_vers_float(*((uint16_t*)valeur)));
+            break;
+        case VARTYPE_BF16:
+            json_ecrire_float(sortie, bf16_vers_float(*((uint16_t*)valeur)));
+            break;
+        default:
+            return false;
+    }
+    
+    return true;
+}
+    
+    
+/*!
+    \brief Appends the value of a Cascada variable, read in its native width.
+    
+    \param sortie The buffer.
+    \param var The variable; an array is written as an array of numbers.
+    \return false if the variable's type is not supported.
+*/
+bool json_ecrire_var(www_writestruct* sortie, const csc_var* var){
+    size_t taille = vartype_taille(var->type);
+    size_t i;
+    
+    if(!VARTYPE_EST_TABLEAU(var->type))
+        return ecrire_valeur(sortie, var->type, var->value);
+    
+    if(!taille)
+        return false;
+    
+    JSON_ECRIRE_LITTERAL(sortie, "[");
+    for(i = 0; i < var->longueur; i++){
+        if(i)
+            JSON_ECRIRE_LITTERAL(sortie, ",");
+        ecrire_valeur(sortie, var->type, (const char*)var->value + i*taille);
+    }
+    JSON_ECRIRE_LITTERAL(sortie, "]");
+    
+    return true;
+}
+    
+    
+/*!
+    \brief Appends a cJSON value (used for the opaque values sent by the server, such as task ids).
+    
+    \param sortie The buffer.
+    \param json The value.
+    \return false if the value can't be printed.
+*/
+bool json_ecrire_json(www_writestruct* sortie, const cJSON* json){
+    char* texte = NULL;
+    
+    if(cJSON_IsString(json)){
+        json_ecrire_texte(sortie, json->valuestring);
+        return true;
+    }
+    if(cJSON_IsNumber(json)){
+        json_ecrire_double(sortie, json->valuedouble);
+        return true;
+    }
+    
+    // Anything else is rare enough to go through cJSON
+    texte = cJSON_PrintUnformatted(json);
+    if(!texte)
+        return false;
+    json_ecrire_brut(sortie, texte, strlen(texte));
+    cJSON_free(texte);
+    
+    return true;
+}
+    
\ No newline at end of file
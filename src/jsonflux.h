@@ -0,0 +1,51 @@
+//
+//  jsonflux.h
+//  cruesli
+//
+
+#ifndef jsonflux_h
+#define jsonflux_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <cjson/cJSON.h>
+
+#include "varstructs.h"
+#include "www.h"
+
+// A position in a JSON document
+typedef struct json_curseur {
+    const char* p;
+    const char* fin;
+} json_curseur;
+
+// An object or an array being read
+typedef struct json_conteneur {
+    char fermant;       // '}' or ']'
+    bool premier;       // No element was read yet
+} json_conteneur;
+
+void json_curseur_init(json_curseur* curseur, const char* data, size_t taille);
+int json_type(json_curseur* curseur);
+bool json_ouvrir(json_curseur* curseur, char ouvrant, json_conteneur* conteneur);
+bool json_suivant(json_curseur* curseur, json_conteneur* conteneur);
+bool json_lire_cle(json_curseur* curseur, const char** cle, size_t* longueur, bool* echappee);
+size_t json_desechapper(const char* texte, size_t longueur, char* sortie, size_t taille_sortie);
+bool json_sauter(json_curseur* curseur);
+bool json_lire_entier(json_curseur* curseur, int64_t* valeur);
+bool json_lire_var(json_curseur* curseur, csc_var* var);
+
+// Appends a string literal, which length is known at compile time
+#define JSON_ECRIRE_LITTERAL(sortie, texte) json_ecrire_brut((sortie), (texte), sizeof(texte) - 1)
+
+void json_ecrire_brut(www_writestruct* sortie, const char* data, size_t taille);
+void json_ecrire_texte(www_writestruct* sortie, const char* texte);
+void json_ecrire_entier(www_writestruct* sortie, int64_t valeur);
+void json_ecrire_double(www_writestruct* sortie, double valeur);
+void json_ecrire_float(www_writestruct* sortie, float valeur);
+bool json_ecrire_var(www_writestruct* sortie, const csc_var* var);
+bool json_ecrire_json(www_writestruct* sortie, const cJSON* json);
+
+#endif /* jsonflux_h */
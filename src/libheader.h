@@ -10,15 +10,60 @@
 /*!
     This header is desgined to enable the use of cascada as a shared library.
  */
-
+    
 #define CSC_CRUESLI_VERSION 20200800
-
+    
 extern csc_node_info* trouver_noeud_par_id(const csc_master_info* info, const char* nodename);
 csc_master_info init_cruesli(const char* url_serveur, const char* mdp);
 extern void cleanup_cruesli(csc_master_info* info);
+extern void demarrer_moteur_reseau(csc_master_info* info);
+extern void statistiques_reception(const csc_master_info* info, size_t* pic, size_t* agrandissements);
+extern void statistiques_reprises(const csc_master_info* info, size_t* reprises, size_t* declenchements, size_t* rejets);
+extern size_t nombre_serveurs(const csc_master_info* info);
+extern int statistiques_serveur(const csc_master_info* info, size_t indice, size_t* requetes, size_t* echecs, double* latence);
+extern void statistiques_attente(const csc_master_info* info, size_t* longpolls, size_t* sommeils);
+extern void arreter_moteur_reseau(csc_master_info* info);
+extern int configurer_compression(csc_master_info* info, int algo, size_t seuil);
+extern int configurer_format(csc_master_info* info, int format);
+extern void configurer_flux_soumission(csc_master_info* info, size_t seuil);
+extern void configurer_delais(csc_master_info* info, long connexion_ms, long total_ms);
+extern void configurer_reprises(csc_master_info* info, unsigned reprises_max, long attente_base_ms, long attente_max_ms);
+extern void configurer_disjoncteur(csc_master_info* info, unsigned seuil, long pause_ms);
+extern void configurer_bascule(csc_master_info* info, long pause_ms);
+extern void configurer_attente_travail(csc_master_info* info, bool active, long max_ms, long longpoll_ms, long plafond_ms);
+extern void interrompre_attente_travail(csc_master_info* info);
+extern void interrompre_attente_noeud(csc_master_info* info, csc_node_info* noeud);
 extern int connecter_cascada(csc_master_info* info, char* nom_suggere);
 extern int deconnecter_cascada(csc_master_info* info);
 extern int allouer_noeuds(csc_master_info* info, size_t nb_noeuds);
+extern int ajouter_noeud(csc_master_info* info, csc_node_info** noeud);
+extern int retirer_noeud(csc_master_info* info, csc_node_info* noeud);
+extern size_t conclure_retraits(csc_master_info* info, size_t* echecs);
+extern void configurer_lots(csc_master_info* info, size_t lot_min, size_t lot_max, size_t seuil_bas);
+extern void configurer_vol_taches(csc_master_info* info, bool actif);
 extern int allouer_travail(csc_master_info* info, csc_node_info* mon_noeud);
+extern void configurer_soumission_groupee(csc_master_info* info, size_t seuil_nombre, size_t seuil_taille, long delai_max_ms);
+extern void vider_soumissions(csc_master_info* info);
 extern int soumettre_travail(csc_master_info* info, csc_node_info* mon_noeud);
+extern csc_tache* prelever_tache(csc_master_info* info, csc_node_info* mon_noeud);
+extern int demarrer_tache(csc_master_info* info, csc_node_info* mon_noeud, csc_tache* tache);
+extern int rendre_tache(csc_master_info* info, csc_node_info* mon_noeud, csc_tache* tache);
+extern int liberer_tache(csc_master_info* info, csc_node_info* mon_noeud, csc_tache* tache);
+extern int lier_noeud(csc_master_info* info, csc_node_info* mon_noeud, size_t* manquantes, size_t* incompatibles);
+extern int lier_structure(csc_node_info* mon_noeud, const csc_champ* champs, size_t nombre, void* instance);
+extern void changer_instance(csc_node_info* mon_noeud, void* instance);
+extern csc_execution init_execution(csc_calcul calculer, void* contexte);
+extern int classer_erreur(int code);
+extern size_t cpus_disponibles(void);
+extern int executer_cascada(csc_master_info* info, const csc_execution* execution, csc_bilan* bilan);
+extern int placer_noeuds(csc_master_info* info, int politique, bool smt);
+extern int placer_noeud(csc_master_info* info, csc_node_info* noeud, int politique, bool smt);
+extern void afficher_placement(const csc_master_info* info);
 extern bool ajouter_variable(csc_var_type type, char* nom, void* ptr, csc_var_list* list);
+extern bool ajouter_tableau(csc_var_type type, char* nom, void* ptr, size_t longueur, csc_var_list* list);
+extern size_t ajouter_variables(const csc_liaison* liaisons, size_t nombre, csc_var_list* list);
+extern float demi_vers_float(uint16_t demi);
+extern uint16_t float_vers_demi(float valeur);
+extern float bf16_vers_float(uint16_t bf16);
+extern uint16_t float_vers_bf16(float valeur);
+    
\ No newline at end of file
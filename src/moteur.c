@@ -0,0 +1,241 @@
+//
+//  moteur.c
+//  cruesli
+//
+
+/*!
+    Network engine: a single thread drives every transfer posted by the nodes
+    through a curl_multi handle, so that hundreds of requests can be in flight
+    at the same time without one thread per connection.
+    
+    It sleeps in curl_multi_poll() and is woken up with curl_multi_wakeup(): it
+    requires libcurl 7.68.0 or later.
+*/
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include <pthread.h>
+#include <signal.h>
+
+#include <curl/curl.h>
+
+#include "safe_malloc.h"
+#include "moteur.h"
+
+
+struct csc_requete {
+    CURL* handler;
+    CURLcode resultat;
+    bool terminee;
+    pthread_cond_t cond;
+    csc_moteur* moteur;
+    struct csc_requete* suivante;   // Link in the list of requests waiting to be added
+};
+
+struct csc_moteur {
+    CURLM* multi;
+    pthread_t thread;
+    pthread_mutex_t verrou;         // Protects everything below
+    csc_requete* a_ajouter;         // Requests posted but not yet handed to curl
+    size_t en_vol;                  // Requests posted but not yet completed
+    bool arret;
+};
+
+
+/*!
+    \brief The engine's thread: hands the posted requests to curl and reports their completion.
+    
+    \param moteur The engine.
+    \return NULL
+*/
+static void* boucle_moteur(csc_moteur* moteur){
+    int en_cours = 0;
+    CURLMsg* msg = NULL;
+    csc_requete* requete = NULL;
+    int restants = 0;
+    
+    pthread_mutex_lock(&moteur->verrou);
+    while(!moteur->arret || moteur->en_vol){
+        
+        // New requests
+        while(moteur->a_ajouter){
+            requete = moteur->a_ajouter;
+            moteur->a_ajouter = requete->suivante;
+            curl_easy_setopt(requete->handler, CURLOPT_PRIVATE, requete);
+            
+            // curl won't report the completion of a request it refused: it ends here
+            if(curl_multi_add_handle(moteur->multi, requete->handler) != CURLM_OK){
+                requete->resultat = CURLE_FAILED_INIT;
+                requete->terminee = true;
+                moteur->en_vol -= 1;
+                pthread_cond_signal(&requete->cond);
+            }
+        }
+        pthread_mutex_unlock(&moteur->verrou);
+        
+        curl_multi_perform(moteur->multi, &en_cours);
+        
+        // Completed requests
+        while((msg = curl_multi_info_read(moteur->multi, &restants))){
+            if(msg->msg != CURLMSG_DONE)
+                continue;
+            
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char**)&requete);
+            curl_multi_remove_handle(moteur->multi, msg->easy_handle);
+            
+            pthread_mutex_lock(&moteur->verrou);
+            requete->resultat = msg->data.result;
+            requete->terminee = true;
+            moteur->en_vol -= 1;
+            pthread_cond_signal(&requete->cond);
+            pthread_mutex_unlock(&moteur->verrou);
+        }
+        
+        // Sleeps until there is something to do on the sockets, or until we're woken up
+        curl_multi_poll(moteur->multi, NULL, 0, 1000, NULL);
+        
+        pthread_mutex_lock(&moteur->verrou);
+    }
+    pthread_mutex_unlock(&moteur->verrou);
+    
+    return NULL;
+}
+
+
+/*!
+    \brief Creates a network engine and starts its thread.
+    
+    \return A pointer to the new engine.
+*/
+csc_moteur* moteur_creer(void){
+    csc_moteur* moteur = safe_malloc(sizeof(csc_moteur));
+    sigset_t signaux, masque;
+    
+    moteur->multi = curl_multi_init();
+    if(!moteur->multi){
+        die("Netcode initialization error");
+    }
+    
+    pthread_mutex_init(&moteur->verrou, NULL);
+    moteur->a_ajouter = NULL;
+    moteur->en_vol = 0;
+    moteur->arret = false;
+    
+    // SIGTERM and SIGINT are left to the other threads: executer_cascada() waits for them there
+    sigemptyset(&signaux);
+    sigaddset(&signaux, SIGTERM);
+    sigaddset(&signaux, SIGINT);
+    pthread_sigmask(SIG_BLOCK, &signaux, &masque);
+    
+    if(pthread_create(&moteur->thread, NULL, (void*)boucle_moteur, moteur)){
+        die("Could not spawn the network thread");
+    }
+    
+    pthread_sigmask(SIG_SETMASK, &masque, NULL);
+    
+    return moteur;
+}
+
+
+/*!
+    \brief Stops the engine once the requests in flight are done, and frees it.
+    
+    \param moteur The engine.
+    
+    \warning No request may be posted once this function has been called.
+*/
+void moteur_detruire(csc_moteur* moteur){
+    if(!moteur)
+        return;
+    
+    pthread_mutex_lock(&moteur->verrou);
+    moteur->arret = true;
+    pthread_mutex_unlock(&moteur->verrou);
+    curl_multi_wakeup(moteur->multi);
+    
+    pthread_join(moteur->thread, NULL);
+    
+    curl_multi_cleanup(moteur->multi);
+    pthread_mutex_destroy(&moteur->verrou);
+    free(moteur);
+}
+
+
+/*!
+    \brief Hands a fully configured easy handle to the engine.
+    
+    \param moteur The engine.
+    \param handler The easy handle; it must not be used until the request is completed.
+    \return The request, to be given to moteur_attendre().
+*/
+csc_requete* moteur_poster(csc_moteur* moteur, CURL* handler){
+    csc_requete* requete = safe_malloc(sizeof(csc_requete));
+    requete->handler = handler;
+    requete->resultat = CURLE_OK;
+    requete->terminee = false;
+    requete->moteur = moteur;
+    pthread_cond_init(&requete->cond, NULL);
+    
+    pthread_mutex_lock(&moteur->verrou);
+    requete->suivante = moteur->a_ajouter;
+    moteur->a_ajouter = requete;
+    moteur->en_vol += 1;
+    pthread_mutex_unlock(&moteur->verrou);
+    
+    curl_multi_wakeup(moteur->multi);
+    
+    return requete;
+}
+
+
+/*!
+    \brief Checks, without blocking, whether a request is completed.
+    
+    \param requete The request.
+    \return true if moteur_attendre() would not block.
+*/
+bool moteur_requete_terminee(csc_requete* requete){
+    bool terminee;
+    
+    pthread_mutex_lock(&requete->moteur->verrou);
+    terminee = requete->terminee;
+    pthread_mutex_unlock(&requete->moteur->verrou);
+    
+    return terminee;
+}
+
+
+/*!
+    \brief Waits for the completion of a request, and disposes of it.
+    
+    \param requete The request.
+    \return The curl result of the transfer.
+*/
+CURLcode moteur_attendre(csc_requete* requete){
+    CURLcode resultat;
+    csc_moteur* moteur = requete->moteur;
+    
+    pthread_mutex_lock(&moteur->verrou);
+    while(!requete->terminee)
+        pthread_cond_wait(&requete->cond, &moteur->verrou);
+    resultat = requete->resultat;
+    pthread_mutex_unlock(&moteur->verrou);
+    
+    pthread_cond_destroy(&requete->cond);
+    free(requete);
+    
+    return resultat;
+}
+
+
+/*!
+    \brief Performs a request through the engine; a drop-in replacement for curl_easy_perform().
+    
+    \param moteur The engine.
+    \param handler The easy handle.
+    \return The curl result of the transfer.
+*/
+CURLcode moteur_executer(csc_moteur* moteur, CURL* handler){
+    return moteur_attendre(moteur_poster(moteur, handler));
+}
@@ -0,0 +1,23 @@
+//
+//  moteur.h
+//  cruesli
+//
+
+#ifndef moteur_h
+#define moteur_h
+
+#include <stdbool.h>
+
+#include <curl/curl.h>
+
+typedef struct csc_moteur csc_moteur;
+typedef struct csc_requete csc_requete;
+
+csc_moteur* moteur_creer(void);
+void moteur_detruire(csc_moteur* moteur);
+csc_requete* moteur_poster(csc_moteur* moteur, CURL* handler);
+bool moteur_requete_terminee(csc_requete* requete);
+CURLcode moteur_attendre(csc_requete* requete);
+CURLcode moteur_executer(csc_moteur* moteur, CURL* handler);
+
+#endif /* moteur_h */
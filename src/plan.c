@@ -0,0 +1,222 @@
+//
+//  plan.c
+//  cruesli
+//
+
+/*!
+    The variables of the schemes, resolved once against those a node bound.
+    
+    The payloads of the tasks and of the submissions follow the schemes sent by the master server:
+    rather than looking up each of their variables by name in the node's list at every task, they are
+    resolved once into a flat array, which the tasks and the submissions just go through. The plan
+    is compiled again as soon as the node binds another variable, or the schemes change.
+    
+    The fields of a C struct bound by the node are resolved to their offsets: the instance they are
+    read from and written to can be changed from one task to the next without compiling the plan again.
+*/
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "safe_malloc.h"
+#include "vartable.h"
+#include "plan.h"
+
+// "name":value, with the longest number we can write
+#define TAILLE_JSON_VALEUR 28
+
+
+/*!
+    \brief Creates an empty plan, to be compiled before it's used.
+    
+    \return The plan, to be freed with plan_detruire().
+*/
+csc_plan* plan_creer(void){
+    csc_plan* plan = safe_malloc(sizeof(csc_plan));
+    
+    plan->entrees = NULL;
+    plan->nombre = 0;
+    plan->nombre_in = 0;
+    plan->taille_json = 0;
+    plan->manquantes = 0;
+    plan->incompatibles = 0;
+    plan->champs = NULL;
+    plan->nb_champs = 0;
+    plan->instance = NULL;
+    plan->compile = false;
+    
+    return plan;
+}
+
+
+/*!
+    \brief Frees a plan.
+    
+    \param plan The plan.
+*/
+void plan_detruire(csc_plan* plan){
+    if(!plan)
+        return;
+    
+    free(plan->entrees);
+    free(plan);
+}
+
+
+/*!
+    \brief Tells whether a plan must be compiled again.
+    
+    \param plan The plan.
+    \param locales The variables bound by the node.
+    \param sch_in The input scheme.
+    \param sch_out The output scheme.
+    \return true if it was never compiled, or if a variable was bound or the schemes changed since.
+*/
+bool plan_perime(const csc_plan* plan, const csc_var_list* locales, const csc_var_list* sch_in, const csc_var_list* sch_out){
+    return !plan->compile
+        || plan->versions[0] != version_liste(locales)
+        || plan->versions[1] != version_liste(sch_in)
+        || plan->versions[2] != version_liste(sch_out);
+}
+
+
+/*!
+    \brief Finds a field of the structure bound by the node.
+    
+    \note The fields are usually described in the order of the schemes: the one following the previous match is tried first.
+    
+    \param plan The plan.
+    \param nom The name of the field.
+    \param indice The field to try first, updated to the one following the match.
+    \return The field, or NULL if there is none by that name.
+*/
+static const csc_champ* trouver_champ(const csc_plan* plan, const char* nom, size_t* indice){
+    size_t i;
+    
+    if(*indice < plan->nb_champs && !strcmp(plan->champs[*indice].nom, nom))
+        return &plan->champs[(*indice)++];
+    
+    for(i = 0; i < plan->nb_champs; i++){
+        if(!strcmp(plan->champs[i].nom, nom)){
+            *indice = i + 1;
+            return &plan->champs[i];
+        }
+    }
+    
+    return NULL;
+}
+
+
+/*!
+    \brief Resolves the variables of one scheme into the entries of a plan.
+    
+    \param plan The plan; its entries must have room for the whole scheme.
+    \param locales The variables bound by the node.
+    \param schema The scheme.
+*/
+static void resoudre_schema(csc_plan* plan, csc_var_list* locales, csc_var_list* schema){
+    csc_var* locale = NULL;
+    const csc_champ* champ = NULL;
+    csc_entree_plan* entree = NULL;
+    csc_var* var = NULL;
+    size_t indice = 0;
+    size_t i;
+    
+    for(i = 0; i < schema->nombre; i++){
+        var = &schema->vars[i];
+        entree = &plan->entrees[plan->nombre];
+        entree->var.name = var->name;
+        entree->decalage = 0;
+        entree->champ = false;
+    
+        // The variables bound one by one take precedence over the fields
+        if((locale = recup_variable_n(var->name, strlen(var->name), locales))){
+            entree->var.type = locale->type;
+            entree->var.value = locale->value;
+            entree->var.longueur = locale->longueur;
+        } else if((champ = trouver_champ(plan, var->name, &indice))){
+            entree->var.type = champ->type;
+            entree->var.value = NULL;
+            entree->var.longueur = VARTYPE_EST_TABLEAU(champ->type) ? champ->longueur : 1;
+            entree->decalage = champ->decalage;
+            entree->champ = true;
+        } else {
+            plan->manquantes += 1;
+            continue;
+        }
+    
+        if(entree->var.type != var->type)
+            plan->incompatibles += 1;
+    
+        plan->nombre += 1;
+        // An array takes a number and a comma per element
+        plan->taille_json += strlen(entree->var.name) + TAILLE_JSON_VALEUR*entree->var.longueur;
+    }
+}
+
+
+/*!
+    \brief Compiles a plan: resolves the variables of the schemes against those bound by the node.
+    
+    \note A variable the node bound with another type than the scheme's is still read and written in its own type.
+    
+    \param plan The plan.
+    \param locales The variables bound by the node.
+    \param sch_in The input scheme.
+    \param sch_out The output scheme.
+*/
+void plan_compiler(csc_plan* plan, csc_var_list* locales, csc_var_list* sch_in, csc_var_list* sch_out){
+    size_t taille = sch_in->nombre + sch_out->nombre;
+    
+    free(plan->entrees);
+    plan->entrees = safe_malloc((taille ? taille : 1)*sizeof(csc_entree_plan));
+    plan->nombre = 0;
+    plan->taille_json = 0;
+    plan->manquantes = 0;
+    plan->incompatibles = 0;
+    
+    resoudre_schema(plan, locales, sch_in);
+    plan->nombre_in = plan->nombre;
+    resoudre_schema(plan, locales, sch_out);
+    
+    plan->versions[0] = version_liste(locales);
+    plan->versions[1] = version_liste(sch_in);
+    plan->versions[2] = version_liste(sch_out);
+    plan->compile = true;
+}
+
+
+/*!
+    \brief Binds the fields of a C struct, as a whole, to the plan of a node.
+    
+    \param plan The plan.
+    \param champs The description of the fields; it must outlive the binding.
+    \param nombre The number of fields.
+    \param instance The instance of the structure the fields are read from and written to.
+*/
+void plan_lier_structure(csc_plan* plan, const csc_champ* champs, size_t nombre, void* instance){
+    if(champs != plan->champs || nombre != plan->nb_champs)
+        plan->compile = false;
+    
+    plan->champs = champs;
+    plan->nb_champs = champs ? nombre : 0;
+    plan->instance = instance;
+}
+
+
+/*!
+    \brief Gives the variable an entry of a plan reads from and writes to.
+    
+    \param plan The plan.
+    \param entree The entry.
+    \param tampon Where the variable is built, for a field of the structure.
+    \return The variable: the one bound by the node, or tampon.
+*/
+csc_var* plan_variable(const csc_plan* plan, const csc_entree_plan* entree, csc_var* tampon){
+    if(!entree->champ)
+        return (csc_var*)&entree->var;
+    
+    *tampon = entree->var;
+    tampon->value = (char*)plan->instance + entree->decalage;
+    return tampon;
+}
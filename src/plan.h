@@ -0,0 +1,46 @@
+//
+//  plan.h
+//  cruesli
+//
+
+#ifndef plan_h
+#define plan_h
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "varstructs.h"
+
+// A variable of the schemes, resolved
+typedef struct csc_entree_plan {
+    csc_var var;            // The name of the scheme, the type and the address of the node's variable; for a field, value is NULL
+    size_t decalage;        // For a field of the structure bound by the node: its offset
+    bool champ;
+} csc_entree_plan;
+
+// The variables of the schemes, resolved against those a node bound
+typedef struct csc_plan {
+    csc_entree_plan* entrees;   // The input scheme, then the output one
+    size_t nombre;
+    size_t nombre_in;       // The first nombre_in entries are those of the input scheme
+    size_t taille_json;     // Estimated size of a payload in JSON
+    
+    size_t manquantes;      // Variables of the schemes the node did not bind; they are not in the entries
+    size_t incompatibles;   // Variables the node bound with another type than the scheme's
+    
+    const csc_champ* champs;    // The fields of the structure bound by the node, looked up after its list; NULL if none
+    size_t nb_champs;
+    void* instance;             // The instance of the structure they are read from and written to
+    
+    bool compile;
+    size_t versions[3];     // The versions of the node's list and of the schemes it was compiled against
+} csc_plan;
+
+csc_plan* plan_creer(void);
+void plan_detruire(csc_plan* plan);
+bool plan_perime(const csc_plan* plan, const csc_var_list* locales, const csc_var_list* sch_in, const csc_var_list* sch_out);
+void plan_compiler(csc_plan* plan, csc_var_list* locales, csc_var_list* sch_in, csc_var_list* sch_out);
+void plan_lier_structure(csc_plan* plan, const csc_champ* champs, size_t nombre, void* instance);
+csc_var* plan_variable(const csc_plan* plan, const csc_entree_plan* entree, csc_var* tampon);
+
+#endif /* plan_h */
@@ -0,0 +1,231 @@
+//
+//  reprise.c
+//  cruesli
+//
+
+/*!
+    The retries of the requests to the master, and a circuit breaker.
+    
+    A request is retried after a backoff that doubles at each attempt, with full jitter so that
+    the nodes don't all come back at the same time. Whether a failed request can be sent again
+    depends on whether it reached the server: a request that was never sent always can, one that
+    may have been handled only if it's idempotent.
+    
+    After a number of consecutive failures, the breaker trips: the requests are shed for a while,
+    then a single probe is let through, which closes the breaker if it succeeds.
+*/
+
+#include <stdlib.h>
+
+#include <pthread.h>
+#include <curl/curl.h>
+
+#include "safe_malloc.h"
+#include "util.h"
+#include "cscerrs.h"
+#include "reprise.h"
+
+
+/*!
+    \brief Creates a retry policy, with the default settings.
+    
+    \return The policy, to be freed with reprise_detruire().
+*/
+csc_reprise* reprise_creer(void){
+    csc_reprise* reprise = safe_malloc(sizeof(csc_reprise));
+    
+    reprise->delai_connexion_ms = REPRISE_DELAI_CONNEXION_MS;
+    reprise->delai_total_ms = REPRISE_DELAI_TOTAL_MS;
+    reprise->reprises_max = REPRISE_NOMBRE_MAX;
+    reprise->attente_base_ms = REPRISE_ATTENTE_BASE_MS;
+    reprise->attente_max_ms = REPRISE_ATTENTE_MAX_MS;
+    
+    pthread_mutex_init(&reprise->verrou, NULL);
+    
+    reprise->seuil = REPRISE_SEUIL_DISJONCTEUR;
+    reprise->pause_ms = REPRISE_PAUSE_MS;
+    reprise->echecs = 0;
+    reprise->reouverture = 0.0;
+    reprise->sonde = false;
+    
+    reprise->nb_reprises = 0;
+    reprise->nb_declenchements = 0;
+    reprise->nb_rejets = 0;
+    
+    return reprise;
+}
+
+
+/*!
+    \brief Frees a retry policy.
+    
+    \param reprise The policy.
+*/
+void reprise_detruire(csc_reprise* reprise){
+    if(!reprise)
+        return;
+    
+    pthread_mutex_destroy(&reprise->verrou);
+    free(reprise);
+}
+
+
+/*!
+    \brief Sets the timeouts of the policy on a handler.
+    
+    \param reprise The policy.
+    \param handler The handler.
+*/
+void reprise_appliquer_delais(const csc_reprise* reprise, CURL* handler){
+    curl_easy_setopt(handler, CURLOPT_CONNECTTIMEOUT_MS, reprise->delai_connexion_ms);
+    curl_easy_setopt(handler, CURLOPT_TIMEOUT_MS, reprise->delai_total_ms);
+}
+
+
+/*!
+    \brief Asks the circuit breaker whether a request may be sent.
+    
+    \param reprise The policy.
+    \return false if the request should be shed; if true, its outcome must be given to reprise_noter().
+*/
+bool reprise_autoriser(csc_reprise* reprise){
+    bool autorise = true;
+    
+    pthread_mutex_lock(&reprise->verrou);
+    
+    if(reprise->reouverture > 0.0){
+        // Half-open: a single probe at a time
+        if(temps_monotone() < reprise->reouverture || reprise->sonde)
+            autorise = false;
+        else
+            reprise->sonde = true;
+    }
+    
+    if(!autorise)
+        reprise->nb_rejets += 1;
+    
+    pthread_mutex_unlock(&reprise->verrou);
+    
+    return autorise;
+}
+
+
+/*!
+    \brief Tells the circuit breaker how a request went.
+    
+    \param reprise The policy.
+    \param succes Whether the server answered (anything but a server error).
+*/
+void reprise_noter(csc_reprise* reprise, bool succes){
+    pthread_mutex_lock(&reprise->verrou);
+    
+    if(succes){
+        reprise->echecs = 0;
+        reprise->reouverture = 0.0;
+        reprise->sonde = false;
+    } else {
+        reprise->echecs += 1;
+        // A failed probe trips the breaker again right away
+        if(reprise->sonde || (reprise->seuil && reprise->echecs >= reprise->seuil && reprise->reouverture == 0.0)){
+            reprise->reouverture = temps_monotone() + reprise->pause_ms*1e-3;
+            reprise->nb_declenchements += 1;
+        }
+        reprise->sonde = false;
+    }
+    
+    pthread_mutex_unlock(&reprise->verrou);
+}
+
+
+/*!
+    \brief Tells whether a failed request can be sent again.
+    
+    \param handler The handler, after the request is done.
+    \param res The curl result of the request.
+    \param idempotent Whether the request can be handled twice by the server without harm.
+    \return true if it can be retried.
+*/
+bool reprise_possible(CURL* handler, CURLcode res, bool idempotent){
+    long code_http = 0;
+    long envoye = 0;
+    
+    if(res == CURLE_OK){
+        curl_easy_getinfo(handler, CURLINFO_RESPONSE_CODE, &code_http);
+        // 503: the server says it did not handle the request; behind a gateway, we can't tell
+        if(code_http == 503)
+            return true;
+        return idempotent && (code_http == 502 || code_http == 504);
+    }
+    
+    switch (res) {
+        case CURLE_COULDNT_RESOLVE_PROXY:
+        case CURLE_COULDNT_RESOLVE_HOST:
+        case CURLE_COULDNT_CONNECT:
+            return true;
+            
+        case CURLE_OPERATION_TIMEDOUT:
+        case CURLE_SEND_ERROR:
+        case CURLE_RECV_ERROR:
+        case CURLE_GOT_NOTHING:
+        case CURLE_PARTIAL_FILE:
+            // Nothing was sent (e.g. a timeout while connecting): the server can't have handled it
+            if(curl_easy_getinfo(handler, CURLINFO_REQUEST_SIZE, &envoye) == CURLE_OK && envoye == 0)
+                return true;
+            return idempotent;
+            
+        default:
+            return false;
+    }
+}
+
+
+/*!
+    \brief Waits before retrying a request: a random time, up to a backoff doubling at each attempt.
+    
+    \param reprise The policy.
+    \param tentative The number of retries already made for that request.
+    \param relais Whether another master server takes the request over: it's then sent again right away.
+    \return false if the request should not be retried anymore.
+*/
+bool reprise_attendre(csc_reprise* reprise, unsigned tentative, bool relais){
+    double attente = reprise->attente_base_ms*1e-3;
+    double plafond = reprise->attente_max_ms*1e-3;
+    
+    if(tentative >= reprise->reprises_max)
+        return false;
+    
+    while(tentative-- && attente < plafond)
+        attente *= 2;
+    if(attente > plafond)
+        attente = plafond;
+    
+    pthread_mutex_lock(&reprise->verrou);
+    reprise->nb_reprises += 1;
+    pthread_mutex_unlock(&reprise->verrou);
+    
+    if(relais)
+        return true;
+    
+    // Full jitter: the nodes that failed together don't come back together
+    attendre(attente*aleatoire());
+    
+    return true;
+}
+
+
+/*!
+    \brief Converts the curl result of a request into a status.
+    
+    \param res The curl result.
+    \return 0 if the request went through, or an error code defined in cruesli.h.
+*/
+int reprise_statut(CURLcode res){
+    switch (res) {
+        case CURLE_OK:
+            return CSC_NO_ERROR;
+        case CURLE_OPERATION_TIMEDOUT:
+            return CSC_ERR_NONFATAL_TIMEOUT;
+        default:
+            return CSC_FATAL_CURL_ERROR;
+    }
+}
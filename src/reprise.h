@@ -0,0 +1,54 @@
+//
+//  reprise.h
+//  cruesli
+//
+
+#ifndef reprise_h
+#define reprise_h
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include <pthread.h>
+#include <curl/curl.h>
+
+// Defaults: a master that restarts should be waited for, a hung one should not
+#define REPRISE_DELAI_CONNEXION_MS  10000
+#define REPRISE_DELAI_TOTAL_MS      60000
+#define REPRISE_NOMBRE_MAX          8
+#define REPRISE_ATTENTE_BASE_MS     200
+#define REPRISE_ATTENTE_MAX_MS      10000
+#define REPRISE_SEUIL_DISJONCTEUR   5
+#define REPRISE_PAUSE_MS            2000
+
+// How the requests to the master are retried, and the circuit breaker shared by all of them
+typedef struct csc_reprise {
+    long delai_connexion_ms;    // 0: curl's default
+    long delai_total_ms;        // 0: no limit
+    unsigned reprises_max;      // Retries after the first attempt
+    long attente_base_ms;       // Backoff before the first retry; doubled for each of the next ones
+    long attente_max_ms;        // Cap of the backoff
+    
+    pthread_mutex_t verrou;     // Protects everything below
+    
+    unsigned seuil;             // Consecutive failures that trip the breaker; 0: it never trips
+    long pause_ms;              // How long a tripped breaker sheds the requests
+    unsigned echecs;            // Consecutive failures
+    double reouverture;         // When the tripped breaker lets a probe through; 0 if it's closed
+    bool sonde;                 // The probe of a half-open breaker is in flight
+    
+    size_t nb_reprises;         // Requests retried
+    size_t nb_declenchements;   // Times the breaker tripped
+    size_t nb_rejets;           // Attempts shed by the breaker
+} csc_reprise;
+
+csc_reprise* reprise_creer(void);
+void reprise_detruire(csc_reprise* reprise);
+void reprise_appliquer_delais(const csc_reprise* reprise, CURL* handler);
+bool reprise_autoriser(csc_reprise* reprise);
+void reprise_noter(csc_reprise* reprise, bool succes);
+bool reprise_possible(CURL* handler, CURLcode res, bool idempotent);
+bool reprise_attendre(csc_reprise* reprise, unsigned tentative, bool relais);
+int reprise_statut(CURLcode res);
+
+#endif /* reprise_h */
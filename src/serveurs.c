@@ -0,0 +1,332 @@
+//
+//  serveurs.c
+//  cruesli
+//
+
+/*!
+    The master servers the requests are spread over, when there are several of them.
+    
+    Each request goes to the server that should answer it first: the one with the fewest requests
+    in flight, weighted by how long its requests usually take. A server that fails is left aside
+    for a while (longer if it keeps failing), and the requests that failed on it are sent to another
+    one; once the pause is over, it's given another chance.
+*/
+
+#include <string.h>
+#include <stdlib.h>
+
+#include <pthread.h>
+#include <curl/curl.h>
+
+#include "safe_malloc.h"
+#include "util.h"
+#include "serveurs.h"
+
+// Weight of the last request in the moving average of the latency of a server
+#define LISSAGE_LATENCE 0.2
+
+// How fast the latency of a server that gets no requests is forgotten, in seconds
+#define OUBLI_LATENCE 0.5
+
+// The pause of a server that keeps failing stops doubling after that many failures
+#define ECHECS_PAUSE_MAX 6
+
+static const char* chemins_api[API_NOMBRE] = {
+    "/api/v1/register-master",      // API_ENREGISTREMENT
+    "/api/v1/unregister-master",    // API_DESENREGISTREMENT
+    "/api/v1/register-nodes",       // API_NOEUDS
+    "/api/v1/fetch-work-for-node",  // API_TRAVAIL
+    "/api/v1/submit-results",       // API_SOUMISSION
+    "/api/v1/unregister-node"       // API_RETRAIT_NOEUD
+};
+
+
+/*!
+    \brief Sets up a master server from its address.
+    
+    \param serveur The server.
+    \param adresse Its address: a URL, or "unix:" followed by the path of its socket.
+    \param taille The length of the address.
+*/
+static void preparer_serveur(csc_serveur* serveur, const char* adresse, size_t taille){
+    size_t taille_prefixe = strlen(PREFIXE_UNIX);
+    const char* base = adresse;
+    size_t taille_base = taille;
+    size_t taille_chemin;
+    int api;
+    
+    serveur->chemin_socket = NULL;
+    
+    // Over a unix socket, the host in the URLs is just a formality
+    if(taille >= taille_prefixe && !strncmp(adresse, PREFIXE_UNIX, taille_prefixe)){
+        serveur->chemin_socket = safe_malloc((taille - taille_prefixe + 1)*sizeof(char));
+        memcpy(serveur->chemin_socket, adresse + taille_prefixe, taille - taille_prefixe);
+        serveur->chemin_socket[taille - taille_prefixe] = '\0';
+        base = HOTE_UNIX;
+        taille_base = strlen(HOTE_UNIX);
+    }
+    
+    for(api = 0; api < API_NOMBRE; api++){
+        taille_chemin = strlen(chemins_api[api]);
+        serveur->urls[api] = safe_malloc((taille_base + taille_chemin + 1)*sizeof(char));
+        memcpy(serveur->urls[api], base, taille_base);
+        memcpy(serveur->urls[api] + taille_base, chemins_api[api], taille_chemin + 1);
+    }
+    
+    serveur->en_cours = 0;
+    serveur->latence = 0.0;
+    serveur->mesure = 0.0;
+    serveur->echecs = 0;
+    serveur->retour = 0.0;
+    serveur->nb_requetes = 0;
+    serveur->nb_echecs = 0;
+}
+
+
+/*!
+    \brief Creates the pool of the master servers.
+    
+    \param adresses The addresses of the servers, separated by SEPARATEUR_SERVEURS.
+    \return The pool, to be freed with serveurs_detruire(); it holds at least one server.
+*/
+csc_serveurs* serveurs_creer(const char* adresses){
+    csc_serveurs* serveurs = safe_malloc(sizeof(csc_serveurs));
+    const char* debut = adresses;
+    const char* fin = NULL;
+    size_t nombre = 1;
+    
+    for(fin = adresses; *fin; fin++)
+        if(*fin == SEPARATEUR_SERVEURS)
+            nombre += 1;
+    
+    serveurs->liste = safe_malloc(nombre*sizeof(csc_serveur));
+    serveurs->nombre = 0;
+    
+    while(1){
+        fin = strchr(debut, SEPARATEUR_SERVEURS);
+        if(!fin)
+            fin = debut + strlen(debut);
+    
+        // An empty address is skipped, unless it's the only one
+        if(fin > debut || (!*fin && !serveurs->nombre))
+            preparer_serveur(&serveurs->liste[serveurs->nombre++], debut, fin - debut);
+    
+        if(!*fin)
+            break;
+        debut = fin + 1;
+    }
+    
+    pthread_mutex_init(&serveurs->verrou, NULL);
+    serveurs->pause_ms = SERVEURS_PAUSE_MS;
+    serveurs->rotation = 0;
+    
+    return serveurs;
+}
+
+
+/*!
+    \brief Frees the pool of the master servers.
+    
+    \param serveurs The pool.
+*/
+void serveurs_detruire(csc_serveurs* serveurs){
+    size_t i;
+    int api;
+    
+    if(!serveurs)
+        return;
+    
+    for(i = 0; i < serveurs->nombre; i++){
+        free(serveurs->liste[i].chemin_socket);
+        for(api = 0; api < API_NOMBRE; api++)
+            free(serveurs->liste[i].urls[api]);
+    }
+    
+    pthread_mutex_destroy(&serveurs->verrou);
+    free(serveurs->liste);
+    free(serveurs);
+}
+
+
+/*!
+    \brief Tells whether a server can be sent requests. The lock of the pool must be held.
+    
+    \param serveur The server.
+    \param maintenant The current time (see temps_monotone()).
+    \return true if it's up, or if its pause is over.
+*/
+static bool serveur_disponible(const csc_serveur* serveur, double maintenant){
+    return serveur->retour <= maintenant;
+}
+
+
+/*!
+    \brief Estimates the latency of a server. The lock of the pool must be held.
+    
+    \note A slow server gets fewer requests, so its latency is updated less often: it's forgotten over time,
+           so that the server is given another chance once it's faster again.
+    
+    \param serveur The server.
+    \param reference The latency of the fastest server.
+    \param maintenant The current time (see temps_monotone()).
+    \return The estimated latency, in seconds.
+*/
+static double estimer_latence(const csc_serveur* serveur, double reference, double maintenant){
+    if(serveur->latence <= reference)
+        return serveur->latence > 0.0 ? serveur->latence : reference;
+    
+    return reference + (serveur->latence - reference)/(1.0 + (maintenant - serveur->mesure)/OUBLI_LATENCE);
+}
+
+
+/*!
+    \brief Chooses the master server a request should be sent to, and counts the request as in flight on it.
+    
+    \note The server that should answer first is chosen: the one with the fewest requests in flight,
+           weighted by its latency. The servers which latency is not known yet are assumed to be as fast
+           as the fastest one. If every server is left aside, the one which pause ends first is chosen.
+    
+    \param serveurs The pool.
+    \param evite A server to avoid if another one is available (the one a request just failed on), or NULL.
+    \return The server; the outcome of the request must be given to serveurs_rendre().
+*/
+csc_serveur* serveurs_choisir(csc_serveurs* serveurs, const csc_serveur* evite){
+    csc_serveur* choix = NULL;
+    csc_serveur* serveur = NULL;
+    double maintenant = temps_monotone();
+    double reference = 0.0;
+    double cout = 0.0;
+    double meilleur = 0.0;
+    size_t i;
+    
+    pthread_mutex_lock(&serveurs->verrou);
+    
+    if(serveurs->nombre == 1){
+        choix = serveurs->liste;
+        goto end;
+    }
+    
+    for(i = 0; i < serveurs->nombre; i++){
+        serveur = &serveurs->liste[i];
+        if(serveur->latence > 0.0 && (reference == 0.0 || serveur->latence < reference))
+            reference = serveur->latence;
+    }
+    if(reference == 0.0)
+        reference = 1.0;
+    
+    for(i = 0; i < serveurs->nombre; i++){
+        serveur = &serveurs->liste[(serveurs->rotation + i) % serveurs->nombre];
+        if(serveur == evite || !serveur_disponible(serveur, maintenant))
+            continue;
+    
+        cout = (serveur->en_cours + 1)*estimer_latence(serveur, reference, maintenant);
+        if(!choix || cout < meilleur){
+            choix = serveur;
+            meilleur = cout;
+        }
+    }
+    
+    // Nothing better than the server to avoid, if it's available
+    if(!choix && evite && serveur_disponible(evite, maintenant))
+        choix = (csc_serveur*)evite;
+    
+    // Every server is left aside: the first one to come back gets the request
+    if(!choix){
+        choix = serveurs->liste;
+        for(i = 1; i < serveurs->nombre; i++)
+            if(serveurs->liste[i].retour < choix->retour)
+                choix = &serveurs->liste[i];
+    }
+    
+    serveurs->rotation += 1;
+    
+end:
+    choix->en_cours += 1;
+    pthread_mutex_unlock(&serveurs->verrou);
+    
+    return choix;
+}
+
+
+/*!
+    \brief Tells whether another master server than the one a request just failed on can take it over right away.
+    
+    \param serveurs The pool.
+    \param evite The server the request failed on.
+    \return true if another server is available.
+*/
+bool serveurs_relais(csc_serveurs* serveurs, const csc_serveur* evite){
+    double maintenant = temps_monotone();
+    bool relais = false;
+    size_t i;
+    
+    if(serveurs->nombre == 1)
+        return false;
+    
+    pthread_mutex_lock(&serveurs->verrou);
+    for(i = 0; i < serveurs->nombre && !relais; i++)
+        relais = &serveurs->liste[i] != evite && serveur_disponible(&serveurs->liste[i], maintenant);
+    pthread_mutex_unlock(&serveurs->verrou);
+    
+    return relais;
+}
+
+
+/*!
+    \brief Tells the pool how a request to one of the master servers went.
+    
+    \param serveurs The pool.
+    \param serveur The server the request was sent to (see serveurs_choisir()).
+    \param handler The handler, after the request is done.
+    \param succes Whether the server answered (anything but a server error).
+    \param mesurer Whether how long the request took tells the latency of the server; not for a request it
+                    may hold until it has work.
+*/
+void serveurs_rendre(csc_serveurs* serveurs, csc_serveur* serveur, CURL* handler, bool succes, bool mesurer){
+    double duree = 0.0;
+    double maintenant = 0.0;
+    double poids = 0.0;
+    unsigned doublements;
+    
+    if(succes && mesurer && curl_easy_getinfo(handler, CURLINFO_TOTAL_TIME, &duree) != CURLE_OK)
+        duree = 0.0;
+    
+    pthread_mutex_lock(&serveurs->verrou);
+    
+    serveur->en_cours -= 1;
+    serveur->nb_requetes += 1;
+    
+    if(succes){
+        if(duree > 0.0){
+            // The older the average, the more the last request counts
+            maintenant = temps_monotone();
+            poids = (maintenant - serveur->mesure)/(maintenant - serveur->mesure + OUBLI_LATENCE);
+            poids = LISSAGE_LATENCE + (1.0 - LISSAGE_LATENCE)*poids;
+            serveur->latence = serveur->latence > 0.0 ? serveur->latence + poids*(duree - serveur->latence) : duree;
+            serveur->mesure = maintenant;
+        }
+        serveur->echecs = 0;
+        serveur->retour = 0.0;
+    } else {
+        serveur->nb_echecs += 1;
+        serveur->echecs += 1;
+        doublements = serveur->echecs < ECHECS_PAUSE_MAX ? serveur->echecs - 1 : ECHECS_PAUSE_MAX - 1;
+        serveur->retour = temps_monotone() + serveurs->pause_ms*1e-3*(1 << doublements);
+    }
+    
+    pthread_mutex_unlock(&serveurs->verrou);
+}
+
+
+/*!
+    \brief Points a handler to an endpoint of a master server.
+    
+    \param serveur The server.
+    \param handler The handler.
+    \param api The endpoint (API_...).
+*/
+void serveur_viser(const csc_serveur* serveur, CURL* handler, int api){
+    curl_easy_setopt(handler, CURLOPT_URL, serveur->urls[api]);
+    // NULL goes back to TCP, should the previous request have gone through a socket
+    curl_easy_setopt(handler, CURLOPT_UNIX_SOCKET_PATH, serveur->chemin_socket);
+}
@@ -0,0 +1,67 @@
+//
+//  serveurs.h
+//  cruesli
+//
+
+#ifndef serveurs_h
+#define serveurs_h
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include <pthread.h>
+#include <curl/curl.h>
+
+// The endpoints of the API of a master server
+#define API_ENREGISTREMENT      0
+#define API_DESENREGISTREMENT   1
+#define API_NOEUDS              2
+#define API_TRAVAIL             3
+#define API_SOUMISSION          4
+#define API_RETRAIT_NOEUD       5
+#define API_NOMBRE              6
+
+// The addresses of the master servers listening on a unix socket: "unix:/path/to.sock"
+#define PREFIXE_UNIX    "unix:"
+#define HOTE_UNIX       "http://localhost"
+
+// Separates the master servers in the address given to init_cruesli()
+#define SEPARATEUR_SERVEURS ','
+
+// Default: how long a master server that failed is left aside, before being given another chance
+#define SERVEURS_PAUSE_MS   1000
+
+// One of the master servers
+typedef struct csc_serveur {
+    char* chemin_socket;        // The unix socket it listens on; NULL to reach it over TCP
+    char* urls[API_NOMBRE];     // The complete URLs of its endpoints
+    
+    // Protected by the lock of the pool
+    size_t en_cours;            // Requests in flight
+    double latence;             // Moving average of the duration of its requests, in seconds; 0 until one went through
+    double mesure;              // When latence was last updated
+    unsigned echecs;            // Consecutive failures
+    double retour;              // When it's given another chance after failing; 0 if it's up
+    
+    size_t nb_requetes;
+    size_t nb_echecs;
+} csc_serveur;
+
+// The master servers the requests are spread over
+typedef struct csc_serveurs {
+    csc_serveur* liste;
+    size_t nombre;
+    
+    pthread_mutex_t verrou;
+    long pause_ms;              // How long a server that failed is left aside; doubled while it keeps failing
+    size_t rotation;            // Where the search for the best server starts, so that ties are spread
+} csc_serveurs;
+
+csc_serveurs* serveurs_creer(const char* adresses);
+void serveurs_detruire(csc_serveurs* serveurs);
+csc_serveur* serveurs_choisir(csc_serveurs* serveurs, const csc_serveur* evite);
+bool serveurs_relais(csc_serveurs* serveurs, const csc_serveur* evite);
+void serveurs_rendre(csc_serveurs* serveurs, csc_serveur* serveur, CURL* handler, bool succes, bool mesurer);
+void serveur_viser(const csc_serveur* serveur, CURL* handler, int api);
+
+#endif /* serveurs_h */
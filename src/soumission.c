@@ -0,0 +1,229 @@
+//
+//  soumission.c
+//  cruesli
+//
+
+/*!
+    Buffer of the results of all the nodes, waiting to be sent to the master server in a single request.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include <pthread.h>
+
+#include "safe_malloc.h"
+#include "util.h"
+#include "soumission.h"
+
+
+/*!
+    \brief Creates an empty results buffer.
+    
+    \param seuil_nombre The number of results that triggers a flush.
+    \param seuil_taille The size of the results, in bytes, that triggers a flush.
+    \param delai_max How long a result may wait before being sent, in seconds.
+    \return A pointer to the new buffer.
+*/
+csc_groupe_soumission* groupe_creer(size_t seuil_nombre, size_t seuil_taille, double delai_max){
+    csc_groupe_soumission* groupe = safe_malloc(sizeof(csc_groupe_soumission));
+    
+    pthread_mutex_init(&groupe->verrou, NULL);
+    pthread_cond_init(&groupe->reveil, NULL);
+    pthread_cond_init(&groupe->vide, NULL);
+    
+    groupe->tete = NULL;
+    groupe->queue = NULL;
+    groupe->nombre = 0;
+    groupe->taille = 0;
+    groupe->premier = 0.0;
+    groupe->en_cours = false;
+    groupe->forcer = false;
+    groupe->arret = false;
+    
+    groupe->seuil_nombre = seuil_nombre;
+    groupe->seuil_taille = seuil_taille;
+    groupe->delai_max = delai_max;
+    
+    transfert_initialiser(&groupe->envoi, NULL);
+    groupe->nb_envois = 0;
+    groupe->nb_resultats = 0;
+    
+    return groupe;
+}
+
+
+/*!
+    \brief Frees the results buffer.
+    
+    \param groupe The buffer; it should have been flushed beforehand.
+*/
+void groupe_detruire(csc_groupe_soumission* groupe){
+    csc_resultat* suivant;
+    
+    if(!groupe)
+        return;
+    
+    while(groupe->tete){
+        suivant = groupe->tete->suivant;
+        free(groupe->tete->donnees);
+        free(groupe->tete);
+        groupe->tete = suivant;
+    }
+    
+    transfert_detruire(&groupe->envoi);
+    
+    pthread_cond_destroy(&groupe->reveil);
+    pthread_cond_destroy(&groupe->vide);
+    pthread_mutex_destroy(&groupe->verrou);
+    free(groupe);
+}
+
+
+/*!
+    \brief Buffers the result of a node.
+    
+    \param groupe The buffer.
+    \param noeud The node the result belongs to.
+    \param donnees The serialized result; the buffer takes ownership of it.
+    \param taille The size of the serialized result.
+    \param avec_id Whether the result carries the id of its task.
+*/
+void groupe_ajouter(csc_groupe_soumission* groupe, csc_node_info* noeud, char* donnees, size_t taille, bool avec_id){
+    csc_resultat* resultat = safe_malloc(sizeof(csc_resultat));
+    resultat->noeud = noeud;
+    resultat->donnees = donnees;
+    resultat->taille = taille;
+    resultat->avec_id = avec_id;
+    resultat->suivant = NULL;
+    
+    pthread_mutex_lock(&groupe->verrou);
+    
+    if(groupe->queue)
+        groupe->queue->suivant = resultat;
+    else {
+        groupe->tete = resultat;
+        groupe->premier = temps_monotone();
+    }
+    groupe->queue = resultat;
+    groupe->nombre += 1;
+    groupe->taille += resultat->taille;
+    
+    // The first result starts the timer; a full buffer must be sent now
+    if(groupe->nombre == 1 || groupe->nombre >= groupe->seuil_nombre || groupe->taille >= groupe->seuil_taille)
+        pthread_cond_signal(&groupe->reveil);
+    
+    pthread_mutex_unlock(&groupe->verrou);
+}
+
+
+/*!
+    \brief Waits until the buffered results should be sent, and takes them out of the buffer.
+    
+    \param groupe The buffer.
+    \return The list of results to send, or NULL if the buffer was stopped and is empty.
+*/
+csc_resultat* groupe_attendre_lot(csc_groupe_soumission* groupe){
+    csc_resultat* lot = NULL;
+    struct timespec echeance;
+    double attente;
+    
+    pthread_mutex_lock(&groupe->verrou);
+    
+    while(true){
+        if(groupe->nombre){
+            if(groupe->arret || groupe->forcer
+               || groupe->nombre >= groupe->seuil_nombre
+               || groupe->taille >= groupe->seuil_taille)
+                break;
+            
+            attente = groupe->premier + groupe->delai_max - temps_monotone();
+            if(attente <= 0.0)
+                break;
+            
+            // pthread_cond_timedwait needs a deadline on the realtime clock
+            clock_gettime(CLOCK_REALTIME, &echeance);
+            echeance.tv_sec += (time_t)attente;
+            echeance.tv_nsec += (long)((attente - (time_t)attente)*1e9);
+            if(echeance.tv_nsec >= 1000000000L){
+                echeance.tv_sec += 1;
+                echeance.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&groupe->reveil, &groupe->verrou, &echeance);
+        } else {
+            groupe->forcer = false;
+            if(groupe->arret)
+                break;
+            pthread_cond_wait(&groupe->reveil, &groupe->verrou);
+        }
+    }
+    
+    lot = groupe->tete;
+    if(lot)
+        groupe->en_cours = true;
+    groupe->tete = NULL;
+    groupe->queue = NULL;
+    groupe->nb_resultats += groupe->nombre;
+    groupe->nombre = 0;
+    groupe->taille = 0;
+    
+    pthread_mutex_unlock(&groupe->verrou);
+    
+    return lot;
+}
+
+
+/*!
+    \brief Frees a list of results that was sent, and wakes up those waiting for the flush.
+    
+    \param groupe The buffer.
+    \param lot The list returned by groupe_attendre_lot().
+*/
+void groupe_lot_envoye(csc_groupe_soumission* groupe, csc_resultat* lot){
+    csc_resultat* suivant;
+    
+    while(lot){
+        suivant = lot->suivant;
+        free(lot->donnees);
+        free(lot);
+        lot = suivant;
+    }
+    
+    pthread_mutex_lock(&groupe->verrou);
+    groupe->en_cours = false;
+    groupe->nb_envois += 1;
+    pthread_cond_broadcast(&groupe->vide);
+    pthread_mutex_unlock(&groupe->verrou);
+}
+
+
+/*!
+    \brief Sends the buffered results right away, and waits until they are sent.
+    
+    \param groupe The buffer.
+*/
+void groupe_vider(csc_groupe_soumission* groupe){
+    pthread_mutex_lock(&groupe->verrou);
+    
+    groupe->forcer = true;
+    pthread_cond_signal(&groupe->reveil);
+    while(groupe->nombre || groupe->en_cours)
+        pthread_cond_wait(&groupe->vide, &groupe->verrou);
+    
+    pthread_mutex_unlock(&groupe->verrou);
+}
+
+
+/*!
+    \brief Asks the flushing thread to send what's left and to stop.
+    
+    \param groupe The buffer.
+*/
+void groupe_arreter(csc_groupe_soumission* groupe){
+    pthread_mutex_lock(&groupe->verrou);
+    groupe->arret = true;
+    pthread_cond_signal(&groupe->reveil);
+    pthread_mutex_unlock(&groupe->verrou);
+}
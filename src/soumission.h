@@ -0,0 +1,59 @@
+//
+//  soumission.h
+//  cruesli
+//
+
+#ifndef soumission_h
+#define soumission_h
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include <pthread.h>
+
+#include "www.h"
+
+typedef struct csc_node_info csc_node_info;
+
+typedef struct csc_resultat {
+    csc_node_info* noeud;
+    char* donnees;                  // {"nodeid": ..., "payload": {...}}, serialized in the wire format
+    size_t taille;
+    bool avec_id;                   // It carries the id of its task, so that the server can tell it apart from a copy of it
+    struct csc_resultat* suivant;
+} csc_resultat;
+
+typedef struct csc_groupe_soumission {
+    pthread_mutex_t verrou;         // Protects everything below, and the nodes' deferred statuses
+    pthread_cond_t reveil;          // Signaled when a flush may be needed
+    pthread_cond_t vide;            // Signaled when a flush is done
+    
+    csc_resultat* tete;
+    csc_resultat* queue;
+    size_t nombre;                  // Number of buffered results
+    size_t taille;                  // Size of the buffered results, in bytes
+    double premier;                 // When the oldest buffered result was added
+    bool en_cours;                  // A flush is being sent
+    bool forcer;                    // Flush now, whatever the thresholds
+    bool arret;
+    
+    size_t seuil_nombre;
+    size_t seuil_taille;
+    double delai_max;               // In seconds
+    
+    www_transfert envoi;            // The requests of the flushing thread, on a handler of its own
+    pthread_t thread;               // The flushing thread
+    
+    size_t nb_envois;               // Number of requests sent
+    size_t nb_resultats;            // Number of results sent
+} csc_groupe_soumission;
+
+csc_groupe_soumission* groupe_creer(size_t seuil_nombre, size_t seuil_taille, double delai_max);
+void groupe_detruire(csc_groupe_soumission* groupe);
+void groupe_ajouter(csc_groupe_soumission* groupe, csc_node_info* noeud, char* donnees, size_t taille, bool avec_id);
+csc_resultat* groupe_attendre_lot(csc_groupe_soumission* groupe);
+void groupe_lot_envoye(csc_groupe_soumission* groupe, csc_resultat* lot);
+void groupe_vider(csc_groupe_soumission* groupe);
+void groupe_arreter(csc_groupe_soumission* groupe);
+
+#endif /* soumission_h */
@@ -0,0 +1,668 @@
+//
+//  tableaux.c
+//  cruesli
+//
+
+/*!
+    Conversions of the values of the Cascada variables, one at a time or a whole array at once.
+    
+    The arrays travel packed in the binary format: when they are sent in the type they are bound
+    with, they are copied as is; the usual conversions between floats, doubles and 32-bit integers
+    are done several elements at a time with SSE2, where it's available. So are those between floats
+    and bfloat16s, and between floats and half floats when the library is built for a CPU with F16C
+    (make NATIVE=1).
+    
+    C has no type for half floats or bfloat16s: the variables of those types are uint16_t holding
+    their bits, converted with demi_vers_float(), float_vers_demi(), bf16_vers_float() and float_vers_bf16().
+*/
+
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __F16C__
+#include <immintrin.h>
+#endif
+
+#include "varstructs.h"
+#include "tableaux.h"
+
+
+/*!
+    \brief Tells whether the host stores its numbers least significant byte first.
+    
+    \return true on a little-endian host.
+*/
+static bool hote_petit_boutiste(void){
+    const uint16_t un = 1;
+    uint8_t premier;
+    
+    memcpy(&premier, &un, 1);
+    return premier == 1;
+}
+
+
+/*!
+    \brief Converts a half float (IEEE 754 binary16) to a float; the conversion is exact.
+    
+    \param demi The bits of the half float.
+    \return Its value.
+*/
+float demi_vers_float(uint16_t demi){
+    uint32_t signe = (uint32_t)(demi & 0x8000) << 16;
+    uint32_t exposant = (demi >> 10) & 0x1f;
+    uint32_t mantisse = demi & 0x3ff;
+    uint32_t bits;
+    float valeur;
+    
+    if(exposant == 0){
+        // Zero, or a subnormal: a multiple of 2^-24
+        valeur = mantisse * (1.0f/16777216.0f);
+        return signe ? -valeur : valeur;
+    }
+    
+    if(exposant == 31)
+        bits = signe | 0x7f800000 | mantisse << 13;
+    else
+        bits = signe | (exposant + 112) << 23 | mantisse << 13;
+    
+    memcpy(&valeur, &bits, sizeof(valeur));
+    return valeur;
+}
+
+
+/*!
+    \brief Converts a float to a half float (IEEE 754 binary16), rounding to the nearest.
+    
+    \param valeur The float; beyond the range of the half floats, it becomes an infinity.
+    \return The bits of the half float.
+*/
+uint16_t float_vers_demi(float valeur){
+    uint32_t bits;
+    uint32_t signe, absolu, exposant, mantisse, decalage, reste, moitie;
+    uint32_t demi;
+    
+    memcpy(&bits, &valeur, sizeof(bits));
+    signe = (bits >> 16) & 0x8000;
+    absolu = bits & 0x7fffffff;
+    exposant = absolu >> 23;
+    
+    if(absolu > 0x7f800000)
+        return (uint16_t)(signe | 0x7e00);
+    // 65520 and above round to the infinity
+    if(absolu >= 0x477ff000)
+        return (uint16_t)(signe | 0x7c00);
+    
+    if(absolu < 0x38800000){
+        // A subnormal half float: the value in units of 2^-24
+        decalage = 126 - exposant;
+        if(decalage > 24)
+            return (uint16_t)signe;
+        mantisse = (absolu & 0x7fffff) | 0x800000;
+        demi = mantisse >> decalage;
+        reste = mantisse & ((1u << decalage) - 1);
+        moitie = 1u << (decalage - 1);
+    } else {
+        demi = (exposant - 112) << 10 | (absolu & 0x7fffff) >> 13;
+        reste = absolu & 0x1fff;
+        moitie = 0x1000;
+    }
+    
+    // Ties to even; a carry into the exponent is what rounding up should do
+    if(reste > moitie || (reste == moitie && (demi & 1)))
+        demi += 1;
+    
+    return (uint16_t)(signe | demi);
+}
+
+
+/*!
+    \brief Converts a bfloat16 to a float; the conversion is exact.
+    
+    \param bf16 The bits of the bfloat16.
+    \return Its value.
+*/
+float bf16_vers_float(uint16_t bf16){
+    uint32_t bits = (uint32_t)bf16 << 16;
+    float valeur;
+    
+    memcpy(&valeur, &bits, sizeof(valeur));
+    return valeur;
+}
+
+
+/*!
+    \brief Converts a float to a bfloat16, rounding to the nearest.
+    
+    \param valeur The float.
+    \return The bits of the bfloat16.
+*/
+uint16_t float_vers_bf16(float valeur){
+    uint32_t bits;
+    
+    memcpy(&bits, &valeur, sizeof(bits));
+    
+    // A NaN stays one, even if its payload is in the bits that are dropped
+    if((bits & 0x7fffffff) > 0x7f800000)
+        return (uint16_t)(bits >> 16 | 0x40);
+    
+    return (uint16_t)((bits + 0x7fff + ((bits >> 16) & 1)) >> 16);
+}
+
+
+/*!
+    \brief Gives the integer values of a floating point number, as vartype_affecter() expects them.
+    
+    \note The number is truncated toward 0, and saturated to the range of the type: converting it
+           directly is undefined behaviour for a NaN, or a number out of that range.
+    
+    \param flottant The number.
+    \param entier Where its signed value is written; 0 for a NaN.
+    \param naturel Where its unsigned value is written (modulo 2^64 for a negative number); 0 for a NaN.
+*/
+void flottant_vers_entiers(double flottant, int64_t* entier, uint64_t* naturel){
+    // 2^63 and 2^64 are exact in a double, unlike INT64_MAX and UINT64_MAX
+    if(flottant != flottant){
+        *entier = 0;
+        *naturel = 0;
+    } else if(flottant >= 18446744073709551616.0){
+        *entier = INT64_MAX;
+        *naturel = UINT64_MAX;
+    } else if(flottant >= 9223372036854775808.0){
+        *entier = INT64_MAX;
+        *naturel = (uint64_t)flottant;
+    } else if(flottant > -9223372036854775808.0){
+        *entier = (int64_t)flottant;
+        *naturel = (uint64_t)*entier;
+    } else {
+        *entier = INT64_MIN;
+        *naturel = (uint64_t)*entier;
+    }
+}
+
+
+/*!
+    \brief Gives the size of a value of a type; for an array, the size of one of its elements.
+    
+    \param type The type (VARTYPE_...).
+    \return The size, in bytes; 0 if the type is unknown.
+*/
+size_t vartype_taille(csc_var_type type){
+    switch (VARTYPE_BASE(type)) {
+        case VARTYPE_U8:
+            return sizeof(uint8_t);
+        case VARTYPE_U32:
+            return sizeof(uint32_t);
+        case VARTYPE_U64:
+            return sizeof(uint64_t);
+        case VARTYPE_FLOAT:
+            return sizeof(float);
+        case VARTYPE_DOUBLE:
+            return sizeof(double);
+        case VARTYPE_I32:
+            return sizeof(int32_t);
+        case VARTYPE_I64:
+            return sizeof(int64_t);
+        case VARTYPE_I8:
+            return sizeof(int8_t);
+        case VARTYPE_U16:
+        case VARTYPE_I16:
+        case VARTYPE_FP16:
+        case VARTYPE_BF16:
+            return sizeof(uint16_t);
+        default:
+            return 0;
+    }
+}
+
+
+/*!
+    \brief Gives the type the elements of an array are packed in, in the binary format.
+    
+    \param type The type of the array.
+    \return The type of its elements; bfloat16s, which have no typed array of their own, are packed as floats.
+*/
+csc_var_type vartype_paquet(csc_var_type type){
+    if(VARTYPE_BASE(type) == VARTYPE_BF16)
+        return VARTYPE_FLOAT;
+    return VARTYPE_BASE(type);
+}
+
+
+/*!
+    \brief Writes a number into a C variable, converting it to the type of the variable.
+    
+    \param adresse The address of the variable.
+    \param type The type of the variable; for an array, the type of its elements.
+    \param entier The number, if it's an integer.
+    \param naturel The number, if it's an integer (modulo 2^64, for the unsigned types).
+    \param flottant The number, in any case.
+    \return false if the type is unknown.
+*/
+bool vartype_affecter(void* adresse, csc_var_type type, int64_t entier, uint64_t naturel, double flottant){
+    switch (VARTYPE_BASE(type)) {
+        case VARTYPE_FLOAT:
+            *((float*)adresse) = (float)flottant;
+            break;
+        case VARTYPE_DOUBLE:
+            *((double*)adresse) = flottant;
+            break;
+        case VARTYPE_U8:
+            *((uint8_t*)adresse) = (uint8_t)naturel;
+            break;
+        case VARTYPE_U32:
+            *((uint32_t*)adresse) = (uint32_t)naturel;
+            break;
+        case VARTYPE_U64:
+            *((uint64_t*)adresse) = naturel;
+            break;
+        case VARTYPE_I32:
+            *((int32_t*)adresse) = (int32_t)entier;
+            break;
+        case VARTYPE_I64:
+            *((int64_t*)adresse) = entier;
+            break;
+        case VARTYPE_I8:
+            *((int8_t*)adresse) = (int8_t)entier;
+            break;
+        case VARTYPE_U16:
+            *((uint16_t*)adresse) = (uint16_t)naturel;
+            break;
+        case VARTYPE_I16:
+            *((int16_t*)adresse) = (int16_t)entier;
+            break;
+        case VARTYPE_FP16:
+            *((uint16_t*)adresse) = float_vers_demi((float)flottant);
+            break;
+        case VARTYPE_BF16:
+            *((uint16_t*)adresse) = float_vers_bf16((float)flottant);
+            break;
+        default:
+            return false;
+    }
+    
+    return true;
+}
+
+
+/*!
+    \brief Reads one element of a packed array.
+    
+    \param p The element.
+    \param type The type of the element.
+    \param inverser Whether its bytes are in the reverse order of the host's.
+    \param entier Where its value is written if it's an integer.
+    \param naturel Where its value is written if it's an integer (modulo 2^64).
+    \param flottant Where its value is written, in any case.
+*/
+static void lire_element(const uint8_t* p, csc_var_type type, bool inverser, int64_t* entier, uint64_t* naturel, double* flottant){
+    size_t taille = vartype_taille(type);
+    uint8_t octets[8];
+    size_t i;
+    
+    if(inverser){
+        for(i = 0; i < taille; i++)
+            octets[i] = p[taille - 1 - i];
+    } else {
+        memcpy(octets, p, taille);
+    }
+    
+    switch (VARTYPE_BASE(type)) {
+        case VARTYPE_U8:    { uint8_t v;  memcpy(&v, octets, sizeof(v)); *naturel = v; *entier = v; *flottant = v; break; }
+        case VARTYPE_U32:   { uint32_t v; memcpy(&v, octets, sizeof(v)); *naturel = v; *entier = v; *flottant = v; break; }
+        case VARTYPE_U64:   { uint64_t v; memcpy(&v, octets, sizeof(v)); *naturel = v; *entier = (int64_t)v; *flottant = (double)v; break; }
+        case VARTYPE_I32:   { int32_t v;  memcpy(&v, octets, sizeof(v)); *entier = v; *naturel = (uint64_t)(int64_t)v; *flottant = v; break; }
+        case VARTYPE_I64:   { int64_t v;  memcpy(&v, octets, sizeof(v)); *entier = v; *naturel = (uint64_t)v; *flottant = (double)v; break; }
+        case VARTYPE_FLOAT: { float v;    memcpy(&v, octets, sizeof(v)); *flottant = v; flottant_vers_entiers(v, entier, naturel); break; }
+        case VARTYPE_DOUBLE:{ double v;   memcpy(&v, octets, sizeof(v)); *flottant = v; flottant_vers_entiers(v, entier, naturel); break; }
+        case VARTYPE_I8:    { int8_t v;   memcpy(&v, octets, sizeof(v)); *entier = v; *naturel = (uint64_t)(int64_t)v; *flottant = v; break; }
+        case VARTYPE_U16:   { uint16_t v; memcpy(&v, octets, sizeof(v)); *naturel = v; *entier = v; *flottant = v; break; }
+        case VARTYPE_I16:   { int16_t v;  memcpy(&v, octets, sizeof(v)); *entier = v; *naturel = (uint64_t)(int64_t)v; *flottant = v; break; }
+        case VARTYPE_FP16:  { uint16_t v; memcpy(&v, octets, sizeof(v)); *flottant = demi_vers_float(v); flottant_vers_entiers(*flottant, entier, naturel); break; }
+        case VARTYPE_BF16:  { uint16_t v; memcpy(&v, octets, sizeof(v)); *flottant = bf16_vers_float(v); flottant_vers_entiers(*flottant, entier, naturel); break; }
+        default:
+            *flottant = 0.0; *entier = 0; *naturel = 0;
+    }
+}
+
+
+/*!
+    \brief Converts packed floats, in the host's byte order, into doubles.
+    
+    \param dst The doubles.
+    \param src The floats; they need not be aligned.
+    \param nombre The number of elements.
+*/
+static void float_vers_double(double* dst, const uint8_t* src, size_t nombre){
+    size_t i = 0;
+    float element;
+    
+#ifdef __SSE2__
+    for(; i + 4 <= nombre; i += 4){
+        __m128 bloc = _mm_loadu_ps((const float*)(src + i*sizeof(float)));
+        _mm_storeu_pd(dst + i, _mm_cvtps_pd(bloc));
+        _mm_storeu_pd(dst + i + 2, _mm_cvtps_pd(_mm_movehl_ps(bloc, bloc)));
+    }
+#endif
+    
+    for(; i < nombre; i++){
+        memcpy(&element, src + i*sizeof(float), sizeof(float));
+        dst[i] = element;
+    }
+}
+
+
+/*!
+    \brief Converts packed doubles, in the host's byte order, into floats.
+    
+    \param dst The floats.
+    \param src The doubles; they need not be aligned.
+    \param nombre The number of elements.
+*/
+static void double_vers_float(float* dst, const uint8_t* src, size_t nombre){
+    size_t i = 0;
+    double element;
+    
+#ifdef __SSE2__
+    for(; i + 4 <= nombre; i += 4){
+        __m128 bas = _mm_cvtpd_ps(_mm_loadu_pd((const double*)(src + i*sizeof(double))));
+        __m128 haut = _mm_cvtpd_ps(_mm_loadu_pd((const double*)(src + (i + 2)*sizeof(double))));
+        _mm_storeu_ps(dst + i, _mm_movelh_ps(bas, haut));
+    }
+#endif
+    
+    for(; i < nombre; i++){
+        memcpy(&element, src + i*sizeof(double), sizeof(double));
+        dst[i] = (float)element;
+    }
+}
+
+
+/*!
+    \brief Converts packed 32-bit integers, in the host's byte order, into floats.
+    
+    \param dst The floats.
+    \param src The integers; they need not be aligned.
+    \param nombre The number of elements.
+*/
+static void i32_vers_float(float* dst, const uint8_t* src, size_t nombre){
+    size_t i = 0;
+    int32_t element;
+    
+#ifdef __SSE2__
+    for(; i + 4 <= nombre; i += 4)
+        _mm_storeu_ps(dst + i, _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(src + i*sizeof(int32_t)))));
+#endif
+    
+    for(; i < nombre; i++){
+        memcpy(&element, src + i*sizeof(int32_t), sizeof(int32_t));
+        dst[i] = (float)element;
+    }
+}
+
+
+/*!
+    \brief Converts packed 32-bit integers, in the host's byte order, into doubles.
+    
+    \param dst The doubles.
+    \param src The integers; they need not be aligned.
+    \param nombre The number of elements.
+*/
+static void i32_vers_double(double* dst, const uint8_t* src, size_t nombre){
+    size_t i = 0;
+    int32_t element;
+    
+#ifdef __SSE2__
+    for(; i + 4 <= nombre; i += 4){
+        __m128i bloc = _mm_loadu_si128((const __m128i*)(src + i*sizeof(int32_t)));
+        _mm_storeu_pd(dst + i, _mm_cvtepi32_pd(bloc));
+        _mm_storeu_pd(dst + i + 2, _mm_cvtepi32_pd(_mm_shuffle_epi32(bloc, _MM_SHUFFLE(1, 0, 3, 2))));
+    }
+#endif
+    
+    for(; i < nombre; i++){
+        memcpy(&element, src + i*sizeof(int32_t), sizeof(int32_t));
+        dst[i] = element;
+    }
+}
+
+
+/*!
+    \brief Converts packed half floats, in the host's byte order, into floats.
+    
+    \param dst The floats.
+    \param src The half floats; they need not be aligned.
+    \param nombre The number of elements.
+*/
+static void demi_vers_float_n(float* dst, const uint8_t* src, size_t nombre){
+    size_t i = 0;
+    uint16_t element;
+    
+#ifdef __F16C__
+    for(; i + 8 <= nombre; i += 8)
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(src + i*sizeof(uint16_t)))));
+#endif
+    
+    for(; i < nombre; i++){
+        memcpy(&element, src + i*sizeof(uint16_t), sizeof(uint16_t));
+        dst[i] = demi_vers_float(element);
+    }
+}
+
+
+/*!
+    \brief Converts packed floats, in the host's byte order, into half floats.
+    
+    \param dst The half floats.
+    \param src The floats; they need not be aligned.
+    \param nombre The number of elements.
+*/
+static void float_vers_demi_n(uint16_t* dst, const uint8_t* src, size_t nombre){
+    size_t i = 0;
+    float element;
+    
+#ifdef __F16C__
+    for(; i + 8 <= nombre; i += 8)
+        _mm_storeu_si128((__m128i*)(dst + i), _mm256_cvtps_ph(_mm256_loadu_ps((const float*)(src + i*sizeof(float))), _MM_FROUND_TO_NEAREST_INT));
+#endif
+    
+    for(; i < nombre; i++){
+        memcpy(&element, src + i*sizeof(float), sizeof(float));
+        dst[i] = float_vers_demi(element);
+    }
+}
+
+
+/*!
+    \brief Converts packed bfloat16s, in the host's byte order, into floats.
+    
+    \param dst The floats.
+    \param src The bfloat16s; they need not be aligned.
+    \param nombre The number of elements.
+*/
+static void bf16_vers_float_n(float* dst, const uint8_t* src, size_t nombre){
+    size_t i = 0;
+    uint16_t element;
+    
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    
+    // Interleaving zeros below the 16 bits of each element shifts them to the top of a float
+    for(; i + 8 <= nombre; i += 8){
+        __m128i bloc = _mm_loadu_si128((const __m128i*)(src + i*sizeof(uint16_t)));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_unpacklo_epi16(zero, bloc));
+        _mm_storeu_si128((__m128i*)(dst + i + 4), _mm_unpackhi_epi16(zero, bloc));
+    }
+#endif
+    
+    for(; i < nombre; i++){
+        memcpy(&element, src + i*sizeof(uint16_t), sizeof(uint16_t));
+        dst[i] = bf16_vers_float(element);
+    }
+}
+
+
+#ifdef __SSE2__
+/*!
+    \brief Rounds 4 floats to bfloat16s, the way float_vers_bf16() does.
+    
+    \param bits The bits of the floats.
+    \return The bits of the bfloat16s, in the low halves of the 32-bit lanes, sign-extended.
+*/
+static __m128i bf16_arrondir(__m128i bits){
+    const __m128i infini = _mm_set1_epi32(0x7f800000);
+    __m128i absolu = _mm_and_si128(bits, _mm_set1_epi32(0x7fffffff));
+    __m128i nan = _mm_cmpgt_epi32(absolu, infini);
+    __m128i parite = _mm_and_si128(_mm_srli_epi32(bits, 16), _mm_set1_epi32(1));
+    __m128i arrondi = _mm_srli_epi32(_mm_add_epi32(bits, _mm_add_epi32(_mm_set1_epi32(0x7fff), parite)), 16);
+    __m128i calme = _mm_or_si128(_mm_srli_epi32(bits, 16), _mm_set1_epi32(0x40));
+    __m128i resultat = _mm_or_si128(_mm_and_si128(nan, calme), _mm_andnot_si128(nan, arrondi));
+    
+    // Sign-extended, so that _mm_packs_epi32 keeps the 16 bits as they are
+    return _mm_srai_epi32(_mm_slli_epi32(resultat, 16), 16);
+}
+#endif
+
+
+/*!
+    \brief Converts packed floats, in the host's byte order, into bfloat16s.
+    
+    \param dst The bfloat16s.
+    \param src The floats; they need not be aligned.
+    \param nombre The number of elements.
+*/
+static void float_vers_bf16_n(uint16_t* dst, const uint8_t* src, size_t nombre){
+    size_t i = 0;
+    float element;
+    
+#ifdef __SSE2__
+    for(; i + 8 <= nombre; i += 8){
+        __m128i bas = bf16_arrondir(_mm_loadu_si128((const __m128i*)(src + i*sizeof(float))));
+        __m128i haut = bf16_arrondir(_mm_loadu_si128((const __m128i*)(src + (i + 4)*sizeof(float))));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(bas, haut));
+    }
+#endif
+    
+    for(; i < nombre; i++){
+        memcpy(&element, src + i*sizeof(float), sizeof(float));
+        dst[i] = float_vers_bf16(element);
+    }
+}
+
+
+/*!
+    \brief Converts a packed array, as it was received, into the elements of an array variable.
+    
+    \param dst The elements of the variable.
+    \param type The type of the variable; for an array, the type of its elements.
+    \param src The packed elements; they need not be aligned.
+    \param type_src The type of the packed elements.
+    \param petit_boutiste Whether the packed elements are stored least significant byte first.
+    \param nombre The number of elements.
+    \return false if one of the types is unknown.
+*/
+bool tableau_convertir(void* dst, csc_var_type type, const uint8_t* src, csc_var_type type_src, bool petit_boutiste, size_t nombre){
+    bool inverser = petit_boutiste != hote_petit_boutiste();
+    size_t taille_src = vartype_taille(type_src);
+    int64_t entier;
+    uint64_t naturel;
+    double flottant;
+    size_t i;
+    
+    if(!taille_src || !vartype_taille(type))
+        return false;
+    
+    // The usual case: the array comes in the type it's bound with
+    if(VARTYPE_BASE(type) == VARTYPE_BASE(type_src) && (!inverser || taille_src == 1)){
+        memcpy(dst, src, nombre*taille_src);
+        return true;
+    }
+    
+    if(!inverser){
+        if(VARTYPE_BASE(type) == VARTYPE_DOUBLE && VARTYPE_BASE(type_src) == VARTYPE_FLOAT){
+            float_vers_double(dst, src, nombre);
+            return true;
+        }
+        if(VARTYPE_BASE(type) == VARTYPE_FLOAT && VARTYPE_BASE(type_src) == VARTYPE_DOUBLE){
+            double_vers_float(dst, src, nombre);
+            return true;
+        }
+        if(VARTYPE_BASE(type) == VARTYPE_FLOAT && VARTYPE_BASE(type_src) == VARTYPE_I32){
+            i32_vers_float(dst, src, nombre);
+            return true;
+        }
+        if(VARTYPE_BASE(type) == VARTYPE_DOUBLE && VARTYPE_BASE(type_src) == VARTYPE_I32){
+            i32_vers_double(dst, src, nombre);
+            return true;
+        }
+        if(VARTYPE_BASE(type) == VARTYPE_FLOAT && VARTYPE_BASE(type_src) == VARTYPE_FP16){
+            demi_vers_float_n(dst, src, nombre);
+            return true;
+        }
+        if(VARTYPE_BASE(type) == VARTYPE_FP16 && VARTYPE_BASE(type_src) == VARTYPE_FLOAT){
+            float_vers_demi_n(dst, src, nombre);
+            return true;
+        }
+        if(VARTYPE_BASE(type) == VARTYPE_FLOAT && VARTYPE_BASE(type_src) == VARTYPE_BF16){
+            bf16_vers_float_n(dst, src, nombre);
+            return true;
+        }
+        if(VARTYPE_BASE(type) == VARTYPE_BF16 && VARTYPE_BASE(type_src) == VARTYPE_FLOAT){
+            float_vers_bf16_n(dst, src, nombre);
+            return true;
+        }
+    }
+    
+    // Anything else, one element at a time
+    for(i = 0; i < nombre; i++){
+        lire_element(src + i*taille_src, type_src, inverser, &entier, &naturel, &flottant);
+        vartype_affecter((uint8_t*)dst + i*vartype_taille(type), type, entier, naturel, flottant);
+    }
+    
+    return true;
+}
+
+
+/*!
+    \brief Packs the elements of an array variable, least significant byte first, in the type given by vartype_paquet().
+    
+    \param dst Where the elements are packed; it need not be aligned.
+    \param src The elements of the variable.
+    \param type The type of the variable; for an array, the type of its elements.
+    \param nombre The number of elements.
+    \return false if the type is unknown.
+*/
+bool tableau_petit_boutiste(uint8_t* dst, const void* src, csc_var_type type, size_t nombre){
+    size_t taille = vartype_taille(type);
+    const uint8_t* octets = src;
+    const uint16_t* bf16 = src;
+    size_t i, j;
+    
+    if(!taille)
+        return false;
+    
+    // The bfloat16s are the upper halves of floats
+    if(VARTYPE_BASE(type) == VARTYPE_BF16){
+        for(i = 0; i < nombre; i++){
+            dst[4*i] = 0;
+            dst[4*i + 1] = 0;
+            dst[4*i + 2] = (uint8_t)bf16[i];
+            dst[4*i + 3] = (uint8_t)(bf16[i] >> 8);
+        }
+        return true;
+    }
+    
+    if(hote_petit_boutiste() || taille == 1){
+        memcpy(dst, src, nombre*taille);
+        return true;
+    }
+    
+    for(i = 0; i < nombre; i++)
+        for(j = 0; j < taille; j++)
+            dst[i*taille + j] = octets[i*taille + taille - 1 - j];
+    
+    return true;
+}
@@ -0,0 +1,26 @@
+//
+//  tableaux.h
+//  cruesli
+//
+
+#ifndef tableaux_h
+#define tableaux_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "varstructs.h"
+
+float demi_vers_float(uint16_t demi);
+uint16_t float_vers_demi(float valeur);
+float bf16_vers_float(uint16_t bf16);
+uint16_t float_vers_bf16(float valeur);
+void flottant_vers_entiers(double flottant, int64_t* entier, uint64_t* naturel);
+size_t vartype_taille(csc_var_type type);
+csc_var_type vartype_paquet(csc_var_type type);
+bool vartype_affecter(void* adresse, csc_var_type type, int64_t entier, uint64_t naturel, double flottant);
+bool tableau_convertir(void* dst, csc_var_type type, const uint8_t* src, csc_var_type type_src, bool petit_boutiste, size_t nombre);
+bool tableau_petit_boutiste(uint8_t* dst, const void* src, csc_var_type type, size_t nombre);
+
+#endif /* tableaux_h */
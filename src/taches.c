@@ -0,0 +1,418 @@
+//
+//  taches.c
+//  cruesli
+//
+
+/*!
+    Local queue of the tasks that were allocated to a node by the master server, but not yet handed over to it.
+    
+    The node takes its tasks from the head of its queue; a node that ran out of tasks may take the
+    second half of the queue of another one (see file_ceder()).
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include <pthread.h>
+
+#include <curl/curl.h>
+#include <cjson/cJSON.h>
+
+#include "safe_malloc.h"
+#include "entities.h"
+#include "www.h"
+#include "moteur.h"
+#include "taches.h"
+
+// Guards the count of the tasks each node lent to the others
+static pthread_mutex_t g_prets_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Weight of a new sample in the running means
+#define FILE_POIDS_ECHANTILLON 0.2
+
+
+/*!
+    \brief Creates a new, empty, task queue.
+    
+    \return A pointer to the new queue.
+*/
+csc_file_taches* nouvelle_file(void){
+    csc_file_taches* file = safe_malloc(sizeof(csc_file_taches));
+    
+    pthread_mutex_init(&file->verrou, NULL);
+    file->tete = NULL;
+    file->queue = NULL;
+    file->longueur = 0;
+    file->reservations = 0;
+    
+    transfert_initialiser(&file->recharge, NULL);
+    transfert_initialiser(&file->envoi, NULL);
+    file->nb_reserve = 0;
+    
+    file->lot = 1;
+    file->rtt = 0.0;
+    file->duree_tache = 0.0;
+    file->fin_allocation = 0.0;
+    
+    return file;
+}
+
+
+/*!
+    \brief Destroys the queue and the tasks it still holds.
+    
+    \param file The queue.
+    
+    \note A refill still in flight is waited for, and its result is discarded.
+*/
+void detruire_file(csc_file_taches* file){
+    if(!file)
+        return;
+    
+    if(file->recharge.requete){
+        moteur_attendre(file->recharge.requete);
+        file->recharge.requete = NULL;
+    }
+    transfert_detruire(&file->recharge);
+    transfert_detruire(&file->envoi);
+    
+    while(file->tete){
+        detruire_tache(file_retirer(file));
+    }
+    
+    while(file->nb_reserve){
+        file->nb_reserve -= 1;
+        curl_easy_cleanup(file->reserve[file->nb_reserve].handler);
+        transfert_detruire(&file->reserve[file->nb_reserve]);
+    }
+    
+    curl_easy_cleanup(file->recharge.handler);
+    pthread_mutex_destroy(&file->verrou);
+    free(file);
+}
+
+
+/*!
+    \brief Creates an empty task.
+    
+    \return A pointer to the new task.
+*/
+csc_tache* nouvelle_tache(void){
+    csc_tache* tache = safe_malloc(sizeof(csc_tache));
+    
+    tache->payload = NULL;
+    tache->taille_payload = 0;
+    tache->format = CSC_FORMAT_JSON;
+    tache->id = NULL;
+    tache->origine = NULL;
+    tache->suivante = NULL;
+    tache->statut = 0;
+    tache->recue = false;
+    transfert_initialiser(&tache->soumission, NULL);
+    
+    return tache;
+}
+
+
+/*!
+    \brief Frees a task.
+    
+    \param tache The task; its submission must not be in flight anymore.
+*/
+void detruire_tache(csc_tache* tache){
+    if(!tache)
+        return;
+    
+    // Submitted, or dropped: the node that fetched it doesn't wait for it anymore
+    if(tache->origine){
+        pthread_mutex_lock(&g_prets_lock);
+        tache->origine->taches_pretees -= 1;
+        pthread_mutex_unlock(&g_prets_lock);
+    }
+    
+    free(tache->payload);
+    cJSON_Delete(tache->id);
+    transfert_detruire(&tache->soumission);
+    free(tache);
+}
+
+
+/*!
+    \brief Notes that a task fetched by a node is handed over to another one, which submits it under the
+           id of the first one.
+    
+    \note A task that was already lent stays lent by the node that fetched it.
+    
+    \param tache The task.
+    \param origine The node that fetched it.
+*/
+void tache_preter(csc_tache* tache, struct csc_node_info* origine){
+    if(tache->origine)
+        return;
+    
+    tache->origine = origine;
+    pthread_mutex_lock(&g_prets_lock);
+    origine->taches_pretees += 1;
+    pthread_mutex_unlock(&g_prets_lock);
+}
+
+
+/*!
+    \brief Tells how many of the tasks fetched by a node other nodes hold: they are not submitted yet.
+    
+    \param noeud The node.
+    \return The number of tasks.
+*/
+size_t taches_pretees(const struct csc_node_info* noeud){
+    size_t nombre;
+    
+    pthread_mutex_lock(&g_prets_lock);
+    nombre = noeud->taches_pretees;
+    pthread_mutex_unlock(&g_prets_lock);
+    
+    return nombre;
+}
+
+
+/*!
+    \brief Appends a task at the end of the queue.
+    
+    \param file The queue.
+    \param payload The payload of the task, as sent by the server; it is copied.
+    \param taille The size of the payload.
+    \param format The format of the payload (CSC_FORMAT_...).
+    \param id The id of the task, or NULL; the queue takes ownership of it.
+*/
+void file_pousser(csc_file_taches* file, const void* payload, size_t taille, int format, cJSON* id){
+    csc_tache* tache = nouvelle_tache();
+    tache->payload = safe_malloc(taille + 1);
+    memcpy(tache->payload, payload, taille);
+    tache->payload[taille] = '\0';
+    tache->taille_payload = taille;
+    tache->format = format;
+    tache->id = id;
+    
+    tache->recue = true;
+    
+    pthread_mutex_lock(&file->verrou);
+    if(file->queue)
+        file->queue->suivante = tache;
+    else
+        file->tete = tache;
+    file->queue = tache;
+    file->longueur += 1;
+    pthread_mutex_unlock(&file->verrou);
+}
+
+
+/*!
+    \brief Takes the first task out of the queue.
+    
+    \param file The queue.
+    \return The task (that should be detruire_tache'd by the caller), or NULL if the queue is empty.
+*/
+csc_tache* file_retirer(csc_file_taches* file){
+    csc_tache* tache = NULL;
+    
+    pthread_mutex_lock(&file->verrou);
+    
+    tache = file->tete;
+    if(tache){
+        file->tete = tache->suivante;
+        if(!file->tete)
+            file->queue = NULL;
+        file->longueur -= 1;
+        tache->suivante = NULL;
+    }
+    
+    pthread_mutex_unlock(&file->verrou);
+    
+    return tache;
+}
+
+
+/*!
+    \brief Tells how many tasks the queue holds.
+    
+    \param file The queue.
+    \return The number of tasks; other nodes may take some right after.
+*/
+size_t file_longueur(csc_file_taches* file){
+    size_t longueur;
+    
+    pthread_mutex_lock(&file->verrou);
+    longueur = file->longueur;
+    pthread_mutex_unlock(&file->verrou);
+    
+    return longueur;
+}
+
+
+/*!
+    \brief Takes the second half of the queue, for another node: the tasks its node would get to last.
+    
+    \param file The queue.
+    \param nombre Where the number of tasks taken is written.
+    \return The tasks taken, linked by their suivante, or NULL if the queue is empty.
+*/
+csc_tache* file_ceder(csc_file_taches* file, size_t* nombre){
+    csc_tache* derniere = NULL;
+    csc_tache* cedees = NULL;
+    size_t garder;
+    
+    pthread_mutex_lock(&file->verrou);
+    
+    // Half of the tasks, rounded up: a single task is worth taking from a node busy with another one
+    *nombre = (file->longueur + 1)/2;
+    garder = file->longueur - *nombre;
+    
+    if(!garder){
+        cedees = file->tete;
+        file->tete = NULL;
+        file->queue = NULL;
+    } else {
+        derniere = file->tete;
+        while(--garder)
+            derniere = derniere->suivante;
+        cedees = derniere->suivante;
+        derniere->suivante = NULL;
+        file->queue = derniere;
+    }
+    file->longueur -= *nombre;
+    
+    pthread_mutex_unlock(&file->verrou);
+    
+    return cedees;
+}
+
+
+/*!
+    \brief Appends tasks taken from another queue at the end of the queue.
+    
+    \param file The queue.
+    \param taches The tasks, linked by their suivante; the queue takes ownership of them.
+    \param nombre The number of tasks.
+*/
+void file_accueillir(csc_file_taches* file, csc_tache* taches, size_t nombre){
+    csc_tache* derniere = taches;
+    
+    if(!taches)
+        return;
+    
+    while(derniere->suivante)
+        derniere = derniere->suivante;
+    
+    pthread_mutex_lock(&file->verrou);
+    if(file->queue)
+        file->queue->suivante = taches;
+    else
+        file->tete = taches;
+    file->queue = derniere;
+    file->longueur += nombre;
+    pthread_mutex_unlock(&file->verrou);
+}
+
+
+/*!
+    \brief Takes an idle curl handle, and its buffers, from the node's reserve.
+    
+    \param file The queue.
+    \param transfert The idle transfer that gets them; its own buffers must be empty.
+    \return false if the reserve is empty.
+*/
+bool file_prendre_transfert(csc_file_taches* file, www_transfert* transfert){
+    if(!file->nb_reserve)
+        return false;
+    
+    file->nb_reserve -= 1;
+    transfert->handler = file->reserve[file->nb_reserve].handler;
+    transfert->ecriture = file->reserve[file->nb_reserve].ecriture;
+    transfert->sortie = file->reserve[file->nb_reserve].sortie;
+    transfert_initialiser(&file->reserve[file->nb_reserve], NULL);
+    
+    return true;
+}
+
+
+/*!
+    \brief Gives back the curl handle of a transfer, and its buffers, to the node's reserve,
+            keeping its connection alive.
+    
+    \param file The queue.
+    \param transfert The transfer, which is left without a handler nor buffers;
+                       they are freed if the reserve is full.
+*/
+void file_rendre_transfert(csc_file_taches* file, www_transfert* transfert){
+    transfert_liberer(transfert);
+    
+    if(file->nb_reserve < FILE_TAILLE_RESERVE){
+        transfert_initialiser(&file->reserve[file->nb_reserve], transfert->handler);
+        file->reserve[file->nb_reserve].ecriture = transfert->ecriture;
+        file->reserve[file->nb_reserve].sortie = transfert->sortie;
+        file->nb_reserve += 1;
+    } else {
+        curl_easy_cleanup(transfert->handler);
+        ecriture_liberer(&transfert->ecriture);
+        ecriture_liberer(&transfert->sortie);
+    }
+    
+    transfert_initialiser(transfert, NULL);
+}
+
+
+/*!
+    \brief Takes into account the duration of a refill request.
+    
+    \param file The queue.
+    \param rtt The duration of the request, in seconds.
+*/
+void file_noter_rtt(csc_file_taches* file, double rtt){
+    if(file->rtt <= 0.0)
+        file->rtt = rtt;
+    else
+        file->rtt += FILE_POIDS_ECHANTILLON*(rtt - file->rtt);
+}
+
+
+/*!
+    \brief Takes into account that the node asks for a new task, which means it's done with the previous one.
+    
+    \param file The queue.
+    \param instant The current time, in seconds.
+*/
+void file_noter_allocation(csc_file_taches* file, double instant){
+    double duree;
+    
+    if(file->fin_allocation <= 0.0)
+        return;
+    
+    duree = instant - file->fin_allocation;
+    if(file->duree_tache <= 0.0)
+        file->duree_tache = duree;
+    else
+        file->duree_tache += FILE_POIDS_ECHANTILLON*(duree - file->duree_tache);
+}
+
+
+/*!
+    \brief Computes the size of the next batch so that a refill lasts about as long as the tasks it brings.
+    
+    \param file The queue.
+    \param lot_min The smallest batch size allowed.
+    \param lot_max The largest batch size allowed.
+*/
+void file_ajuster_lot(csc_file_taches* file, size_t lot_min, size_t lot_max){
+    double lot = lot_min;
+    
+    // Enough tasks to keep the node busy during two round trips
+    if(file->duree_tache > 0.0)
+        lot = 2.0*file->rtt/file->duree_tache + 1.0;
+    
+    if(lot < lot_min)
+        lot = lot_min;
+    if(lot > lot_max)
+        lot = lot_max;
+    
+    file->lot = (size_t)lot;
+}
@@ -0,0 +1,78 @@
+//
+//  taches.h
+//  cruesli
+//
+
+#ifndef taches_h
+#define taches_h
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include <pthread.h>
+
+#include <curl/curl.h>
+#include <cjson/cJSON.h>
+
+#include "www.h"
+#include "moteur.h"
+
+// Number of idle curl handles (and their buffers) kept by each node for its task handles
+#define FILE_TAILLE_RESERVE 4
+
+typedef struct csc_tache {
+    char* payload;                  // The task-payload sent by the master server, as is (NUL-terminated)
+    size_t taille_payload;
+    int format;                     // CSC_FORMAT_... of the payload
+    cJSON* id;                      // The task-id sent by the master server, if any
+    struct csc_node_info* origine;  // The node that fetched the task, if another one took it: the result is submitted under its id
+    struct csc_tache* suivante;
+    
+    // When used as a task handle
+    int statut;                     // Status of the fetch, and then of the submission
+    bool recue;                     // The payload was received
+    www_transfert soumission;       // The submission, while in flight
+} csc_tache;
+
+typedef struct csc_file_taches {
+    pthread_mutex_t verrou;         // Protects tete, queue and longueur: idle nodes may take tasks from the queue
+    csc_tache* tete;
+    csc_tache* queue;
+    size_t longueur;
+    size_t reservations;            // Task handles waiting for a task from this queue
+    
+    // The refill request, that may be in flight in the background
+    www_transfert recharge;
+    
+    // The node's own submissions, on the node's handler
+    www_transfert envoi;
+    
+    // Idle transfers, for the submissions of task handles
+    www_transfert reserve[FILE_TAILLE_RESERVE];
+    size_t nb_reserve;
+    
+    // Adaptive batch size
+    size_t lot;                     // Number of tasks asked for by the next refill
+    double rtt;                     // Mean duration of a refill request, in seconds
+    double duree_tache;             // Mean time between two allocations, in seconds
+    double fin_allocation;          // When the last task was handed over to the node
+} csc_file_taches;
+
+csc_file_taches* nouvelle_file(void);
+void detruire_file(csc_file_taches* file);
+csc_tache* nouvelle_tache(void);
+void detruire_tache(csc_tache* tache);
+void tache_preter(csc_tache* tache, struct csc_node_info* origine);
+size_t taches_pretees(const struct csc_node_info* noeud);
+void file_pousser(csc_file_taches* file, const void* payload, size_t taille, int format, cJSON* id);
+csc_tache* file_retirer(csc_file_taches* file);
+size_t file_longueur(csc_file_taches* file);
+csc_tache* file_ceder(csc_file_taches* file, size_t* nombre);
+void file_accueillir(csc_file_taches* file, csc_tache* taches, size_t nombre);
+bool file_prendre_transfert(csc_file_taches* file, www_transfert* transfert);
+void file_rendre_transfert(csc_file_taches* file, www_transfert* transfert);
+void file_noter_rtt(csc_file_taches* file, double rtt);
+void file_noter_allocation(csc_file_taches* file, double instant);
+void file_ajuster_lot(csc_file_taches* file, size_t lot_min, size_t lot_max);
+
+#endif /* taches_h */
@@ -0,0 +1,347 @@
+//
+//  topologie.c
+//  cruesli
+//
+
+/*!
+    Where the nodes run: the CPUs the process may use, their cores, sockets and NUMA nodes, read from
+    sysfs (Linux), and the CPU each node is pinned to.
+    
+    The compact placement fills a NUMA node before moving on to the next one, which keeps the nodes
+    close to each other and to the memory of the process; the scattered one spreads them over the
+    NUMA nodes in turn, which gives each its share of memory bandwidth. Either way, the nodes get a
+    physical core of their own before two of them share one, unless SMT siblings should be filled first.
+*/
+
+// For sched_getaffinity() and pthread_setaffinity_np()
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <pthread.h>
+#ifdef __linux__
+#include <sched.h>
+#include <dirent.h>
+#endif
+
+#include "safe_malloc.h"
+#include "cscerrs.h"
+#include "entities.h"
+#include "topologie.h"
+
+#define TOPOLOGIE_RACINE "/sys/devices/system/cpu"
+
+// A CPU, and what it is ordered by
+typedef struct csc_cpu_ordonne {
+    csc_cpu cpu;
+    int cles[4];
+} csc_cpu_ordonne;
+
+
+/*!
+    \brief Compares two CPUs by their keys, in order, for qsort().
+*/
+static int comparer_cpus(const void* a, const void* b){
+    const csc_cpu_ordonne* x = a;
+    const csc_cpu_ordonne* y = b;
+    size_t i;
+    
+    for(i = 0; i < 4; i++){
+        if(x->cles[i] != y->cles[i])
+            return x->cles[i] < y->cles[i] ? -1 : 1;
+    }
+    return x->cpu.id - y->cpu.id;
+}
+
+
+#ifdef __linux__
+/*!
+    \brief Reads a number from a file of sysfs.
+    
+    \param format The path of the file, with the number of the CPU in it.
+    \param cpu The number of the CPU.
+    \param defaut What is returned if the file can't be read.
+    \return The number.
+*/
+static int lire_entier(const char* format, int cpu, int defaut){
+    char chemin[128];
+    FILE* fichier = NULL;
+    int valeur;
+    
+    snprintf(chemin, sizeof(chemin), format, cpu);
+    fichier = fopen(chemin, "r");
+    if(!fichier)
+        return defaut;
+    
+    if(fscanf(fichier, "%d", &valeur) != 1 || valeur < 0)
+        valeur = defaut;
+    
+    fclose(fichier);
+    return valeur;
+}
+
+
+/*!
+    \brief Finds the NUMA node of a CPU: its directory in sysfs links to it as nodeN.
+    
+    \param cpu The number of the CPU.
+    \return The NUMA node; 0 if the system has none.
+*/
+static int lire_numa(int cpu){
+    char chemin[128];
+    DIR* dossier = NULL;
+    struct dirent* entree = NULL;
+    int numa = 0;
+    
+    snprintf(chemin, sizeof(chemin), TOPOLOGIE_RACINE "/cpu%d", cpu);
+    dossier = opendir(chemin);
+    if(!dossier)
+        return 0;
+    
+    while((entree = readdir(dossier))){
+        if(!strncmp(entree->d_name, "node", 4) && sscanf(entree->d_name + 4, "%d", &numa) == 1)
+            break;
+        numa = 0;
+    }
+    
+    closedir(dossier);
+    return numa;
+}
+#endif
+
+
+/*!
+    \brief Lists the CPUs the process may run on, and where they sit.
+    
+    \param cpus Where the list is written, to be freed by the caller; NULL if there's none.
+    \return The number of CPUs; 0 if the topology is unknown (not on Linux).
+*/
+size_t lire_topologie(csc_cpu** cpus){
+    size_t nombre = 0;
+    
+    *cpus = NULL;
+    
+#ifdef __linux__
+    cpu_set_t ensemble;
+    size_t i, j;
+    int id;
+    
+    if(sched_getaffinity(0, sizeof(ensemble), &ensemble) || !CPU_COUNT(&ensemble))
+        return 0;
+    
+    *cpus = safe_malloc(CPU_COUNT(&ensemble)*sizeof(csc_cpu));
+    
+    for(id = 0; id < CPU_SETSIZE; id++){
+        if(!CPU_ISSET(id, &ensemble))
+            continue;
+    
+        (*cpus)[nombre].id = id;
+        // Without these files, each CPU is a core of its own
+        (*cpus)[nombre].coeur = lire_entier(TOPOLOGIE_RACINE "/cpu%d/topology/core_id", id, id);
+        (*cpus)[nombre].socket = lire_entier(TOPOLOGIE_RACINE "/cpu%d/topology/physical_package_id", id, 0);
+        (*cpus)[nombre].numa = lire_numa(id);
+        (*cpus)[nombre].rang = 0;
+        nombre++;
+    }
+    
+    // The hardware threads of a core are ranked by their numbers
+    for(i = 0; i < nombre; i++){
+        for(j = 0; j < i; j++){
+            if((*cpus)[j].socket == (*cpus)[i].socket && (*cpus)[j].coeur == (*cpus)[i].coeur)
+                (*cpus)[i].rang += 1;
+        }
+    }
+#endif
+    
+    return nombre;
+}
+
+
+/*!
+    \brief Lists the CPUs the process may run on, in the order a placement takes them.
+    
+    \param politique CSC_PLACEMENT_COMPACT or CSC_PLACEMENT_DISPERSE.
+    \param smt Whether the hardware threads of a core are filled before moving on to the next core.
+    \param ordre Where the list is written, to be freed by the caller; NULL if there's none.
+    \return The number of CPUs; 0 if the topology is unknown or the nodes shouldn't be pinned.
+*/
+static size_t ordonner_cpus(int politique, bool smt, csc_cpu_ordonne** ordre){
+    csc_cpu* cpus = NULL;
+    size_t nombre, i;
+    int numa, position = 0;
+    
+    *ordre = NULL;
+    
+    nombre = politique == CSC_PLACEMENT_AUCUN ? 0 : lire_topologie(&cpus);
+    if(!nombre){
+        free(cpus);
+        return 0;
+    }
+    
+    *ordre = safe_malloc(nombre*sizeof(csc_cpu_ordonne));
+    for(i = 0; i < nombre; i++){
+        (*ordre)[i].cpu = cpus[i];
+        // Within a NUMA node: the first threads of the cores, then their siblings; or core by core
+        (*ordre)[i].cles[0] = cpus[i].numa;
+        (*ordre)[i].cles[1] = smt ? 0 : cpus[i].rang;
+        (*ordre)[i].cles[2] = cpus[i].socket;
+        (*ordre)[i].cles[3] = cpus[i].coeur;
+    }
+    free(cpus);
+    
+    if(politique == CSC_PLACEMENT_COMPACT){
+        // Without SMT, the siblings of every NUMA node come after all the cores
+        if(!smt){
+            for(i = 0; i < nombre; i++){
+                (*ordre)[i].cles[1] = (*ordre)[i].cles[0];
+                (*ordre)[i].cles[0] = (*ordre)[i].cpu.rang;
+            }
+        }
+        qsort(*ordre, nombre, sizeof(csc_cpu_ordonne), comparer_cpus);
+    } else {
+        // The CPUs of each NUMA node are numbered in order, then taken one per NUMA node in turn
+        qsort(*ordre, nombre, sizeof(csc_cpu_ordonne), comparer_cpus);
+        for(i = 0, numa = -1; i < nombre; i++){
+            position = (*ordre)[i].cpu.numa == numa ? position + 1 : 0;
+            numa = (*ordre)[i].cpu.numa;
+            (*ordre)[i].cles[0] = position;
+            (*ordre)[i].cles[1] = numa;
+            (*ordre)[i].cles[2] = 0;
+            (*ordre)[i].cles[3] = 0;
+        }
+        qsort(*ordre, nombre, sizeof(csc_cpu_ordonne), comparer_cpus);
+    }
+    
+    return nombre;
+}
+
+
+/*!
+    \brief Chooses the CPU each node runs on.
+    
+    \note The nodes are pinned to their CPU by executer_cascada(), which then allocates their memory
+           from their thread, on their NUMA node. With more nodes than CPUs, the CPUs are used again, in
+           the same order.
+    
+    \param info The master info, with its nodes allocated.
+    \param politique CSC_PLACEMENT_COMPACT, CSC_PLACEMENT_DISPERSE, or CSC_PLACEMENT_AUCUN to let the
+                      nodes run anywhere.
+    \param smt Whether the nodes fill the hardware threads of a core before moving on to the next core;
+                otherwise each gets a physical core of its own first.
+    \return 0 if everything went well or an error code defined in cruesli.h.
+*/
+int placer_noeuds(csc_master_info* info, int politique, bool smt){
+    csc_cpu_ordonne* ordre = NULL;
+    csc_node_info* noeud = NULL;
+    size_t nombre, j;
+    
+    if(!info)
+        return CSC_FATAL_NULL_INFO;
+    
+    nombre = ordonner_cpus(politique, smt, &ordre);
+    for(j = 0, noeud = info->nodes; noeud; j++, noeud = noeud->next){
+        noeud->cpu = nombre ? ordre[j % nombre].cpu.id : -1;
+        noeud->numa = nombre ? ordre[j % nombre].cpu.numa : -1;
+    }
+    
+    free(ordre);
+    return CSC_NO_ERROR;
+}
+
+
+/*!
+    \brief Chooses the CPU of a node added after the others were placed: the first one, in the order of
+            the placement, that the fewest other nodes run on.
+    
+    \param info The master info.
+    \param noeud The node, already in the list of info.
+    \param politique The placement of the other nodes (see placer_noeuds()).
+    \param smt Ditto.
+    \return 0 if everything went well or an error code defined in cruesli.h.
+*/
+int placer_noeud(csc_master_info* info, csc_node_info* noeud, int politique, bool smt){
+    csc_cpu_ordonne* ordre = NULL;
+    csc_node_info* autre = NULL;
+    size_t nombre, i, choix = 0;
+    size_t* occupation = NULL;
+    
+    if(!info || !noeud)
+        return CSC_FATAL_NULL_INFO;
+    
+    noeud->cpu = -1;
+    noeud->numa = -1;
+    
+    nombre = ordonner_cpus(politique, smt, &ordre);
+    if(!nombre)
+        return CSC_NO_ERROR;
+    
+    occupation = safe_malloc(nombre*sizeof(size_t));
+    for(i = 0; i < nombre; i++){
+        occupation[i] = 0;
+        for(autre = info->nodes; autre; autre = autre->next){
+            if(autre != noeud && autre->cpu == ordre[i].cpu.id)
+                occupation[i]++;
+        }
+        if(occupation[i] < occupation[choix])
+            choix = i;
+    }
+    
+    noeud->cpu = ordre[choix].cpu.id;
+    noeud->numa = ordre[choix].cpu.numa;
+    
+    free(occupation);
+    free(ordre);
+    return CSC_NO_ERROR;
+}
+
+
+/*!
+    \brief Prints where each node runs: its CPU, core, socket and NUMA node.
+    
+    \param info The master info.
+*/
+void afficher_placement(const csc_master_info* info){
+    csc_cpu* cpus = NULL;
+    csc_node_info* noeud = NULL;
+    size_t nombre = lire_topologie(&cpus);
+    size_t i;
+    
+    for(noeud = info->nodes; noeud; noeud = noeud->next){
+        if(noeud->cpu < 0){
+            printf("%s: not pinned\n", noeud->id);
+            continue;
+        }
+    
+        for(i = 0; i < nombre && cpus[i].id != noeud->cpu; i++);
+        if(i < nombre)
+            printf("%s: CPU %d (core %d%s, socket %d, NUMA node %d)\n", noeud->id, cpus[i].id, cpus[i].coeur, cpus[i].rang ? ", SMT sibling" : "", cpus[i].socket, cpus[i].numa);
+        else
+            printf("%s: CPU %d\n", noeud->id, noeud->cpu);
+    }
+    
+    free(cpus);
+}
+
+
+/*!
+    \brief Pins the calling thread to a CPU.
+    
+    \param cpu The number of the CPU.
+    \return false if it can't be done.
+*/
+bool epingler_thread(int cpu){
+#ifdef __linux__
+    cpu_set_t ensemble;
+    
+    if(cpu < 0 || cpu >= CPU_SETSIZE)
+        return false;
+    
+    CPU_ZERO(&ensemble);
+    CPU_SET(cpu, &ensemble);
+    return !pthread_setaffinity_np(pthread_self(), sizeof(ensemble), &ensemble);
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,29 @@
+//
+//  topologie.h
+//  cruesli
+//
+
+#ifndef topologie_h
+#define topologie_h
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "entities.h"
+
+// A CPU the process may run on, and where it sits
+typedef struct csc_cpu {
+    int id;         // Its number for the system
+    int coeur;      // Its physical core, within its socket
+    int socket;
+    int numa;       // Its NUMA node; 0 if the system has none
+    int rang;       // 0 for the first hardware thread of its core, 1 for its SMT sibling...
+} csc_cpu;
+
+size_t lire_topologie(csc_cpu** cpus);
+int placer_noeuds(csc_master_info* info, int politique, bool smt);
+int placer_noeud(csc_master_info* info, csc_node_info* noeud, int politique, bool smt);
+void afficher_placement(const csc_master_info* info);
+bool epingler_thread(int cpu);
+
+#endif /* topologie_h */
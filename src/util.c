@@ -8,6 +8,9 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <errno.h>
 
 #include "safe_malloc.h"
 #include "util.h"
@@ -24,3 +27,62 @@ char* strconc(char* str1, char* str2){
     
     return ptr;
 }
+
+
+/*!
+    \brief Reads a monotonic clock.
+    
+    \return The current time, in seconds, from an arbitrary origin.
+*/
+double temps_monotone(void){
+    struct timespec ts;
+    
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    
+    return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+
+/*!
+    \brief Sleeps for a while.
+    
+    \param secondes How long, in seconds.
+*/
+void attendre(double secondes){
+    struct timespec ts;
+    
+    if(secondes <= 0.0)
+        return;
+    
+    ts.tv_sec = (time_t)secondes;
+    ts.tv_nsec = (long)((secondes - ts.tv_sec)*1e9);
+    
+    // Interrupted by a signal: we go back to sleep for what's left
+    while(nanosleep(&ts, &ts) == -1 && errno == EINTR);
+}
+
+
+/*!
+    \brief Draws a pseudo-random number; each thread has its own generator (xorshift64*).
+    
+    \note Not suitable for anything but spreading things out, such as the backoffs of the retries.
+    
+    \return A number in [0, 1).
+*/
+double aleatoire(void){
+    static _Thread_local uint64_t etat = 0;
+    
+    // Seeded from the clock and the thread, so that the threads don't draw the same numbers
+    if(!etat){
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        etat = ((uint64_t)ts.tv_nsec << 32) ^ (uint64_t)ts.tv_sec ^ (uint64_t)(uintptr_t)&etat;
+        etat |= 1;
+    }
+    
+    etat ^= etat >> 12;
+    etat ^= etat << 25;
+    etat ^= etat >> 27;
+    
+    return ((etat*0x2545F4914F6CDD1DULL) >> 11)*(1.0/9007199254740992.0);
+}
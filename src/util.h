@@ -10,6 +10,9 @@
 #define util_h
 
 char* strconc(char* str1, char* str2);
+double temps_monotone(void);
+void attendre(double secondes);
+double aleatoire(void);
 
 
 #endif /* util_h */
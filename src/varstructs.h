@@ -2,6 +2,7 @@
 #define varstructs_h
 
 #include <stdint.h>
+#include <stddef.h>
 
 #define VARTYPE_U8 0     /* uint8_t  */
 #define VARTYPE_U32 1    /* uint32_t */
@@ -10,6 +11,16 @@
 #define VARTYPE_DOUBLE 4 /* double   */
 #define VARTYPE_I32 5    /* int32_t  */
 #define VARTYPE_I64 6    /* int64_t  */
+#define VARTYPE_I8 7     /* int8_t   */
+#define VARTYPE_U16 8    /* uint16_t */
+#define VARTYPE_I16 9    /* int16_t  */
+#define VARTYPE_FP16 10  /* uint16_t, holding an IEEE 754 half float: see demi_vers_float() */
+#define VARTYPE_BF16 11  /* uint16_t, holding a bfloat16: see bf16_vers_float() */
+
+// An array of elements of one of the types above, bound to a C buffer: VARTYPE_TABLEAU | VARTYPE_FLOAT
+#define VARTYPE_TABLEAU 0x80
+#define VARTYPE_BASE(type) ((type) & 0x7F)
+#define VARTYPE_EST_TABLEAU(type) (((type) & VARTYPE_TABLEAU) != 0)
 
 typedef uint8_t csc_var_type;
 
@@ -17,15 +28,43 @@ struct csc_var {
     csc_var_type type;
     char* name;
     void* value;
+    size_t longueur;        // For an array, its number of elements
 };
 
 struct csc_var_list {
-    struct csc_var* local;
-    struct csc_var_list* next;
+    struct csc_var* vars;   // The variables, contiguous, in the order they were registered in
+    size_t nombre;
+    void* index;            // Actually a csc_var_index*, finding the variables by name
+};
+
+// A variable to register with ajouter_variables()
+struct csc_liaison {
+    csc_var_type type;
+    const char* nom;
+    void* ptr;
+    size_t longueur;        // For an array, its number of elements
 };
 
+// A field of a C struct, bound with lier_structure()
+struct csc_champ {
+    const char* nom;
+    csc_var_type type;
+    size_t decalage;        // offsetof() the field
+    size_t longueur;        // For an array, its number of elements
+};
+
+// Describes the field champ of the C struct structure, named after it: {CSC_CHAMP(ma_struct, x, VARTYPE_FLOAT), ...}
+#define CSC_CHAMP(structure, champ, type) { #champ, (type), offsetof(structure, champ) }
+// The same, under another name than the field's
+#define CSC_CHAMP_NOMME(nom, structure, champ, type) { (nom), (type), offsetof(structure, champ) }
+// Describes the array field champ of the C struct structure, whose elements are of type type: float v[16] is {CSC_CHAMP_TABLEAU(ma_struct, v, VARTYPE_FLOAT)}
+#define CSC_CHAMP_TABLEAU(structure, champ, type) \
+    { #champ, VARTYPE_TABLEAU | (type), offsetof(structure, champ), sizeof(((structure*)0)->champ)/sizeof(((structure*)0)->champ[0]) }
+
 
 typedef struct csc_var csc_var;
 typedef struct csc_var_list csc_var_list;
+typedef struct csc_liaison csc_liaison;
+typedef struct csc_champ csc_champ;
 
 #endif
\ No newline at end of file
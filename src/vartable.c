@@ -8,6 +8,11 @@
 
 /*!
     Defines several useful functions for manipulating the Cascada variables and variables lists.
+    
+    A list keeps its variables in a contiguous array, in the order they were registered in, along with
+    a hash table finding them by name: registering or looking up a variable doesn't depend on how many
+    there are. The names are interned, shared by every list of the process (the nodes bind the same
+    names), and copied into an arena: a variable costs no allocation of its own.
 */
 
 
@@ -20,59 +25,313 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include <pthread.h>
 
 #include "util.h"
 #include "safe_malloc.h"
 #include "vartable.h"
 #include "varstructs.h"
+#include "tableaux.h"
+
+
+// Initial number of slots of the index of a list; always a power of two
+#define INDEX_CAPACITE_MIN 16
+
+// The interned names are copied into blocks of that size
+#define ARENE_NOMS_BLOC 65536
+
+// One slot of the index of a list (open addressing, linear probing)
+typedef struct csc_var_case {
+    uint32_t position;          // 1 + the position of the variable in the list; 0 if the slot is free
+    uint32_t empreinte;         // The hash of the name of the variable
+} csc_var_case;
+
+// Finds the variables of a list by name
+typedef struct csc_var_index {
+    csc_var_case* cases;        // Allocated with the variables, right after them
+    size_t capacite;
+    size_t version;             // Changes whenever a variable is added or rebound
+} csc_var_index;
+
+// The names of the variables, interned: every list of the process shares them
+static struct {
+    char** noms;
+    uint32_t* empreintes;
+    size_t capacite;
+    size_t nombre;
+    
+    char* bloc;                 // The block of the arena names are copied into; it starts with a pointer to the previous one
+    char* libre;                // Where the next name goes in it
+    char* fin;
+    
+    pthread_mutex_t verrou;
+} noms_internes = {NULL, NULL, 0, 0, NULL, NULL, NULL, PTHREAD_MUTEX_INITIALIZER};
 
 
-#define CMP_NOMATCH 0
-#define CMP_NAME_MATCH 1
-#define CMP_NAME_TYPE_MATCH 2
-#define CMP_NAME_TYPE_VALUE_MATCH 3
+/*!
+    \brief Hashes a name (FNV-1a).
+    
+    \param nom The name; it does not need to be NUL-terminated.
+    \param longueur The length of the name.
+    \return The hash.
+*/
+static uint32_t empreinte_nom(const char* nom, size_t longueur){
+    uint32_t empreinte = 2166136261u;
+    size_t i;
+    
+    for(i = 0; i < longueur; i++){
+        empreinte ^= (unsigned char)nom[i];
+        empreinte *= 16777619u;
+    }
+    
+    return empreinte;
+}
 
 
-int cmp_var_noval(const csc_var* v1, const csc_var* v2);
+/*!
+    \brief Tells how many slots an open-addressing table needs to hold some entries.
+    
+    \param nombre The number of entries.
+    \param capacite The current number of slots.
+    \return The number of slots, a power of two: capacite if it is enough.
+*/
+static size_t capacite_pour(size_t nombre, size_t capacite){
+    if(capacite < INDEX_CAPACITE_MIN)
+        capacite = INDEX_CAPACITE_MIN;
+    
+    // Kept at most 3/4 full, so that the probes stay short
+    while(nombre*4 > capacite*3)
+        capacite *= 2;
+    
+    return capacite;
+}
 
 
+/*!
+    \brief Makes room for more names in the interned names. Their lock must be held.
+    
+    \param nombre The number of names they should be able to hold.
+*/
+static void reserver_noms(size_t nombre){
+    size_t capacite = capacite_pour(nombre, noms_internes.capacite);
+    char** noms = NULL;
+    uint32_t* empreintes = NULL;
+    size_t i, j;
+    
+    if(capacite == noms_internes.capacite)
+        return;
+    
+    noms = safe_malloc(capacite*sizeof(char*));
+    empreintes = safe_malloc(capacite*sizeof(uint32_t));
+    memset(noms, 0, capacite*sizeof(char*));
+    
+    for(i = 0; i < noms_internes.capacite; i++){
+        if(!noms_internes.noms[i])
+            continue;
+        j = noms_internes.empreintes[i] & (capacite - 1);
+        while(noms[j])
+            j = (j + 1) & (capacite - 1);
+        noms[j] = noms_internes.noms[i];
+        empreintes[j] = noms_internes.empreintes[i];
+    }
+    
+    free(noms_internes.noms);
+    free(noms_internes.empreintes);
+    noms_internes.noms = noms;
+    noms_internes.empreintes = empreintes;
+    noms_internes.capacite = capacite;
+}
+
 
 /*!
-    \brief Creates a new variable list.
+    \brief Copies a name into the arena of the interned names. Their lock must be held.
     
-    \return A pointer to a new, empty, list                
+    \param nom The name; it does not need to be NUL-terminated.
+    \param longueur The length of the name.
+    \return The copy, NUL-terminated.
 */
+static char* copier_nom(const char* nom, size_t longueur){
+    size_t taille = sizeof(char*) + longueur + 1;
+    char* bloc = NULL;
+    char* copie = NULL;
+    
+    if(!noms_internes.libre || (size_t)(noms_internes.fin - noms_internes.libre) < longueur + 1){
+        // The blocks are chained, so that they stay reachable
+        if(taille < ARENE_NOMS_BLOC)
+            taille = ARENE_NOMS_BLOC;
+        bloc = safe_malloc(taille);
+        memcpy(bloc, &noms_internes.bloc, sizeof(char*));
+        noms_internes.bloc = bloc;
+        noms_internes.libre = bloc + sizeof(char*);
+        noms_internes.fin = bloc + taille;
+    }
+    
+    copie = noms_internes.libre;
+    memcpy(copie, nom, longueur);
+    copie[longueur] = '\0';
+    noms_internes.libre += longueur + 1;
+    
+    return copie;
+}
 
-csc_var_list* nouvelle_liste(void){
-    csc_var_list* liste=safe_malloc(sizeof(csc_var_list));
-    liste->local = NULL;
-    liste->next = NULL;
 
-    return liste;
+/*!
+    \brief Finds the interned copy of a name, interning it if it's not yet. Their lock must be held.
+    
+    \param nom The name; it does not need to be NUL-terminated.
+    \param longueur The length of the name.
+    \param empreinte The hash of the name.
+    \return The interned name; it lives as long as the process.
+*/
+static char* interner_nom(const char* nom, size_t longueur, uint32_t empreinte){
+    size_t i;
+    
+    reserver_noms(noms_internes.nombre + 1);
+    
+    i = empreinte & (noms_internes.capacite - 1);
+    while(noms_internes.noms[i]){
+        if(noms_internes.empreintes[i] == empreinte && !strncmp(noms_internes.noms[i], nom, longueur)
+           && noms_internes.noms[i][longueur] == '\0')
+            return noms_internes.noms[i];
+        i = (i + 1) & (noms_internes.capacite - 1);
+    }
+    
+    noms_internes.noms[i] = copier_nom(nom, longueur);
+    noms_internes.empreintes[i] = empreinte;
+    noms_internes.nombre += 1;
+    
+    return noms_internes.noms[i];
 }
 
+
 /*!
-    \brief Safely compares two pointers to cascada variables.
-    
-    \param v1 A pointer to the first variable
-    \param v2 A pointer to the second variable
-    \return - CMP_NAME_TYPE_MATCH if both the names and the types match
-            - CMP_NAME_MATCH if only the names match
-            - CMP_NOMATCH if nothing matches
-                    
+    \brief Makes room for more variables in a list.
+    
+    \note The variables and the slots of the index share a single allocation; growing the list moves its variables.
+    
+    \param list The list.
+    \param nombre The number of variables it should be able to hold.
 */
-int cmp_var_noval(const csc_var* v1, const csc_var* v2){
+static void reserver_liste(csc_var_list* list, size_t nombre){
+    csc_var_index* index = list->index;
+    size_t capacite = capacite_pour(nombre, index->capacite);
+    size_t places = capacite/4*3;
+    csc_var* vars = NULL;
+    csc_var_case* cases = NULL;
+    size_t i, j;
     
-    if(!strcmp(v1->name, v2->name)){
-        if(v1->type == v2->type){
-                return CMP_NAME_TYPE_MATCH;
-            } else {
-                return CMP_NAME_MATCH;
-        }
-    }  else {
-        return CMP_NOMATCH;
+    if(capacite == index->capacite)
+        return;
+    
+    vars = safe_malloc(places*sizeof(csc_var) + capacite*sizeof(csc_var_case));
+    cases = (csc_var_case*)(vars + places);
+    memset(cases, 0, capacite*sizeof(csc_var_case));
+    
+    if(list->nombre)
+        memcpy(vars, list->vars, list->nombre*sizeof(csc_var));
+    
+    for(i = 0; i < index->capacite; i++){
+        if(!index->cases[i].position)
+            continue;
+        j = index->cases[i].empreinte & (capacite - 1);
+        while(cases[j].position)
+            j = (j + 1) & (capacite - 1);
+        cases[j] = index->cases[i];
     }
     
+    free(list->vars);
+    list->vars = vars;
+    index->cases = cases;
+    index->capacite = capacite;
+}
+
+
+/*!
+    \brief Finds a variable of a list through its index.
+    
+    \param list The list.
+    \param nom The name of the variable; it does not need to be NUL-terminated.
+    \param longueur The length of the name.
+    \param empreinte The hash of the name.
+    \return The variable; NULL if there is none.
+*/
+static csc_var* chercher_variable(const csc_var_list* list, const char* nom, size_t longueur, uint32_t empreinte){
+    const csc_var_index* index = list->index;
+    size_t i = empreinte & (index->capacite - 1);
+    csc_var* var = NULL;
+    
+    while(index->cases[i].position){
+        var = &list->vars[index->cases[i].position - 1];
+        // Two interned names are the same string if they are the same pointer
+        if(index->cases[i].empreinte == empreinte && (var->name == nom || nom_egal(var, nom, longueur)))
+            return var;
+        i = (i + 1) & (index->capacite - 1);
+    }
+    
+    return NULL;
+}
+
+
+/*!
+    \brief Appends a variable to a list, unless the list already has one with the same name.
+    
+    \param list The list.
+    \param type The cascada type of the variable.
+    \param nom The interned name of the variable.
+    \param longueur The length of the name.
+    \param empreinte The hash of the name.
+    \param ptr The adress of the underlying C variable.
+    \param elements For an array, its number of elements; ignored otherwise.
+    \return true if the variable was added, false if the name was taken.
+*/
+static bool inscrire_variable(csc_var_list* list, csc_var_type type, char* nom, size_t longueur, uint32_t empreinte, void* ptr, size_t elements){
+    csc_var_index* index = list->index;
+    csc_var* myvar = NULL;
+    size_t i;
+    
+    if(chercher_variable(list, nom, longueur, empreinte))
+        return false;
+    
+    reserver_liste(list, list->nombre + 1);
+    
+    myvar = &list->vars[list->nombre++];
+    myvar->name = nom;
+    myvar->type = type;
+    myvar->value = ptr;
+    myvar->longueur = VARTYPE_EST_TABLEAU(type) ? elements : 1;
+    
+    i = empreinte & (index->capacite - 1);
+    while(index->cases[i].position)
+        i = (i + 1) & (index->capacite - 1);
+    index->cases[i].position = (uint32_t)list->nombre;
+    index->cases[i].empreinte = empreinte;
+    index->version += 1;
+    
+    return true;
+}
+
+
+/*!
+    \brief Creates a new variable list.
+    
+    \return A pointer to a new, empty, list                
+*/
+
+csc_var_list* nouvelle_liste(void){
+    // The list and its index share a single allocation
+    csc_var_list* liste=safe_malloc(sizeof(csc_var_list) + sizeof(csc_var_index));
+    csc_var_index* index = (csc_var_index*)(liste + 1);
+    
+    index->cases = NULL;
+    index->capacite = 0;
+    index->version = 0;
+    
+    liste->vars = NULL;
+    liste->nombre = 0;
+    liste->index = index;
+    reserver_liste(liste, 0);
+    
+    return liste;
 }
 
 
@@ -87,71 +346,124 @@ int cmp_var_noval(const csc_var* v1, const csc_var* v2){
                 - VARTYPE_DOUBLE  
                 - VARTYPE_I32 
                 - VARTYPE_I64
-
+                - VARTYPE_I8
+                - VARTYPE_U16
+                - VARTYPE_I16
+                - VARTYPE_FP16 (a uint16_t holding a half float)
+                - VARTYPE_BF16 (a uint16_t holding a bfloat16)
+    
     \param nom The name of the variable. Should match the name provided in the scheme sent by the master server.
     \param ptr The adress of the underlying C variable.
     \param list A pointer to the list of variables that the new variable should be added to.
     \return true if the variable was successfully added, false if not.
-
+    
     \note If a variable with the same name already exists, its value WILL NOT BE UPDATED; nothing will happen.            
     \note The name parameter has nothing to do with the name of the underlying C variable.
     \note The name of the variable is copied, and therefore ownership of the array nom is NOT shared.
 */
 bool ajouter_variable(csc_var_type type, char* nom, void* ptr, csc_var_list* list){
-
+    size_t longueur;
+    uint32_t empreinte;
+    char* interne = NULL;
+    
     // Can't do anything with a NULL pointer
     if(list == NULL){
         return false;
     }
     
-    int res_cmp;
-
-    csc_var_list* prec = NULL;
-    csc_var_list* premier_null = NULL;
+    longueur = strlen(nom);
+    empreinte = empreinte_nom(nom, longueur);
     
-    csc_var* myvar = safe_malloc(sizeof(csc_var));
-    myvar->name = strdup(nom);
-    myvar->type = type;
-    myvar->value = ptr;
+    pthread_mutex_lock(&noms_internes.verrou);
+    interne = interner_nom(nom, longueur, empreinte);
+    pthread_mutex_unlock(&noms_internes.verrou);
     
+    return inscrire_variable(list, type, interne, longueur, empreinte, ptr, 1);
+}
+
+
+/*!
+    \brief Adds an array variable named nom, which elements have type type, held in the buffer ptr, to the variable list list.
     
+    \param type The cascada type of the elements of the array (see ajouter_variable()).
+    \param nom The name of the variable. Should match the name provided in the scheme sent by the master server.
+    \param ptr The adress of the first element of the underlying C buffer.
+    \param longueur The number of elements of the buffer.
+    \param list A pointer to the list of variables that the new variable should be added to.
+    \return true if the variable was successfully added, false if not.
     
-    while(list != NULL){
-        if(list->local != NULL)
-        {
-            res_cmp = cmp_var_noval(myvar, list->local);
-            if(res_cmp != CMP_NOMATCH){
-                // We found the variable, which therefore does already exist
-                free(myvar->name);
-                free(myvar);
-                return false;
-            }
-        } else {
-            if(!premier_null){
-                premier_null = list;
-            }
-        }
-        prec = list;
-        list = list->next;
-        
+    \note The scheme of the master should give the variable the type VARTYPE_TABLEAU | type; the arrays it sends
+           must have exactly longueur elements.
+    \note See ajouter_variable() for the rest.
+*/
+bool ajouter_tableau(csc_var_type type, char* nom, void* ptr, size_t longueur, csc_var_list* list){
+    size_t taille;
+    uint32_t empreinte;
+    char* interne = NULL;
+    
+    if(list == NULL || !longueur){
+        return false;
     }
     
-    // We made it to the end of the list without issue
-    // We can therefore add myvar to the list
+    taille = strlen(nom);
+    empreinte = empreinte_nom(nom, taille);
+    
+    pthread_mutex_lock(&noms_internes.verrou);
+    interne = interner_nom(nom, taille, empreinte);
+    pthread_mutex_unlock(&noms_internes.verrou);
     
-    // Either we found a hole in the list
-    if(premier_null != NULL){
-        premier_null->local = myvar;
-    } else {
+    return inscrire_variable(list, VARTYPE_TABLEAU | type, interne, taille, empreinte, ptr, longueur);
+}
+
 
-        // Or we didn't, and we have to allocate a new link in the linked list
-        // That we'll store in prec->next
-        prec->next = safe_malloc(sizeof(csc_var_list));
-        prec->next->local = myvar;
-        prec->next->next  = NULL;
+/*!
+    \brief Adds several variables to the variable list list at once; see ajouter_variable().
+    
+    \param liaisons The variables: their cascada types, their names and the adresses of the underlying C variables;
+                    and, for the arrays (VARTYPE_TABLEAU | type), their numbers of elements.
+    \param nombre The number of variables.
+    \param list A pointer to the list of variables that the new variables should be added to.
+    \return The number of variables that were added; those which name was already taken are skipped.
+    
+    \note The list and the interned names are grown once for all the variables, and the lock of the interned
+           names is only taken once: prefer it to ajouter_variable() for schemes with many variables.
+*/
+size_t ajouter_variables(const csc_liaison* liaisons, size_t nombre, csc_var_list* list){
+    char** noms = NULL;
+    uint32_t* empreintes = NULL;
+    size_t* longueurs = NULL;
+    size_t ajoutees = 0;
+    size_t i;
+    
+    if(list == NULL || !nombre){
+        return 0;
     }
     
-    return true;
+    noms = safe_malloc(nombre*sizeof(char*));
+    empreintes = safe_malloc(nombre*sizeof(uint32_t));
+    longueurs = safe_malloc(nombre*sizeof(size_t));
+    
+    for(i = 0; i < nombre; i++){
+        longueurs[i] = strlen(liaisons[i].nom);
+        empreintes[i] = empreinte_nom(liaisons[i].nom, longueurs[i]);
+    }
+    
+    pthread_mutex_lock(&noms_internes.verrou);
+    reserver_noms(noms_internes.nombre + nombre);
+    for(i = 0; i < nombre; i++)
+        noms[i] = interner_nom(liaisons[i].nom, longueurs[i], empreintes[i]);
+    pthread_mutex_unlock(&noms_internes.verrou);
+    
+    reserver_liste(list, list->nombre + nombre);
+    for(i = 0; i < nombre; i++)
+        if(inscrire_variable(list, liaisons[i].type, noms[i], longueurs[i], empreintes[i], liaisons[i].ptr, liaisons[i].longueur))
+            ajoutees += 1;
+    
+    free(noms);
+    free(empreintes);
+    free(longueurs);
+    
+    return ajoutees;
 }
 
 /*!
@@ -160,17 +472,56 @@ bool ajouter_variable(csc_var_type type, char* nom, void* ptr, csc_var_list* lis
     \param nom The name of the variable.
     \param list A pointer to the list of variables that will be searched.
     \return A pointer to the variable if it does exist in the list; NULL if not
+    
+    \warning The variable moves when another one is added to the list: the pointer must not be kept.
 */
 csc_var* recup_variable(char* nom, csc_var_list* list){
-    while(list != NULL){
-        if(list->local != NULL){
-            if(!strcmp(nom, list->local->name)){
-                return list->local;
-            }
-        }
-        list = list->next;
+    return recup_variable_n(nom, strlen(nom), list);
+}
+
+
+/*!
+    \brief Fetches the variable which name is the first longueur characters of nom.
+    
+    \param nom The name of the variable; it does not need to be NUL-terminated.
+    \param longueur The length of the name.
+    \param list A pointer to the list of variables that will be searched.
+    \return A pointer to the variable if it does exist in the list; NULL if not
+    
+    \warning The variable moves when another one is added to the list: the pointer must not be kept.
+*/
+csc_var* recup_variable_n(const char* nom, size_t longueur, csc_var_list* list){
+    if(list == NULL){
+        return NULL;
     }
-    return NULL;
+    return chercher_variable(list, nom, longueur, empreinte_nom(nom, longueur));
+}
+
+/*!
+    \brief Tells whether the variable is named after the first longueur characters of nom.
+    
+    \param var The variable.
+    \param nom The name; it does not need to be NUL-terminated.
+    \param longueur The length of the name.
+    \return true if the names match.
+*/
+bool nom_egal(const csc_var* var, const char* nom, size_t longueur){
+    // The name of another variable, interned too
+    if(var->name == nom)
+        return var->name[longueur] == '\0';
+    
+    return !strncmp(var->name, nom, longueur) && var->name[longueur] == '\0';
+}
+
+
+/*!
+    \brief Tells the version of a list, which changes whenever a variable is added to it or rebound.
+    
+    \param list The list.
+    \return The version; whatever was resolved against the list at another version must be resolved again.
+*/
+size_t version_liste(const csc_var_list* list){
+    return list ? ((const csc_var_index*)list->index)->version : 0;
 }
 
 
@@ -181,18 +532,13 @@ csc_var* recup_variable(char* nom, csc_var_list* list){
 */
 
 void detruire_liste(csc_var_list* liste){
-    csc_var_list* suivant = NULL;
-    
-    while(liste != NULL){
-        suivant = liste->next;
-        if(liste->local){
-            free(liste->local->name);
-        }
-        free(liste->local);
-        free(liste);
-        liste = suivant;
+    if(liste == NULL){
+        return;
     }
     
+    // The index lives with the list, its slots with the variables; the names are interned, and outlive the list
+    free(liste->vars);
+    free(liste);
 }
 
 /*!
@@ -201,6 +547,8 @@ void detruire_liste(csc_var_list* liste){
     \param myvar A pointer to the vairable that should be printed.
 */
 void afficher_variable(csc_var* myvar){
+    csc_var element;
+    size_t i;
     
     if(myvar == NULL){
         return;
@@ -212,6 +560,18 @@ void afficher_variable(csc_var* myvar){
         return;
     }
     
+    if(VARTYPE_EST_TABLEAU(myvar->type)){
+        element = *myvar;
+        element.type = VARTYPE_BASE(myvar->type);
+        printf("%s: [", myvar->name);
+        for(i = 0; i < myvar->longueur; i++){
+            element.value = (uint8_t*)myvar->value + i*vartype_taille(myvar->type);
+            printf(i ? ", %g" : "%g", var2double(&element));
+        }
+        printf("]");
+        return;
+    }
+    
     switch (myvar->type) {
         case VARTYPE_U8:
             printf("%s: %"PRIu8, myvar->name, *((uint8_t*)(myvar->value)));
@@ -224,7 +584,7 @@ void afficher_variable(csc_var* myvar){
         case VARTYPE_I64:
             printf("%s: %"PRId64, myvar->name, *((int64_t*)(myvar->value)));
             break;
-
+    
         case VARTYPE_U32:
             printf("%s: %"PRIu32, myvar->name, *((uint32_t*)(myvar->value)));
             break;
@@ -240,7 +600,24 @@ void afficher_variable(csc_var* myvar){
         case VARTYPE_DOUBLE:
             printf("%s: %lf", myvar->name, *((double*)(myvar->value)));
             break;
-
+            
+        case VARTYPE_I8:
+            printf("%s: %"PRId8, myvar->name, *((int8_t*)(myvar->value)));
+            break;
+            
+        case VARTYPE_U16:
+            printf("%s: %"PRIu16, myvar->name, *((uint16_t*)(myvar->value)));
+            break;
+            
+        case VARTYPE_I16:
+            printf("%s: %"PRId16, myvar->name, *((int16_t*)(myvar->value)));
+            break;
+            
+        case VARTYPE_FP16:
+        case VARTYPE_BF16:
+            printf("%s: %f", myvar->name, var2double(myvar));
+            break;
+    
         
         default:
             printf("%s: ??? [%d]", myvar->name, myvar->type);
@@ -254,10 +631,11 @@ void afficher_variable(csc_var* myvar){
     \param liste A pointer to the cascada variable list that should be printed.
 */
 void afficher_liste(csc_var_list* liste){
-    while(liste){
-        afficher_variable(liste->local);
+    size_t i;
+    
+    for(i = 0; liste && i < liste->nombre; i++){
+        afficher_variable(&liste->vars[i]);
         printf("\n");
-        liste = liste->next;
     }
 }
 
@@ -268,40 +646,39 @@ void afficher_liste(csc_var_list* liste){
     \param list A pointer to the cascada variable list that should be completed.
     \param src  A pointer to the cascada variable list that should be used to complete list.
     \return 0 if everything went fine and an error code if not.
-
+    
     \warning All the variables of list must exist in src. 
 */
 int calquer_liste(csc_var_list* list, csc_var_list* src){
-
+    
     // For each value of list, we check if it is in src.
     // If it's the case, we change the value of the element to
     // have it equal to the corresponding element of src
     
-    csc_var_list* orig_src = src;
+    csc_var* var = NULL;
+    csc_var* source = NULL;
+    size_t i;
     
     int retcode = 0;
-    bool found;
-    
-    while(list){
-        found = false;
-        if(list->local){
-            while(src){
-                if(src->local && !strcmp(src->local->name, list->local->name)){
-                    // Compatible type ? 
-                    if(src->local->type == list->local->type)
-                        list->local->value = src->local->value;
-                    else
-                        retcode |= VAR_CALQUE_TYPE_INCOMPATIBLE;
-                    src = orig_src;
-                    found = true;
-                    break;
-                }
-                src = src->next;
-            }
-        }
-        if(!found)
+    
+    if(list == NULL){
+        return VAR_CALQUE_NON_TROUVE;
+    }
+    
+    ((csc_var_index*)list->index)->version += 1;
+    
+    for(i = 0; i < list->nombre; i++){
+        var = &list->vars[i];
+        source = recup_variable_n(var->name, strlen(var->name), src);
+        if(!source){
             retcode |= VAR_CALQUE_NON_TROUVE;
-        list = list->next;
+            continue;
+        }
+        // Compatible type ? 
+        if(source->type == var->type && source->longueur == var->longueur)
+            var->value = source->value;
+        else
+            retcode |= VAR_CALQUE_TYPE_INCOMPATIBLE;
     }
     
     return retcode;
@@ -313,11 +690,12 @@ int calquer_liste(csc_var_list* list, csc_var_list* src){
     
     \param var  A pointer to the cascada variable that should be cast.
     \return The value of the variable casted as a double.
-
+    
     \note If the variable can't be cast because its type is unknown (which should not happen), the function returns 0.0.
+    \note The value of an array is that of its first element.
 */
 double var2double(csc_var* var){
-    switch (var->type) {
+    switch (VARTYPE_BASE(var->type)) {
         case VARTYPE_U8:
             return (double)(*((uint8_t*)(var->value)));
             break;
@@ -346,6 +724,26 @@ double var2double(csc_var* var){
             return *((double*)(var->value));
             break;
             
+        case VARTYPE_I8:
+            return (double)(*((int8_t*)(var->value)));
+            break;
+            
+        case VARTYPE_U16:
+            return (double)(*((uint16_t*)(var->value)));
+            break;
+            
+        case VARTYPE_I16:
+            return (double)(*((int16_t*)(var->value)));
+            break;
+            
+        case VARTYPE_FP16:
+            return (double)demi_vers_float(*((uint16_t*)(var->value)));
+            break;
+            
+        case VARTYPE_BF16:
+            return (double)bf16_vers_float(*((uint16_t*)(var->value)));
+            break;
+            
         default:
             return 0.0;
     }
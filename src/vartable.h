@@ -9,6 +9,7 @@
 #ifndef vartable_h
 #define vartable_h
 
+#include <stddef.h>
 #include <stdbool.h>
 #include "varstructs.h"   // needed for csc_var_type
 
@@ -21,7 +22,12 @@ typedef struct csc_var csc_var;
 
 csc_var_list* nouvelle_liste(void);
 bool ajouter_variable(csc_var_type type, char* nom, void* ptr, csc_var_list* list);
+bool ajouter_tableau(csc_var_type type, char* nom, void* ptr, size_t longueur, csc_var_list* list);
+size_t ajouter_variables(const csc_liaison* liaisons, size_t nombre, csc_var_list* list);
 csc_var* recup_variable(char* nom, csc_var_list* list);
+csc_var* recup_variable_n(const char* nom, size_t longueur, csc_var_list* list);
+bool nom_egal(const csc_var* var, const char* nom, size_t longueur);
+size_t version_liste(const csc_var_list* list);
 void detruire_liste(csc_var_list* liste);
 void afficher_variable(csc_var* myvar);
 void afficher_liste(csc_var_list* liste);
@@ -7,25 +7,471 @@
 //
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
+#include <strings.h>
 
 #include <curl/curl.h>
+#include <zlib.h>
+#ifdef CSC_AVEC_ZSTD
+#include <zstd.h>
+#endif
 
 #include "util.h"
 #include "safe_malloc.h"
+#include "entities.h"
 #include "www.h"
 
 
-size_t dl2string(char *ptr, size_t size, size_t nmemb, www_writestruct* writeinfo){
+// Smallest capacity of a receive buffer
+#define ECRITURE_CAPACITE_MIN 1024
+
+// Largest Content-Length the receive buffer is sized from before the answer arrives
+#define ECRITURE_INDICATION_MAX (64*1024*1024)
+
+
+/*!
+    \brief Makes sure the receive buffer can hold taille bytes (and the final NUL) without growing.
+    
+    \param writeinfo The receive buffer.
+    \param taille The number of bytes.
+    \return false if the memory could not be allocated, or taille is too large; the buffer is left untouched.
+*/
+bool ecriture_reserver(www_writestruct* writeinfo, size_t taille){
     char* newalloc = NULL;
-    newalloc = realloc(writeinfo->ptr, writeinfo->size + nmemb*size + sizeof(char));
-    if(newalloc == NULL){
-        die("Erreur d'allocation\n");
+    size_t capacite = writeinfo->capacite ? writeinfo->capacite : ECRITURE_CAPACITE_MIN;
+    
+    if(taille >= SIZE_MAX)
+        return false;
+    if(taille + sizeof(char) <= writeinfo->capacite)
+        return true;
+    
+    // Geometric growth: a buffer is only reallocated a handful of times over its life
+    while(capacite < taille + sizeof(char)){
+        if(capacite > SIZE_MAX/2){
+            capacite = taille + sizeof(char);
+            break;
+        }
+        capacite *= 2;
     }
+    
+    newalloc = realloc(writeinfo->ptr, capacite);
+    if(newalloc == NULL)
+        return false;
+    
     writeinfo->ptr = newalloc;
+    writeinfo->capacite = capacite;
+    writeinfo->agrandissements += 1;
+    
+    return true;
+}
+
+
+/*!
+    \brief Empties the receive buffer, keeping its memory for the next answer.
+    
+    \param writeinfo The receive buffer.
+*/
+void ecriture_vider(www_writestruct* writeinfo){
+    writeinfo->size = 0;
+    if(writeinfo->ptr)
+        writeinfo->ptr[0] = '\0';
+}
+
+
+/*!
+    \brief Frees the memory of the receive buffer.
+    
+    \param writeinfo The receive buffer.
+*/
+void ecriture_liberer(www_writestruct* writeinfo){
+    free(writeinfo->ptr);
+    writeinfo->ptr = NULL;
+    writeinfo->size = 0;
+    writeinfo->capacite = 0;
+}
+
+
+size_t dl2string(char *ptr, size_t size, size_t nmemb, www_writestruct* writeinfo){
+    // Out of memory: 0 makes curl abort the transfer with CURLE_WRITE_ERROR
+    if(nmemb*size > SIZE_MAX - writeinfo->size || !ecriture_reserver(writeinfo, writeinfo->size + nmemb*size)){
+        return 0;
+    }
     memcpy(&(writeinfo->ptr[writeinfo->size]), ptr, size*nmemb);
     writeinfo->size += size*nmemb;
     writeinfo->ptr[writeinfo->size] = '\0';     // on termine la chaîne
     
+    if(writeinfo->size > writeinfo->pic)
+        writeinfo->pic = writeinfo->size;
+    
     return size*nmemb;
 }
+
+
+/*!
+    \brief Header callback: sizes the receive buffer from the Content-Length of the answer.
+    
+    \note With a compressed answer, Content-Length is the compressed size; the buffer still grows if needed.
+    \note Content-Length is only a hint: above ECRITURE_INDICATION_MAX, the buffer grows as the answer arrives.
+*/
+static size_t lire_entete(char* ligne, size_t size, size_t nitems, www_writestruct* writeinfo){
+    static const char nom[] = "content-length:";
+    size_t longueur = size*nitems;
+    char nombre[32];
+    char* fin = NULL;
+    unsigned long long taille;
+    
+    if(longueur <= sizeof(nom) - 1 || longueur - (sizeof(nom) - 1) >= sizeof(nombre))
+        return longueur;
+    if(strncasecmp(ligne, nom, sizeof(nom) - 1))
+        return longueur;
+    
+    memcpy(nombre, ligne + sizeof(nom) - 1, longueur - (sizeof(nom) - 1));
+    nombre[longueur - (sizeof(nom) - 1)] = '\0';
+    taille = strtoull(nombre, &fin, 10);
+    
+    if(fin == nombre || taille > ECRITURE_INDICATION_MAX)
+        return longueur;
+    
+    // Out of memory: 0 makes curl abort the transfer with CURLE_WRITE_ERROR
+    if(!ecriture_reserver(writeinfo, writeinfo->size + (size_t)taille))
+        return 0;
+    
+    return longueur;
+}
+
+
+/*!
+    \brief Builds the header lists of the requests, for every format and content encoding.
+    
+    \return The header lists, to be freed with entetes_detruire().
+*/
+www_entetes* entetes_creer(void){
+    static const char* types[2] = {
+        "Content-Type: " WWW_TYPE_JSON,
+        "Content-Type: " WWW_TYPE_CBOR
+    };
+    static const char* encodages[3] = { NULL, "Content-Encoding: gzip", "Content-Encoding: zstd" };
+    www_entetes* entetes = safe_malloc(sizeof(www_entetes));
+    struct curl_slist* liste = NULL;
+    
+    for(int format = 0; format < 2; format++){
+        for(int algo = 0; algo < 3; algo++){
+            liste = curl_slist_append(NULL, "Expect:");
+            liste = curl_slist_append(liste, types[format]);
+            // The answer is asked for in the format of the request
+            if(format == CSC_FORMAT_CBOR)
+                liste = curl_slist_append(liste, "Accept: " WWW_TYPE_CBOR ", " WWW_TYPE_JSON ";q=0.5");
+            if(encodages[algo])
+                liste = curl_slist_append(liste, encodages[algo]);
+            if(!liste)
+                die("Erreur d'allocation\n");
+            entetes->listes[format][algo] = liste;
+        }
+    }
+    
+    return entetes;
+}
+
+
+/*!
+    \brief Frees the header lists of the requests.
+    
+    \param entetes The header lists.
+*/
+void entetes_detruire(www_entetes* entetes){
+    if(!entetes)
+        return;
+    
+    for(int format = 0; format < 2; format++){
+        for(int algo = 0; algo < 3; algo++)
+            curl_slist_free_all(entetes->listes[format][algo]);
+    }
+    free(entetes);
+}
+
+
+/*!
+    \brief Initializes an idle transfer.
+    
+    \param transfert The transfer.
+    \param handler The curl handle the transfer will use.
+*/
+void transfert_initialiser(www_transfert* transfert, CURL* handler){
+    transfert->handler = handler;
+    transfert->requete = NULL;
+    transfert->ecriture.ptr = NULL;
+    transfert->ecriture.size = 0;
+    transfert->ecriture.capacite = 0;
+    transfert->ecriture.pic = 0;
+    transfert->ecriture.agrandissements = 0;
+    transfert->sortie.ptr = NULL;
+    transfert->sortie.size = 0;
+    transfert->sortie.capacite = 0;
+    transfert->sortie.pic = 0;
+    transfert->sortie.agrandissements = 0;
+    transfert->entetes = NULL;
+    transfert->format = CSC_FORMAT_JSON;
+    transfert->serveur = NULL;
+    transfert->corps = NULL;
+    transfert->taille_corps = 0;
+}
+
+
+/*!
+    \brief Sets the headers of a request, and where its answer is received.
+    
+    \note The URL is set apart, by the master server the request goes to.
+    
+    \param transfert The transfer.
+    \param entetes The shared header lists.
+    \param format The format of the body (CSC_FORMAT_...); the answer is asked for in the same format.
+*/
+static void preparer_entetes(www_transfert* transfert, const www_entetes* entetes, int format){
+    CURL* handler = transfert->handler;
+    
+    transfert->entetes = entetes;
+    transfert->format = format;
+    
+    curl_easy_setopt(handler, CURLOPT_HTTPHEADER, entetes->listes[format][CSC_COMPRESSION_AUCUNE]);
+    
+    // The answer is received in the buffer left by the previous one
+    ecriture_vider(&transfert->ecriture);
+    curl_easy_setopt(handler, CURLOPT_WRITEFUNCTION, dl2string);
+    curl_easy_setopt(handler, CURLOPT_WRITEDATA, &transfert->ecriture);
+    curl_easy_setopt(handler, CURLOPT_HEADERFUNCTION, lire_entete);
+    curl_easy_setopt(handler, CURLOPT_HEADERDATA, &transfert->ecriture);
+}
+
+
+/*!
+    \brief Sets up the handler of the transfer for POSTing a document.
+    
+    \param transfert The transfer.
+    \param entetes The shared header lists.
+    \param corps The body of the request: either the send buffer of the transfer, or a buffer it takes ownership of.
+    \param taille The size of the body, in bytes.
+    \param format The format of the body (CSC_FORMAT_...); the answer is asked for in the same format.
+*/
+void transfert_preparer(www_transfert* transfert, const www_entetes* entetes, char* corps, size_t taille, int format){
+    CURL* handler = transfert->handler;
+    
+    transfert->corps = corps;
+    transfert->taille_corps = taille;
+    
+    preparer_entetes(transfert, entetes, format);
+    
+    curl_easy_setopt(handler, CURLOPT_POSTFIELDS, transfert->corps);
+    curl_easy_setopt(handler, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)transfert->taille_corps);
+}
+
+
+/*!
+    \brief Sets up the handler of the transfer for POSTing a document which is produced while it is sent.
+    
+    \note The body is sent with the chunked transfer encoding, since its size is not known beforehand;
+           it can't be compressed.
+    
+    \param transfert The transfer.
+    \param entetes The shared header lists.
+    \param lecture The curl read callback producing the body.
+    \param donnees What lecture is called with.
+    \param format The format of the body (CSC_FORMAT_...); the answer is asked for in the same format.
+*/
+void transfert_diffuser(www_transfert* transfert, const www_entetes* entetes, curl_read_callback lecture, void* donnees, int format){
+    CURL* handler = transfert->handler;
+    
+    transfert->corps = NULL;
+    transfert->taille_corps = 0;
+    
+    preparer_entetes(transfert, entetes, format);
+    
+    // Without POSTFIELDS, curl asks the read callback for the body
+    curl_easy_setopt(handler, CURLOPT_POST, 1L);
+    curl_easy_setopt(handler, CURLOPT_POSTFIELDS, NULL);
+    curl_easy_setopt(handler, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)-1);
+    curl_easy_setopt(handler, CURLOPT_READFUNCTION, lecture);
+    curl_easy_setopt(handler, CURLOPT_READDATA, donnees);
+}
+
+
+/*!
+    \brief Tells whether the server answered the last request of handler in CBOR.
+    
+    \param handler The curl handle, after the request is done.
+    \return true if the answer is a CBOR document; false if it's JSON (or anything else).
+*/
+bool reponse_en_cbor(CURL* handler){
+    char* type = NULL;
+    
+    if(curl_easy_getinfo(handler, CURLINFO_CONTENT_TYPE, &type) != CURLE_OK || !type)
+        return false;
+    
+    return !strncasecmp(type, WWW_TYPE_CBOR, strlen(WWW_TYPE_CBOR));
+}
+
+
+/*!
+    \brief Ends the last request of the transfer, freeing its compressed body if any; the handler and the buffers are kept.
+    
+    \param transfert The transfer.
+*/
+void transfert_liberer(www_transfert* transfert){
+    transfert->entetes = NULL;
+    transfert->serveur = NULL;
+    if(transfert->corps != transfert->sortie.ptr)
+        free(transfert->corps);
+    transfert->corps = NULL;
+    transfert->taille_corps = 0;
+    ecriture_vider(&transfert->ecriture);
+    ecriture_vider(&transfert->sortie);
+}
+
+
+/*!
+    \brief Frees everything the transfer holds, except for its handler.
+    
+    \param transfert The transfer.
+*/
+void transfert_detruire(www_transfert* transfert){
+    transfert_liberer(transfert);
+    ecriture_liberer(&transfert->ecriture);
+    ecriture_liberer(&transfert->sortie);
+}
+
+
+/*!
+    \brief Compresses a buffer in the gzip format.
+    
+    \param src The buffer.
+    \param taille The size of the buffer.
+    \param taille_gzip Where the size of the compressed buffer is written.
+    \return The compressed buffer (to be freed), or NULL if the compression failed.
+*/
+static char* compresser_gzip(const char* src, size_t taille, size_t* taille_gzip){
+    z_stream flux;
+    char* dest = NULL;
+    size_t capacite;
+    
+    flux.zalloc = Z_NULL;
+    flux.zfree = Z_NULL;
+    flux.opaque = Z_NULL;
+    
+    // 15 + 16: maximum window, with a gzip header
+    if(deflateInit2(&flux, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return NULL;
+    
+    capacite = deflateBound(&flux, taille);
+    dest = malloc(capacite);
+    if(!dest){
+        deflateEnd(&flux);
+        return NULL;
+    }
+    
+    flux.next_in = (Bytef*)src;
+    flux.avail_in = (uInt)taille;
+    flux.next_out = (Bytef*)dest;
+    flux.avail_out = (uInt)capacite;
+    
+    if(deflate(&flux, Z_FINISH) != Z_STREAM_END){
+        deflateEnd(&flux);
+        free(dest);
+        return NULL;
+    }
+    
+    *taille_gzip = flux.total_out;
+    deflateEnd(&flux);
+    
+    return dest;
+}
+
+
+#ifdef CSC_AVEC_ZSTD
+/*!
+    \brief Compresses a buffer in the zstd format.
+    
+    \param src The buffer.
+    \param taille The size of the buffer.
+    \param taille_zstd Where the size of the compressed buffer is written.
+    \return The compressed buffer (to be freed), or NULL if the compression failed.
+*/
+static char* compresser_zstd(const char* src, size_t taille, size_t* taille_zstd){
+    size_t capacite = ZSTD_compressBound(taille);
+    char* dest = malloc(capacite);
+    
+    if(!dest)
+        return NULL;
+    
+    *taille_zstd = ZSTD_compress(dest, capacite, src, taille, 1);
+    if(ZSTD_isError(*taille_zstd)){
+        free(dest);
+        return NULL;
+    }
+    
+    return dest;
+}
+#endif
+
+
+/*!
+    \brief Tells whether cruesli was built with a compression algorithm.
+    
+    \param algo The algorithm (CSC_COMPRESSION_...).
+    \return true if it can be used.
+*/
+bool transfert_compression_supportee(int algo){
+    switch (algo) {
+        case CSC_COMPRESSION_AUCUNE:
+        case CSC_COMPRESSION_GZIP:
+            return true;
+#ifdef CSC_AVEC_ZSTD
+        case CSC_COMPRESSION_ZSTD:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+
+/*!
+    \brief Compresses the body of a prepared transfer, and advertises it in its headers.
+    
+    \param transfert The transfer, set up by transfert_preparer().
+    \param algo The algorithm (CSC_COMPRESSION_...).
+    \return true if the body was compressed; false if it's sent as is.
+*/
+bool transfert_compresser(www_transfert* transfert, int algo){
+    char* compresse = NULL;
+    size_t taille = 0;
+    
+    switch (algo) {
+        case CSC_COMPRESSION_GZIP:
+            compresse = compresser_gzip(transfert->corps, transfert->taille_corps, &taille);
+            break;
+#ifdef CSC_AVEC_ZSTD
+        case CSC_COMPRESSION_ZSTD:
+            compresse = compresser_zstd(transfert->corps, transfert->taille_corps, &taille);
+            break;
+#endif
+        default:
+            return false;
+    }
+    
+    // Incompressible: not worth it
+    if(!compresse || taille >= transfert->taille_corps){
+        free(compresse);
+        return false;
+    }
+    
+    if(transfert->corps != transfert->sortie.ptr)
+        free(transfert->corps);
+    transfert->corps = compresse;
+    transfert->taille_corps = taille;
+    
+    curl_easy_setopt(transfert->handler, CURLOPT_HTTPHEADER, transfert->entetes->listes[transfert->format][algo]);
+    curl_easy_setopt(transfert->handler, CURLOPT_POSTFIELDS, transfert->corps);
+    curl_easy_setopt(transfert->handler, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)transfert->taille_corps);
+    
+    return true;
+}
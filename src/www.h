@@ -10,13 +10,57 @@
 #define www_h
 
 #include <stdio.h>
+#include <stdbool.h>
 
+#include <curl/curl.h>
+
+#define WWW_TYPE_JSON "application/json"
+#define WWW_TYPE_CBOR "application/cbor"
+
+// A receive buffer, that is kept from one answer to the next
 struct www_writestruct {
     char* ptr;
     size_t size;
+    size_t capacite;            // Allocated size
+    size_t pic;                 // Largest answer received (high-water mark)
+    size_t agrandissements;     // Number of times the buffer had to grow
 };
 
 typedef struct www_writestruct www_writestruct;
+
+// The header lists of the requests, built once and shared by every transfer
+typedef struct www_entetes {
+    struct curl_slist* listes[2][3];    // By format (CSC_FORMAT_...), and then by content encoding (CSC_COMPRESSION_...)
+} www_entetes;
+
+// A request and everything that must outlive it while it is in flight
+struct www_transfert {
+    CURL* handler;
+    void* requete;      // Actually a csc_requete*, while in flight in the network engine
+    www_writestruct ecriture;
+    www_writestruct sortie;     // The bodies of the requests are written there, and kept from one request to the next
+    const www_entetes* entetes;
+    int format;                 // The format of the body of the last request
+    void* serveur;              // Actually a csc_serveur*: the master server the request in flight went to
+    char* corps;                // Either sortie.ptr, or a buffer owned by the transfer
+    size_t taille_corps;
+};
+
+typedef struct www_transfert www_transfert;
+
 size_t dl2string(char *ptr, size_t size, size_t nmemb, www_writestruct* writeinfo);
+bool ecriture_reserver(www_writestruct* writeinfo, size_t taille);
+void ecriture_vider(www_writestruct* writeinfo);
+void ecriture_liberer(www_writestruct* writeinfo);
+www_entetes* entetes_creer(void);
+void entetes_detruire(www_entetes* entetes);
+void transfert_initialiser(www_transfert* transfert, CURL* handler);
+void transfert_preparer(www_transfert* transfert, const www_entetes* entetes, char* corps, size_t taille, int format);
+void transfert_diffuser(www_transfert* transfert, const www_entetes* entetes, curl_read_callback lecture, void* donnees, int format);
+bool reponse_en_cbor(CURL* handler);
+void transfert_liberer(www_transfert* transfert);
+void transfert_detruire(www_transfert* transfert);
+bool transfert_compression_supportee(int algo);
+bool transfert_compresser(www_transfert* transfert, int algo);
 
 #endif /* www_h */